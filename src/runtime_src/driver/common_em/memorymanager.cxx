@@ -19,10 +19,10 @@
 namespace xclemulation {
   MemoryManager::MemoryManager(uint64_t size, uint64_t start,
       unsigned alignment) : mSize(size), mStart(start), mAlignment(alignment),
-  mCoalesceThreshold(4), mFreeSize(0)
+  mFreeSize(0)
   {
     assert(start % alignment == 0);
-    mFreeBufferList.push_back(std::make_pair(mStart, mSize));
+    insertFree(mStart, mSize);
     mFreeSize = mSize;
   }
 
@@ -31,12 +31,23 @@ namespace xclemulation {
 
   }
 
+  void MemoryManager::insertFree(uint64_t addr, uint64_t size)
+  {
+    mFreeBufferMap.insert(std::make_pair(addr, size));
+    mFreeSizeSet.insert(std::make_pair(size, addr));
+  }
+
+  void MemoryManager::eraseFree(BlockMap::iterator it)
+  {
+    mFreeSizeSet.erase(std::make_pair(it->second, it->first));
+    mFreeBufferMap.erase(it);
+  }
+
   uint64_t MemoryManager::alloc(size_t& origSize, unsigned int paddingFactor)
   {
     if (origSize == 0)
       origSize = mAlignment;
 
-    uint64_t result = mNull;
     const size_t mod_size = origSize % mAlignment;
     const size_t pad = (mod_size > 0) ? (mAlignment - mod_size) : 0;
     origSize += pad;
@@ -45,100 +56,71 @@ namespace xclemulation {
 
     std::lock_guard<std::mutex> lock(mMemManagerMutex);
 
-    for (PairList::iterator i = mFreeBufferList.begin(), e = mFreeBufferList.end(); i != e; ++i) 
-    {
-      if (i->second < size)
-        continue;
-      result = i->first;
-      if (i->second > size) 
-      {
-        // Resize the existing entry in freelist
-        i->first += size;
-        i->second -= size;
-      }
-      else 
-      {
-        // remove the exact match found
-        mFreeBufferList.erase(i);
-      }
-      mBusyBufferList.push_back(std::make_pair(result, size));
-      mFreeSize -= size;
-      break;
-    }
+    // Best fit, smallest free block that is large enough, lowest
+    // address among equal sizes
+    SizeSet::iterator fit = mFreeSizeSet.lower_bound(std::make_pair(static_cast<uint64_t>(size), static_cast<uint64_t>(0)));
+    if (fit == mFreeSizeSet.end())
+      return mNull;
+
+    uint64_t result = fit->second;
+    uint64_t blockSize = fit->first;
+    eraseFree(mFreeBufferMap.find(result));
+    if (blockSize > size)
+      insertFree(result + size, blockSize - size);
+
+    mBusyBufferMap.insert(std::make_pair(result, static_cast<uint64_t>(size)));
+    mFreeSize -= size;
     return result;
   }
 
   void MemoryManager::free(uint64_t buf)
   {
     std::lock_guard<std::mutex> lock(mMemManagerMutex);
-    PairList::iterator i = find(buf);
-    if (i == mBusyBufferList.end())
+    BlockMap::iterator i = mBusyBufferMap.find(buf);
+    if (i == mBusyBufferMap.end())
       return;
-    mFreeSize += i->second;
-    mFreeBufferList.push_back(std::make_pair(i->first, i->second));
-    mBusyBufferList.erase(i);
-    if (mFreeBufferList.size() > mCoalesceThreshold) {
-      coalesce();
-    }
-  }
 
+    uint64_t addr = i->first;
+    uint64_t size = i->second;
+    mFreeSize += size;
+    mBusyBufferMap.erase(i);
 
-  void MemoryManager::coalesce()
-  {
-    // First sort the free buffers and then attempt to coalesce the neighbors
-    mFreeBufferList.sort();
-
-    PairList::iterator curr = mFreeBufferList.begin();
-    PairList::iterator next = curr;
-    ++next;
-    PairList::iterator last = mFreeBufferList.end();
-    while (next != last) {
-      if ((curr->first + curr->second) != next->first) {
-        // Non contiguous blocks
-        curr = next;
-        ++next;
-        continue;
-      }
-      // Coalesce curr and next
-      curr->second += next->second;
-      mFreeBufferList.erase(next);
-      next = curr;
-      ++next;
+    // Coalesce with following free block
+    BlockMap::iterator next = mFreeBufferMap.lower_bound(addr);
+    if (next != mFreeBufferMap.end() && next->first == addr + size) {
+      size += next->second;
+      eraseFree(next);
     }
-  }
 
-
-  MemoryManager::PairList::iterator MemoryManager::find(uint64_t buf)
-  {
-#if GCC_VERSION >= 40800
-    PairList::iterator i = std::find_if(mBusyBufferList.begin(), mBusyBufferList.end(), [&] (const PairList::value_type& s)
-        { return s.first == buf; });
-#else
-    PairList::iterator i = mBusyBufferList.begin();
-    PairList::iterator last  = mBusyBufferList.end();
-    while(i != last) {
-      if (i->first == buf)
-        break;
-      ++i;
+    // Coalesce with preceding free block
+    BlockMap::iterator prev = mFreeBufferMap.lower_bound(addr);
+    if (prev != mFreeBufferMap.begin()) {
+      --prev;
+      if (prev->first + prev->second == addr) {
+        addr = prev->first;
+        size += prev->second;
+        eraseFree(prev);
+      }
     }
-#endif
-    return i;
+
+    insertFree(addr, size);
   }
 
   void MemoryManager::reset()
   {
     std::lock_guard<std::mutex> lock(mMemManagerMutex);
-    mFreeBufferList.clear();
-    mBusyBufferList.clear();
-    mFreeBufferList.push_back(std::make_pair(mStart, mSize));
-    mFreeSize = 0;
+    mFreeBufferMap.clear();
+    mFreeSizeSet.clear();
+    mBusyBufferMap.clear();
+    insertFree(mStart, mSize);
+    mFreeSize = mSize;
   }
 
   std::pair<uint64_t, uint64_t> MemoryManager::lookup(uint64_t buf)
   {
     std::lock_guard<std::mutex> lock(mMemManagerMutex);
-    PairList::iterator i = find(buf);
-    if (i != mBusyBufferList.end())
+    BlockMap::iterator i = mBusyBufferMap.find(buf);
+    if (i != mBusyBufferMap.end())
       return *i;
     // Compiler bug -- Some versions of GCC C++11 compiler do not
     // like mNull directly inside std::make_pair, so capture mNull
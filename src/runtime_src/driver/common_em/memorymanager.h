@@ -18,7 +18,8 @@
 #define _HWEM_MEMORY_MANAGER_H_
 
 #include <mutex>
-#include <list>
+#include <map>
+#include <set>
 #include <cassert>
 #include <algorithm>
 
@@ -27,19 +28,30 @@
 
 namespace xclemulation
 {
+    /**
+     * Device memory allocator for emulation
+     *
+     * Free blocks are kept both by address, for immediate coalescing
+     * with neighbours on free, and by (size,address), for best-fit
+     * allocation.  Busy blocks are kept by address.  All operations
+     * are O(log n) in the number of blocks.  Since the start address
+     * and all block sizes are multiples of the alignment, every block
+     * is aligned.
+     */
     class MemoryManager 
     {
+        typedef std::map<uint64_t, uint64_t> BlockMap;          // address -> size
+        typedef std::set<std::pair<uint64_t, uint64_t> > SizeSet; // (size, address)
+
         std::mutex mMemManagerMutex;
-        std::list<std::pair<uint64_t, uint64_t> > mFreeBufferList;
-        std::list<std::pair<uint64_t, uint64_t> > mBusyBufferList;
+        BlockMap mFreeBufferMap;
+        SizeSet mFreeSizeSet;
+        BlockMap mBusyBufferMap;
         uint64_t mSize;
         uint64_t mStart;
         uint64_t mAlignment;
-        const unsigned mCoalesceThreshold;
         uint64_t mFreeSize;
 
-        typedef std::list<std::pair<uint64_t, uint64_t> > PairList;
-
     public:
         static const uint64_t mNull = 0xffffffffffffffffull;
 
@@ -58,8 +70,8 @@ namespace xclemulation
         std::pair<uint64_t, uint64_t>lookup(uint64_t buf);
 
     private:
-        void coalesce();
-        PairList::iterator find(uint64_t buf);
+        void insertFree(uint64_t addr, uint64_t size);
+        void eraseFree(BlockMap::iterator it);
     };
 }
 
@@ -1120,13 +1120,13 @@ int CpuemShim::xclSyncBO(unsigned int boHandle, xclBOSyncDirection dir, size_t s
   int returnVal = -1;
   if(dir == XCL_BO_SYNC_BO_TO_DEVICE)
   {
-    void* buffer =  bo->userptr ? bo->userptr : bo->buf;
-    returnVal = xclCopyBufferHost2Device(bo->base,buffer, size,0);
+    char* buffer = static_cast<char*>(bo->userptr ? bo->userptr : bo->buf);
+    returnVal = xclCopyBufferHost2Device(bo->base,buffer+offset,size,offset);
   }
   else
   {
-    void* buffer =  bo->userptr ? bo->userptr : bo->buf;
-    returnVal = xclCopyBufferDevice2Host(buffer, bo->base, size,0);
+    char* buffer = static_cast<char*>(bo->userptr ? bo->userptr : bo->buf);
+    returnVal = xclCopyBufferDevice2Host(buffer+offset,bo->base,size,offset);
   }
   PRINTENDFUNC;
   return returnVal;
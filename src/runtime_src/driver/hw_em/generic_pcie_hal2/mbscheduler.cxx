@@ -233,6 +233,9 @@ namespace xclhwemhal2 {
       client_ctx* entry = it;
       entry->trigger++;
     }
+
+    /* wake host threads blocked in xclExecWait */
+    mParent->notifyCompletion();
   }
 
   void MBScheduler::mark_cmd_complete(xocl_cmd *xcmd)
@@ -345,12 +348,20 @@ namespace xclhwemhal2 {
     }
     if(bSchComeOutOfCond)
     {
+      pthread_mutex_lock(&mScheduler->state_lock);
       pthread_cond_signal(&mScheduler->state_cond);
+      pthread_mutex_unlock(&mScheduler->state_lock);
       return 0;
     }
     return 1;
   }
 
+  /* no new and no queued commands, called by scheduler thread only */
+  bool MBScheduler::scheduler_idle()
+  {
+    return num_pending == 0 && mScheduler->command_queue.empty();
+  }
+
   void MBScheduler::scheduler_queue_cmds()
   {
     if(pending_cmds.empty())
@@ -430,7 +441,18 @@ namespace xclhwemhal2 {
     while (!xs->stop && !xs->error)
     {
       scheduler_loop(xs);
-      usleep(10);
+
+      /* poll status registers while commands are in flight, otherwise
+         sleep until a command is added or scheduler is stopped */
+      if (!xs->pSch->scheduler_idle())
+      {
+        usleep(10);
+        continue;
+      }
+      pthread_mutex_lock(&xs->state_lock);
+      while (!xs->stop && !xs->error && xs->pSch->scheduler_idle())
+        pthread_cond_wait(&xs->state_cond,&xs->state_lock);
+      pthread_mutex_unlock(&xs->state_lock);
     }
     return NULL;
   }
@@ -3,6 +3,7 @@
 
 #include <list>
 #include <mutex>
+#include <atomic>
 #include <math.h>
 #include <stdint.h>
 #include "ert.h"
@@ -132,6 +133,7 @@ namespace xclhwemhal2 {
     xocl_cmd* get_free_xocl_cmd(void) ; 
     int add_cmd(exec_core *exec, xclemulation::drm_xocl_bo* bo) ;
     int scheduler_wait_condition() ;
+    bool scheduler_idle() ;
     void scheduler_queue_cmds();
     void scheduler_iterate_cmds();
     
@@ -154,7 +156,7 @@ namespace xclhwemhal2 {
     std::mutex pending_cmds_mutex;
     
     std::mutex m_add_cmd_mutex;
-    int num_pending;
+    std::atomic<int> num_pending;
   };
 }
 
@@ -15,16 +15,30 @@
  */
 
 #include "mem_model.h"
+#include <sys/mman.h>
 
 mem_model::~ mem_model()
 {
   serialize();
+  if (mBase)
+    munmap(mBase, mSize);
 }
 
-mem_model::mem_model(std::string deviceName):
+mem_model::mem_model(std::string deviceName, uint64_t size):
+  mBase(NULL),
+  mSize((size + PAGESIZE - 1) & ~static_cast<uint64_t>(PAGESIZE - 1)),
+  mPageState(mSize >> ADDRBITS, 0),
   mDeviceName(deviceName),
   module_name("dr_wrapper_dr_i_sdaccel_generic_pcie_0.sdaccel_generic_pcie_model.ddrx_top_tlm_model_0.axi_app_tlm_model_0")
 {
+  // Address space only, nothing is committed until pages are touched
+  void* addr = mmap(NULL, mSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (addr == MAP_FAILED)
+  {
+    std::cerr << "Out of Memory. DDR model cannot reserve " << mSize << " bytes\n";
+    exit(1);
+  }
+  mBase = static_cast<unsigned char*>(addr);
 }
 
   unsigned int mem_model::writeDevMem(uint64_t offset, const void* src, unsigned int size)
@@ -32,34 +46,9 @@ mem_model::mem_model(std::string deviceName):
 #ifdef DEBUGMSG
       cout<<endl<<module_name<<" write offset:"<<std::hex<<offset<<endl;
 #endif 
-      uint64_t written_bytes = 0;
-      uint64_t addr = offset;
-      while(written_bytes < size){
-          uint64_t src_offset = written_bytes;
-
-          unsigned char* page_ptr  = get_page(addr);
-          uint64_t       page_addr = addr & ~(-1 << ADDRBITS);
-
-          unsigned char* dest_buf_ptr = page_ptr + page_addr;
-          unsigned char* src_buf_ptr  = (unsigned char*)(src)      + src_offset;
-
-          uint64_t remaining_bytes_to_write = size - written_bytes;
-          uint64_t unaligned_bytes_in_addr = (addr & ~(-1 << ADDRBITS));
-          uint64_t bytes_upto_next_alignment = (0x1 << ADDRBITS) - unaligned_bytes_in_addr;
-
-          uint64_t buf_size = 0;
-          if(bytes_upto_next_alignment > remaining_bytes_to_write)
-          {
-              buf_size = remaining_bytes_to_write;
-          }else{
-              buf_size = bytes_upto_next_alignment;
-          }
-
-          memcpy(dest_buf_ptr,src_buf_ptr,buf_size);
-
-          written_bytes += buf_size;
-          addr += buf_size;
-      }
+      if (!load_pages(offset, size, true))
+        return 1;
+      memcpy(mBase + offset, src, size);
 #ifdef DEBUGMSG
       std::cout << endl;
       std::cout << "Write Operation size : " << size << endl;
@@ -78,33 +67,9 @@ mem_model::mem_model(std::string deviceName):
 #ifdef DEBUGMSG
 	  cout<<endl<<module_name<<" read offset:"<<std::hex<< (uint64_t)offset<<endl;
 #endif 
-	 
-	  uint64_t read_bytes = 0;
-	  uint64_t addr = offset;
-	  while(read_bytes < size){
-		  uint64_t dest_offset = read_bytes;
-
-		  unsigned char* page_ptr  = get_page(addr);
-		  uint64_t       page_addr = addr & ~(-1 << ADDRBITS);
-
-		  unsigned char* src_buf_ptr = page_ptr + page_addr;
-		  unsigned char* dest_buf_ptr  = (unsigned char*)(dest)      + dest_offset;
-
-		  uint64_t remaining_bytes_to_read = size - read_bytes;
-		  uint64_t unaligned_bytes_in_addr = (addr & ~(-1 << ADDRBITS));
-		  uint64_t bytes_upto_next_alignment = (0x1 << ADDRBITS) - unaligned_bytes_in_addr;
-
-		  uint64_t buf_size = 0;
-		  if(bytes_upto_next_alignment > remaining_bytes_to_read)
-		  {
-			  buf_size = remaining_bytes_to_read;
-		  }else{
-			  buf_size = bytes_upto_next_alignment;
-		  }
-	  memcpy(dest_buf_ptr,src_buf_ptr,buf_size);
-		  read_bytes += buf_size;
-		  addr += buf_size;
-	  }
+	  if (!load_pages(offset, size, false))
+	    return 1;
+	  memcpy(dest, mBase + offset, size);
 #ifdef DEBUGMSG
 	  std::cout << endl;
 	  std::cout << "Read Operation size : " << size << endl;
@@ -118,45 +83,57 @@ mem_model::mem_model(std::string deviceName):
 
 	  return 0;
   }
-  unsigned char* mem_model::get_page(uint64_t offset) {
-	  uint64_t page_idx = offset >> ADDRBITS;
-	  std::string file_name = get_mem_file_name(page_idx);
-	  if(pageCache.size() > N_1MBARRAYS)
-	  {
-		  std::cerr << "Out of Memory. DDR model does not support this much of memory\n";
-		  exit(1);
-	  } else {
-      FILE* pFile = NULL;
-		  if(pageCache.find(page_idx) != pageCache.end())
-		  {
-			  return pageCache[page_idx];
-		  } else if(((pFile = fopen(file_name.c_str(),"r")) != NULL)) {
-			  int fhandle = fileno(pFile);
-
-			  if (deserialize_msg.ParseFromFileDescriptor(fhandle) == false)
-        {
-          fclose(pFile);
-          exit(1);
-        }
-			  pageCache[page_idx] = new unsigned char[PAGESIZE];
 
-			  memcpy(pageCache[page_idx],deserialize_msg.data().c_str(),PAGESIZE);
-			  fclose(pFile);
-			  return pageCache[page_idx];
-		  } else {
-			  pageCache[page_idx] = new unsigned char[PAGESIZE];
-			  return pageCache[page_idx];
-		  }
-	  }
+  // Make pages covering [offset,offset+size) resident, mark them dirty
+  // if written.  Returns false if range is outside device memory.
+  bool mem_model::load_pages(uint64_t offset, uint64_t size, bool write)
+  {
+    if (!size)
+      return true;
+    if (offset >= mSize || size > mSize - offset)
+    {
+      std::cerr << "ERROR: DDR model access at " << std::hex << offset << " of " << std::dec << size
+                << " bytes is outside device memory\n";
+      return false;
+    }
+    uint64_t last = (offset + size - 1) >> ADDRBITS;
+    for (uint64_t page_idx = offset >> ADDRBITS; page_idx <= last; ++page_idx)
+    {
+      if (!(mPageState[page_idx] & PAGE_LOADED))
+        load_page(page_idx);
+      if (write)
+        mPageState[page_idx] |= PAGE_DIRTY;
+    }
+    return true;
   }
 
+  void mem_model::load_page(uint64_t pageIdx)
+  {
+    mPageState[pageIdx] |= PAGE_LOADED;
+    std::string file_name = get_mem_file_name(pageIdx);
+    FILE* pFile = fopen(file_name.c_str(),"r");
+    if (!pFile)
+      return; // zero page
+
+    int fhandle = fileno(pFile);
+    if (deserialize_msg.ParseFromFileDescriptor(fhandle) == false)
+    {
+      fclose(pFile);
+      exit(1);
+    }
+    size_t bytes = std::min(deserialize_msg.data().size(), static_cast<size_t>(PAGESIZE));
+    memcpy(mBase + (pageIdx << ADDRBITS), deserialize_msg.data().c_str(), bytes);
+    fclose(pFile);
+  }
 
   void mem_model::serialize() {
      FILE *pFile;
      int fhandle;
-     for (pageCacheItr=pageCache.begin(); pageCacheItr != pageCache.end(); ++pageCacheItr)
+     for (uint64_t page_idx = 0; page_idx < mPageState.size(); ++page_idx)
      {
-        std::string file_name = get_mem_file_name(pageCacheItr->first);
+        if (!(mPageState[page_idx] & PAGE_DIRTY))
+          continue;
+        std::string file_name = get_mem_file_name(page_idx);
         pFile = fopen(file_name.c_str(),"w+");
         if(!pFile)
           continue;
@@ -167,7 +144,7 @@ mem_model::mem_model(std::string deviceName):
           exit(1);
         }
 
-        serialize_msg.set_data(reinterpret_cast<const char*>(pageCacheItr->second),PAGESIZE);
+        serialize_msg.set_data(reinterpret_cast<const char*>(mBase + (page_idx << ADDRBITS)),PAGESIZE);
         if(serialize_msg.SerializeToFileDescriptor(fhandle) == false)
         {
           fclose(pFile);
@@ -177,9 +154,11 @@ mem_model::mem_model(std::string deviceName):
      }
   }
 
- std::string mem_model::get_mem_file_name(uint64_t pageIdx)
+ std::string mem_model::get_mem_file_path()
  {
-   std::string file_name("");
+   if (!mFilePath.empty())
+     return mFilePath;
+
    std::string user("");
    if(getenv("USER") != NULL)
    {
@@ -198,11 +177,15 @@ mem_model::mem_model(std::string deviceName):
      int rV = system(mkdirCommand.str().c_str());
      if(rV == -1) {std::cout<<"unable to open/create mem file"<<std::endl;}
    }
-    file_name = file_path + module_name + "_" + std::to_string(pageIdx);
+   mFilePath = file_path;
+   return mFilePath;
+ }
+
+ std::string mem_model::get_mem_file_name(uint64_t pageIdx)
+ {
+    std::string file_name = get_mem_file_path() + module_name + "_" + std::to_string(pageIdx);
 #ifdef DEBUGMSG
       cout<<"ddr fmodel file_name: "<< file_name<<endl;
 #endif
     return file_name;
  }
-
-
@@ -22,7 +22,7 @@
 #include <string.h> // memcpy
 #include <sstream> // memcpy
 #include <stdlib.h> //realloc
-#include <map> //realloc
+#include <vector>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -33,8 +33,17 @@
 #define ONE_MB (ONE_KB * ONE_KB)
 #define PAGESIZE (ONE_MB)
 #define ADDRBITS (20)
-#define N_1MBARRAYS 4096
 
+/*
+ * Device memory used before the simulator is started.
+ *
+ * The entire device address space is one sparse anonymous mapping, the
+ * OS provides zero pages lazily as they are touched, and a transfer is
+ * a single memcpy.  Pages persisted by an earlier run are loaded on
+ * first access.  Only pages written through this model are persisted
+ * when it is destroyed, in the page file format read by the simulator
+ * DDR model.
+ */
 class mem_model{
 public:
 unsigned int writeDevMem(uint64_t offset, const void* src, unsigned int size);
@@ -42,10 +51,17 @@ unsigned int readDevMem(uint64_t offset, void* dest, unsigned int size);
 
 protected:
 private:
-  unsigned char* get_page(uint64_t offset);
+  enum page_state : unsigned char { PAGE_LOADED = 0x1, PAGE_DIRTY = 0x2 };
+
+  bool load_pages(uint64_t offset, uint64_t size, bool write);
+  void load_page(uint64_t pageIdx);
+  std::string get_mem_file_path();
   std::string get_mem_file_name(uint64_t pageIdx);
-  std::map<uint64_t,unsigned char*> pageCache;
-  std::map<uint64_t,unsigned char*>::iterator pageCacheItr;
+
+  unsigned char* mBase;
+  uint64_t mSize;
+  std::vector<unsigned char> mPageState;
+  std::string mFilePath;
 
   ddr_mem_msg serialize_msg;
   ddr_mem_msg deserialize_msg;
@@ -53,10 +69,8 @@ private:
   std::string mDeviceName;
   std::string module_name;
 public:
-  mem_model(std::string deviceName);
+  mem_model(std::string deviceName, uint64_t size);
   ~ mem_model();
 };
 
 #endif
-
-
@@ -845,7 +845,7 @@ uint32_t HwEmShim::getAddressSpace (uint32_t topology)
     if(!sock)
     {
       if(!mMemModel)
-        mMemModel = new mem_model(deviceName);
+        mMemModel = new mem_model(deviceName,getDDRSize());
       mMemModel->writeDevMem(dest,src,size);
       return size;
     }
@@ -891,7 +891,7 @@ uint32_t HwEmShim::getAddressSpace (uint32_t topology)
     if(!sock)
     {
       if(!mMemModel)
-        mMemModel = new mem_model(deviceName);
+        mMemModel = new mem_model(deviceName,getDDRSize());
       mMemModel->readDevMem(src,dest,size);
       return size;
     }
@@ -1313,6 +1313,14 @@ uint32_t HwEmShim::getAddressSpace (uint32_t topology)
     }
   }
 
+  uint64_t HwEmShim::getDDRSize() const
+  {
+    uint64_t size = 0;
+    for (auto& bank : mDdrBanks)
+      size += bank.ddrSize;
+    return size;
+  }
+
   void HwEmShim::initMemoryManager(std::list<xclemulation::DDRBank>& DDRBankList)
   {
     std::list<xclemulation::DDRBank>::iterator start = DDRBankList.begin();
@@ -1397,6 +1405,8 @@ uint32_t HwEmShim::getAddressSpace (uint32_t topology)
     bXPR = _xpr;
     mCore = NULL;
     mMBSch = NULL;
+    mCompletions = 0;
+    mSeenCompletions = 0;
     mIsDebugIpLayoutRead = false;
     mIsDeviceProfiling = false;
     mMemoryProfilingNumberSlots = 0;
@@ -1909,17 +1919,21 @@ int HwEmShim::xclExecWait(int timeoutMilliSec)
  //   mLogStream << __func__ << ", " << std::this_thread::get_id() << ", " << timeoutMilliSec << std::endl;
   }
 
-  unsigned int tSec = 0;
-  static bool bConfig = true;
-  tSec = timeoutMilliSec/1000;
-  if(bConfig)
-  {
-    tSec = timeoutMilliSec/100;
-    bConfig = false;
-  }
-  sleep(tSec);
+  // Wait for any command to complete since last call, returns 0 on
+  // timeout like poll() on the exec buffer fd of the xocl driver
+  std::unique_lock<std::mutex> lk(mCompletionMtx);
+  bool completed = mCompletionCond.wait_for(lk,std::chrono::milliseconds(timeoutMilliSec),
+      [this] { return mCompletions != mSeenCompletions; });
+  mSeenCompletions = mCompletions;
   //PRINTENDFUNC;
-  return 1;
+  return completed ? 1 : 0;
+}
+
+void HwEmShim::notifyCompletion()
+{
+  std::lock_guard<std::mutex> lk(mCompletionMtx);
+  ++mCompletions;
+  mCompletionCond.notify_all();
 }
 
 /**********************************************HAL2 API's END HERE **********************************************/
@@ -36,6 +36,7 @@
 #include <sys/param.h>
 #include <sys/wait.h>
 #include <thread>
+#include <condition_variable>
 #include <signal.h>
 #ifdef _WINDOWS
 #define strtoll _strtoi64
@@ -92,6 +93,7 @@ using addr_type = uint64_t;
       int xclExecBuf( unsigned int cmdBO);
       int xclRegisterEventNotify( unsigned int userInterrupt, int fd);
       int xclExecWait( int timeoutMilliSec);
+      void notifyCompletion();
       struct exec_core* getExecCore() { return mCore; }
       MBScheduler* getScheduler() { return mMBSch; }
 
@@ -194,6 +196,7 @@ using addr_type = uint64_t;
       void launchTempProcess() {};
 
       void initMemoryManager(std::list<xclemulation::DDRBank>& DDRBankList);
+      uint64_t getDDRSize() const;
       std::vector<xclemulation::MemoryManager *> mDDRMemoryManager;
       std::list<xclemulation::DDRBank> mDdrBanks;
       std::map<uint64_t,std::map<uint64_t, KernelArg>> mKernelOffsetArgsInfoMap;
@@ -242,6 +245,14 @@ using addr_type = uint64_t;
       // HAL2 RELATED member variables end 
       exec_core* mCore;
       MBScheduler* mMBSch;
+
+      // Command completion notification from MBScheduler to
+      // xclExecWait.  Kept in the shim since the scheduler is
+      // recreated per program while waiters may be blocked.
+      std::mutex mCompletionMtx;
+      std::condition_variable mCompletionCond;
+      uint64_t mCompletions;
+      uint64_t mSeenCompletions;
       
       // Information extracted from platform linker (for profile/debug)
       bool mIsDebugIpLayoutRead = false;
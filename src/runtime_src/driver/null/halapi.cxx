@@ -0,0 +1,198 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "shim.h"
+
+#include <map>
+#include <mutex>
+
+namespace {
+
+using xclnullhal2::NullShim;
+
+std::mutex devices_mutex;
+std::map<unsigned, NullShim*> devices;
+
+}
+
+unsigned xclProbe()
+{
+  return NullShim::probe();
+}
+
+unsigned int xclVersion()
+{
+  return 2;
+}
+
+xclDeviceHandle xclOpen(unsigned deviceIndex, const char *logfileName, xclVerbosityLevel level)
+{
+  if (deviceIndex >= NullShim::probe())
+    return nullptr;
+
+  std::lock_guard<std::mutex> lk(devices_mutex);
+  auto& drv = devices[deviceIndex];
+  if (!drv)
+    drv = new NullShim(deviceIndex);
+  return drv;
+}
+
+void xclClose(xclDeviceHandle handle)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  if (!drv)
+    return;
+
+  std::lock_guard<std::mutex> lk(devices_mutex);
+  for (auto itr = devices.begin(); itr != devices.end(); ++itr) {
+    if (itr->second == drv) {
+      devices.erase(itr);
+      break;
+    }
+  }
+  delete drv;
+}
+
+int xclGetDeviceInfo2(xclDeviceHandle handle, xclDeviceInfo2 *info)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  return drv ? drv->xclGetDeviceInfo2(info) : -ENODEV;
+}
+
+int xclGetUsageInfo(xclDeviceHandle handle, xclDeviceUsage *info)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  return drv ? drv->xclGetUsageInfo(info) : -ENODEV;
+}
+
+int xclLoadXclBin(xclDeviceHandle handle, const xclBin *buffer)
+{
+  // Nothing to program; CUs are described to the scheduler by the runtime
+  return NullShim::handleCheck(handle) ? 0 : -ENODEV;
+}
+
+int xclLockDevice(xclDeviceHandle handle)
+{
+  return NullShim::handleCheck(handle) ? 0 : -ENODEV;
+}
+
+int xclUnlockDevice(xclDeviceHandle handle)
+{
+  return NullShim::handleCheck(handle) ? 0 : -ENODEV;
+}
+
+unsigned int xclAllocBO(xclDeviceHandle handle, size_t size, xclBOKind domain, unsigned flags)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  return drv ? drv->xclAllocBO(size, domain, flags) : -ENODEV;
+}
+
+unsigned int xclAllocUserPtrBO(xclDeviceHandle handle, void *userptr, size_t size, unsigned flags)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  return drv ? drv->xclAllocUserPtrBO(userptr, size, flags) : -ENODEV;
+}
+
+void xclFreeBO(xclDeviceHandle handle, unsigned int boHandle)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  if (drv)
+    drv->xclFreeBO(boHandle);
+}
+
+size_t xclWriteBO(xclDeviceHandle handle, unsigned int boHandle, const void *src, size_t size, size_t seek)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  return drv ? drv->xclWriteBO(boHandle, src, size, seek) : -ENODEV;
+}
+
+size_t xclReadBO(xclDeviceHandle handle, unsigned int boHandle, void *dst, size_t size, size_t skip)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  return drv ? drv->xclReadBO(boHandle, dst, size, skip) : -ENODEV;
+}
+
+void *xclMapBO(xclDeviceHandle handle, unsigned int boHandle, bool write)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  return drv ? drv->xclMapBO(boHandle, write) : nullptr;
+}
+
+int xclSyncBO(xclDeviceHandle handle, unsigned int boHandle, xclBOSyncDirection dir, size_t size, size_t offset)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  return drv ? drv->xclSyncBO(boHandle, dir, size, offset) : -ENODEV;
+}
+
+int xclCopyBO(xclDeviceHandle handle, unsigned int dst_boHandle, unsigned int src_boHandle, size_t size,
+              size_t dst_offset, size_t src_offset)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  return drv ? drv->xclCopyBO(dst_boHandle, src_boHandle, size, dst_offset, src_offset) : -ENODEV;
+}
+
+int xclGetBOProperties(xclDeviceHandle handle, unsigned int boHandle, xclBOProperties *properties)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  return drv ? drv->xclGetBOProperties(boHandle, properties) : -ENODEV;
+}
+
+size_t xclWrite(xclDeviceHandle handle, xclAddressSpace space, uint64_t offset, const void *hostBuf, size_t size)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  return drv ? drv->xclWrite(space, offset, hostBuf, size) : -ENODEV;
+}
+
+size_t xclRead(xclDeviceHandle handle, xclAddressSpace space, uint64_t offset, void *hostBuf, size_t size)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  return drv ? drv->xclRead(space, offset, hostBuf, size) : -ENODEV;
+}
+
+int xclExecBuf(xclDeviceHandle handle, unsigned int cmdBO)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  return drv ? drv->xclExecBuf(cmdBO) : -ENODEV;
+}
+
+int xclExecWait(xclDeviceHandle handle, int timeoutMilliSec)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  return drv ? drv->xclExecWait(timeoutMilliSec) : -ENODEV;
+}
+
+size_t xclGetDeviceTimestamp(xclDeviceHandle handle)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  return drv ? drv->xclGetDeviceTimestamp() : 0;
+}
+
+double xclGetDeviceClockFreqMHz(xclDeviceHandle handle)
+{
+  return 300.0;
+}
+
+double xclGetReadMaxBandwidthMBps(xclDeviceHandle handle)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  return drv ? drv->xclGetReadMaxBandwidthMBps() : 0.0;
+}
+
+double xclGetWriteMaxBandwidthMBps(xclDeviceHandle handle)
+{
+  NullShim *drv = NullShim::handleCheck(handle);
+  return drv ? drv->xclGetWriteMaxBandwidthMBps() : 0.0;
+}
@@ -0,0 +1,465 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "shim.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/mman.h>
+
+namespace {
+
+const size_t NULL_ALIGNMENT = 4096;
+
+// Bytes of host memory backing a buffer object of size bytes
+static size_t
+mapped_size(size_t size)
+{
+  return (std::max<size_t>(size,1) + NULL_ALIGNMENT - 1) & ~(NULL_ALIGNMENT - 1);
+}
+const size_t NULL_DDR_SIZE = 0x400000000; // 16 GB
+const unsigned NULL_MAX_CUS = 128;
+
+static unsigned long
+envOrDefault(const char* name, unsigned long value)
+{
+  const char* str = std::getenv(name);
+  return str ? std::strtoul(str,nullptr,0) : value;
+}
+
+}
+
+namespace xclnullhal2 {
+
+const unsigned NullShim::TAG = 0x4e554c4c; // "NULL"
+const unsigned NullShim::CONTROL_AP_START = 1;
+const unsigned NullShim::CONTROL_AP_DONE = 2;
+const unsigned NullShim::CONTROL_AP_IDLE = 4;
+
+unsigned
+NullShim::
+probe()
+{
+  return envOrDefault("XCL_NULL_DEVICE_COUNT",1);
+}
+
+NullShim*
+NullShim::
+handleCheck(void* handle)
+{
+  if (!handle)
+    return nullptr;
+  if (*(unsigned*)handle != TAG)
+    return nullptr;
+  return (NullShim*)handle;
+}
+
+NullShim::
+NullShim(unsigned index)
+  : mTag(TAG), mIndex(index), mOpenTime(clock::now())
+  , mCuLatency(std::chrono::microseconds(envOrDefault("XCL_NULL_CU_LATENCY_US",0)))
+  , mDmaMBps(envOrDefault("XCL_NULL_DMA_MBPS",0))
+  , mNextBO(1), mNextAddr(0)
+  , mMemLimit(envOrDefault("XCL_NULL_MEM_MB",0) << 20), mMemUsed(0)
+  , mCuShift(12), mCuBase(0)
+  , mCuFree(NULL_MAX_CUS)
+  , mCompletions(0), mSeenCompletions(0), mStop(false)
+{
+  mDmaFree[0] = mDmaFree[1] = mOpenTime;
+  mCompletionThread = std::thread(&NullShim::completionLoop,this);
+}
+
+NullShim::
+~NullShim()
+{
+  {
+    std::lock_guard<std::mutex> lk(mCompletionMtx);
+    mStop = true;
+    mCompletionCond.notify_all();
+  }
+  mCompletionThread.join();
+
+  for (auto& bo : mBOs)
+    if (!bo.second.userptr)
+      munmap(bo.second.buf,mapped_size(bo.second.size));
+}
+
+NullShim::buffer_object*
+NullShim::
+getBO(unsigned int boHandle)
+{
+  std::lock_guard<std::mutex> lk(mBOMtx);
+  auto itr = mBOs.find(boHandle);
+  return itr == mBOs.end() ? nullptr : &itr->second;
+}
+
+unsigned int
+NullShim::
+xclAllocBO(size_t size, xclBOKind domain, unsigned flags)
+{
+  std::lock_guard<std::mutex> lk(mBOMtx);
+  if (mMemLimit && mMemUsed + size > mMemLimit)
+    return 0xffffffff;
+
+  // Shared mapping so that xclMapBO can hand out separate views of the
+  // buffer object that the caller unmaps, as with a real driver
+  void* buf = mmap(nullptr,mapped_size(size),PROT_READ|PROT_WRITE,MAP_SHARED|MAP_ANONYMOUS,-1,0);
+  if (buf == MAP_FAILED)
+    return 0xffffffff;
+
+  mMemUsed += size;
+  buffer_object bo = {static_cast<char*>(buf),size,flags,mNextAddr,false};
+  mNextAddr += (size + NULL_ALIGNMENT - 1) & ~(NULL_ALIGNMENT - 1);
+  mBOs.emplace(mNextBO,bo);
+  return mNextBO++;
+}
+
+unsigned int
+NullShim::
+xclAllocUserPtrBO(void* userptr, size_t size, unsigned flags)
+{
+  std::lock_guard<std::mutex> lk(mBOMtx);
+  buffer_object bo = {static_cast<char*>(userptr),size,flags,mNextAddr,true};
+  mNextAddr += (size + NULL_ALIGNMENT - 1) & ~(NULL_ALIGNMENT - 1);
+  mBOs.emplace(mNextBO,bo);
+  return mNextBO++;
+}
+
+void
+NullShim::
+xclFreeBO(unsigned int boHandle)
+{
+  std::lock_guard<std::mutex> lk(mBOMtx);
+  auto itr = mBOs.find(boHandle);
+  if (itr == mBOs.end())
+    return;
+  if (!itr->second.userptr) {
+    munmap(itr->second.buf,mapped_size(itr->second.size));
+    mMemUsed -= itr->second.size;
+  }
+  mBOs.erase(itr);
+}
+
+size_t
+NullShim::
+xclWriteBO(unsigned int boHandle, const void* src, size_t size, size_t seek)
+{
+  auto bo = getBO(boHandle);
+  if (!bo || seek + size > bo->size)
+    return -1;
+  std::memcpy(bo->buf + seek,src,size);
+  return 0;
+}
+
+size_t
+NullShim::
+xclReadBO(unsigned int boHandle, void* dst, size_t size, size_t skip)
+{
+  auto bo = getBO(boHandle);
+  if (!bo || skip + size > bo->size)
+    return -1;
+  std::memcpy(dst,bo->buf + skip,size);
+  return 0;
+}
+
+void*
+NullShim::
+xclMapBO(unsigned int boHandle, bool write)
+{
+  auto bo = getBO(boHandle);
+  if (!bo)
+    return nullptr;
+  if (bo->userptr)
+    return bo->buf;
+
+  // New view of the buffer object pages, unmapped by the caller
+  auto addr = mremap(bo->buf,0,mapped_size(bo->size),MREMAP_MAYMOVE);
+  return addr == MAP_FAILED ? nullptr : addr;
+}
+
+int
+NullShim::
+xclSyncBO(unsigned int boHandle, xclBOSyncDirection dir, size_t size, size_t offset)
+{
+  auto bo = getBO(boHandle);
+  if (!bo || offset + size > bo->size)
+    return -EINVAL;
+  dma(dir,size);
+  return 0;
+}
+
+int
+NullShim::
+xclCopyBO(unsigned int dst, unsigned int src, size_t size, size_t dst_offset, size_t src_offset)
+{
+  auto dbo = getBO(dst);
+  auto sbo = getBO(src);
+  if (!dbo || !sbo || dst_offset + size > dbo->size || src_offset + size > sbo->size)
+    return -EINVAL;
+  std::memmove(dbo->buf + dst_offset,sbo->buf + src_offset,size);
+  return 0;
+}
+
+int
+NullShim::
+xclGetBOProperties(unsigned int boHandle, xclBOProperties* properties)
+{
+  auto bo = getBO(boHandle);
+  if (!bo)
+    return -EINVAL;
+  properties->handle = boHandle;
+  properties->flags = bo->flags;
+  properties->size = bo->size;
+  properties->paddr = bo->paddr;
+  properties->domain = XCL_BO_DEVICE_RAM;
+  return 0;
+}
+
+// Transfers in one direction are serialized on one DMA engine; the
+// caller returns when its transfer would have finished
+void
+NullShim::
+dma(xclBOSyncDirection dir, size_t size)
+{
+  if (!mDmaMBps)
+    return;
+
+  auto duration = std::chrono::duration_cast<clock::duration>
+    (std::chrono::duration<double,std::micro>(size / mDmaMBps));
+  clock::time_point done;
+  {
+    std::lock_guard<std::mutex> lk(mDmaMtx);
+    auto& engine = mDmaFree[dir == XCL_BO_SYNC_BO_TO_DEVICE ? 0 : 1];
+    engine = std::max(engine,clock::now()) + duration;
+    done = engine;
+  }
+  std::this_thread::sleep_until(done);
+}
+
+size_t
+NullShim::
+xclWrite(xclAddressSpace space, uint64_t offset, const void* hostBuf, size_t size)
+{
+  auto words = static_cast<const uint32_t*>(hostBuf);
+  std::lock_guard<std::mutex> lk(mRegMtx);
+  for (size_t i = 0; i < size / 4; ++i)
+    mRegs[offset + i * 4] = words[i];
+
+  // AP_START in a control register starts the CU at that address,
+  // argument registers can hold any value
+  if (size >= 4 && (words[0] & CONTROL_AP_START) && isControlRegister(offset)) {
+    auto& done = mCuDone[offset];
+    done = std::max(done,clock::now()) + mCuLatency;
+    schedule({done,nullptr});
+  }
+  return size;
+}
+
+size_t
+NullShim::
+xclRead(xclAddressSpace space, uint64_t offset, void* hostBuf, size_t size)
+{
+  auto words = static_cast<uint32_t*>(hostBuf);
+  std::lock_guard<std::mutex> lk(mRegMtx);
+  for (size_t i = 0; i < size / 4; ++i) {
+    auto addr = offset + i * 4;
+    auto done = mCuDone.find(addr);
+    if (done != mCuDone.end()) {
+      // AP_DONE is clear on read
+      if (done->second > clock::now()) {
+        words[i] = CONTROL_AP_START;
+        continue;
+      }
+      mCuDone.erase(done);
+      mRegs[addr] = CONTROL_AP_IDLE;
+      words[i] = CONTROL_AP_DONE | CONTROL_AP_IDLE;
+      continue;
+    }
+    auto reg = mRegs.find(addr);
+    words[i] = reg == mRegs.end() ? 0 : reg->second;
+  }
+  return size;
+}
+
+// First word of a CU address range, called with mRegMtx held
+bool
+NullShim::
+isControlRegister(uint64_t offset) const
+{
+  return offset >= mCuBase && ((offset - mCuBase) & ((1ull << mCuShift) - 1)) == 0;
+}
+
+// Run a command on the CU of its masks that becomes free first
+NullShim::clock::time_point
+NullShim::
+startCU(uint32_t cu_mask[], unsigned masks)
+{
+  std::lock_guard<std::mutex> lk(mRegMtx);
+  auto now = clock::now();
+  clock::time_point* cu = nullptr;
+  for (unsigned m = 0; m < masks; ++m)
+    for (unsigned bit = 0; bit < 32; ++bit)
+      if ((cu_mask[m] & (1u << bit)) && (!cu || mCuFree[m * 32 + bit] < *cu))
+        cu = &mCuFree[m * 32 + bit];
+
+  if (!cu)
+    return now;
+  *cu = std::max(*cu,now) + mCuLatency;
+  return *cu;
+}
+
+int
+NullShim::
+xclExecBuf(unsigned int cmdBO)
+{
+  auto bo = getBO(cmdBO);
+  if (!bo)
+    return -EINVAL;
+
+  auto cmd = reinterpret_cast<ert_packet*>(bo->buf);
+  auto when = clock::now();
+  if (cmd->opcode == ERT_START_CU) {
+    auto skcmd = reinterpret_cast<ert_start_kernel_cmd*>(cmd);
+    when = startCU(&skcmd->cu_mask,1 + skcmd->extra_cu_masks);
+  }
+  else if (cmd->opcode == ERT_CONFIGURE) {
+    auto cfg = reinterpret_cast<ert_configure_cmd*>(cmd);
+    std::lock_guard<std::mutex> lk(mRegMtx);
+    mCuShift = cfg->cu_shift;
+    mCuBase = cfg->cu_base_addr;
+  }
+
+  cmd->state = ERT_CMD_STATE_RUNNING;
+  schedule({when,cmd});
+  return 0;
+}
+
+int
+NullShim::
+xclExecWait(int timeoutMilliSec)
+{
+  // Wait for any command to complete since last call, returns 0 on
+  // timeout like poll() on the exec buffer fd of the xocl driver
+  std::unique_lock<std::mutex> lk(mCompletionMtx);
+  bool completed = mCompletionCond.wait_for(lk,std::chrono::milliseconds(timeoutMilliSec),
+      [this] { return mCompletions != mSeenCompletions; });
+  mSeenCompletions = mCompletions;
+  return completed ? 1 : 0;
+}
+
+void
+NullShim::
+schedule(const completion& c)
+{
+  std::lock_guard<std::mutex> lk(mCompletionMtx);
+  mPending.push(c);
+  mCompletionCond.notify_all();
+}
+
+void
+NullShim::
+completionLoop()
+{
+  std::unique_lock<std::mutex> lk(mCompletionMtx);
+  while (!mStop) {
+    if (mPending.empty()) {
+      mCompletionCond.wait(lk);
+      continue;
+    }
+
+    auto when = mPending.top().when;
+    if (clock::now() < when) {
+      mCompletionCond.wait_until(lk,when);
+      continue;
+    }
+
+    while (!mPending.empty() && mPending.top().when <= clock::now()) {
+      if (auto cmd = mPending.top().cmd)
+        cmd->state = ERT_CMD_STATE_COMPLETED;
+      mPending.pop();
+      ++mCompletions;
+    }
+    mCompletionCond.notify_all();
+  }
+}
+
+int
+NullShim::
+xclGetDeviceInfo2(xclDeviceInfo2* info)
+{
+  std::memset(info,0,sizeof(xclDeviceInfo2));
+  info->mMagic = 0X586C0C6C;
+  std::strcpy(info->mName,"xilinx:null:1.0");
+  info->mHALMajorVersion = XCLHAL_MAJOR_VER;
+  info->mHALMinorVersion = XCLHAL_MINOR_VER;
+  info->mVendorId = 0x10ee;
+  info->mDeviceId = mIndex;
+  info->mDDRSize = NULL_DDR_SIZE;
+  info->mDataAlignment = NULL_ALIGNMENT;
+  info->mDDRFreeSize = NULL_DDR_SIZE - mNextAddr;
+  info->mMinTransferSize = 0;
+  info->mDDRBankCount = 1;
+  for (unsigned i = 0; i < 4; ++i)
+    info->mOCLFrequency[i] = 300;
+  info->mNumClocks = 2;
+  return 0;
+}
+
+// Bytes and buffer objects allocated per memory bank, the bank is the
+// memory index in the allocation flags with any bank counted as bank 0
+int
+NullShim::
+xclGetUsageInfo(xclDeviceUsage* info)
+{
+  std::memset(info,0,sizeof(xclDeviceUsage));
+  info->totalContexts = 1;
+  info->memSize[0] = NULL_DDR_SIZE;
+
+  std::lock_guard<std::mutex> lk(mBOMtx);
+  for (auto& bo : mBOs) {
+    auto bank = bo.second.flags & 0xffffff;
+    if (bank >= 8)
+      bank = 0;
+    info->ddrMemUsed[bank] += bo.second.size;
+    ++info->ddrBOAllocated[bank];
+  }
+  return 0;
+}
+
+double
+NullShim::
+xclGetReadMaxBandwidthMBps() const
+{
+  return mDmaMBps;
+}
+
+double
+NullShim::
+xclGetWriteMaxBandwidthMBps() const
+{
+  return mDmaMBps;
+}
+
+size_t
+NullShim::
+xclGetDeviceTimestamp() const
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - mOpenTime).count();
+}
+
+} // xclnullhal2
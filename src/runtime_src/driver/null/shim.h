@@ -0,0 +1,148 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _NULL_SHIM_H_
+#define _NULL_SHIM_H_
+
+#include "xclhal2.h"
+#include "ert.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Null device HAL driver
+ *
+ * A device without hardware for measuring the host side overhead of the
+ * runtime.  Buffer objects live in host memory, DMA takes size/bandwidth
+ * per direction and a CU started through xclExecBuf or by writing
+ * AP_START to its control register completes after a fixed latency.
+ * The control register is the first word of the CU address range,
+ * 4KB unless an ERT configure command gives the CU shift and base.
+ *
+ * The model is configured through the environment:
+ *   XCL_NULL_DEVICE_COUNT   number of devices reported by xclProbe (1)
+ *   XCL_NULL_CU_LATENCY_US  CU execution time in microseconds (0)
+ *   XCL_NULL_DMA_MBPS       DMA bandwidth per direction, 0 is unlimited (0)
+ *   XCL_NULL_MEM_MB         device memory for buffer objects, 0 is unlimited (0)
+ */
+namespace xclnullhal2 {
+
+class NullShim
+{
+public:
+  static const unsigned TAG;
+  static const unsigned CONTROL_AP_START;
+  static const unsigned CONTROL_AP_DONE;
+  static const unsigned CONTROL_AP_IDLE;
+
+  using clock = std::chrono::steady_clock;
+
+  static unsigned probe();
+  static NullShim* handleCheck(void* handle);
+
+  explicit NullShim(unsigned index);
+  ~NullShim();
+
+  // HAL2 buffer object API
+  unsigned int xclAllocBO(size_t size, xclBOKind domain, unsigned flags);
+  unsigned int xclAllocUserPtrBO(void* userptr, size_t size, unsigned flags);
+  void xclFreeBO(unsigned int boHandle);
+  size_t xclWriteBO(unsigned int boHandle, const void* src, size_t size, size_t seek);
+  size_t xclReadBO(unsigned int boHandle, void* dst, size_t size, size_t skip);
+  void* xclMapBO(unsigned int boHandle, bool write);
+  int xclSyncBO(unsigned int boHandle, xclBOSyncDirection dir, size_t size, size_t offset);
+  int xclCopyBO(unsigned int dst, unsigned int src, size_t size, size_t dst_offset, size_t src_offset);
+  int xclGetBOProperties(unsigned int boHandle, xclBOProperties* properties);
+
+  // Register and execution API
+  size_t xclWrite(xclAddressSpace space, uint64_t offset, const void* hostBuf, size_t size);
+  size_t xclRead(xclAddressSpace space, uint64_t offset, void* hostBuf, size_t size);
+  int xclExecBuf(unsigned int cmdBO);
+  int xclExecWait(int timeoutMilliSec);
+
+  int xclGetDeviceInfo2(xclDeviceInfo2* info);
+  int xclGetUsageInfo(xclDeviceUsage* info);
+  double xclGetReadMaxBandwidthMBps() const;
+  double xclGetWriteMaxBandwidthMBps() const;
+  size_t xclGetDeviceTimestamp() const;
+
+private:
+  struct buffer_object
+  {
+    char* buf;
+    size_t size;
+    unsigned flags;
+    uint64_t paddr;
+    bool userptr;
+  };
+
+  // Completion of a CU at a point in time; cmd is the packet to mark
+  // complete, or nullptr for a CU started through its registers
+  struct completion
+  {
+    clock::time_point when;
+    ert_packet* cmd;
+    bool operator<(const completion& rhs) const { return when > rhs.when; }
+  };
+
+  buffer_object* getBO(unsigned int boHandle);
+  clock::time_point startCU(uint32_t cu_mask[], unsigned masks);
+  bool isControlRegister(uint64_t offset) const;
+  void dma(xclBOSyncDirection dir, size_t size);
+  void schedule(const completion& c);
+  void completionLoop();
+
+  const unsigned mTag;
+  unsigned mIndex;
+  clock::time_point mOpenTime;
+  clock::duration mCuLatency;
+  double mDmaMBps;
+
+  std::mutex mBOMtx;
+  std::unordered_map<unsigned int, buffer_object> mBOs;
+  unsigned int mNextBO;
+  uint64_t mNextAddr;
+  size_t mMemLimit;
+  size_t mMemUsed;
+
+  std::mutex mDmaMtx;
+  clock::time_point mDmaFree[2];
+
+  std::mutex mRegMtx;
+  std::unordered_map<uint64_t, uint32_t> mRegs;
+  std::unordered_map<uint64_t, clock::time_point> mCuDone;
+  unsigned mCuShift;
+  uint64_t mCuBase;
+  std::vector<clock::time_point> mCuFree;
+
+  std::mutex mCompletionMtx;
+  std::condition_variable mCompletionCond;
+  std::priority_queue<completion> mPending;
+  unsigned long mCompletions;
+  unsigned long mSeenCompletions;
+  bool mStop;
+  std::thread mCompletionThread;
+};
+
+} // xclnullhal2
+
+#endif
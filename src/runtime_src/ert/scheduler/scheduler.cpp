@@ -24,7 +24,7 @@
 #include "ert.h"
 #endif
 // includes from bsp
-#ifndef ERT_HW_EMU
+#if !defined(ERT_HW_EMU) && !defined(ERT_SIM)
 #include <xil_printf.h>
 #include <mb_interface.h>
 #include <xparameters.h>
@@ -46,7 +46,7 @@ ERT_UNUSED
 static void
 ert_assert(const char* file, long line, const char* function, const char* expr, const char* msg)
 {
-  xil_printf("Assert failed: %s:%d:%s:%s %s\n",file,line,function,expr,msg);
+  xil_printf("Assert failed: %s:%d:%s:%s %s\n",file,(int)line,function,expr,msg);
   exit(1);
 }
 
@@ -175,6 +175,13 @@ struct bitset_type
     return bitmasks[mask_idx];
   }
 
+  void
+  reset_bit(size_type pos)
+  {
+    auto mask = pos >> 5;
+    bitmasks[mask] &= ~(1<<(pos - (mask << 5)));
+  }
+
   void
   toggle(size_type pos)
   {
@@ -215,7 +222,7 @@ struct bitset_type
 
 // If this assert fails, then ert_parameters is out of sync with
 // the board support package header files.
-#ifndef ERT_HW_EMU
+#if !defined(ERT_HW_EMU) && !defined(ERT_SIM)
 static_assert(ERT_INTC_ADDR==XPAR_INTC_SINGLE_BASEADDR,"update driver/include/ert.h");
 #endif
 
@@ -300,7 +307,26 @@ static bitset_type cu_status;
 
 // Bitmask for interrupt enabled CUs.  (0) no interrupt (1) enabled
 static bitset_type cu_interrupt_mask;
-#ifndef ERT_HW_EMU
+
+// Next CU to try when starting a command, CUs are assigned round robin
+static size_type cu_next = 0;
+
+// Bitmasks of slots per slot state, owned by the scheduler loop.  The
+// loop visits only slots with a bit set in a state that needs work.
+static bitset_type slot_free;
+static bitset_type slot_new;
+static bitset_type slot_queued;
+static bitset_type slot_running;
+
+// Queued slot to try first when starting commands, the slot after the
+// last slot that was started, so that queued commands are started round
+// robin rather than lowest slot first
+static size_type slot_next = 0;
+
+// Bitmask of slots whose state was changed by the interrupt handler.
+// Merged into the slot state masks by the scheduler loop.
+static bitset_type slot_changed;
+#if !defined(ERT_HW_EMU) && !defined(ERT_SIM)
 /**
  * Utility to read a 32 bit value from any axi-lite peripheral
  */
@@ -467,6 +493,16 @@ setup()
   }
 
   cu_status.reset(num_cus);
+  cu_next = 0;
+
+  slot_free.reset(num_slots-1);
+  slot_new.reset(num_slots-1);
+  slot_queued.reset(num_slots-1);
+  slot_running.reset(num_slots-1);
+  slot_changed.reset(num_slots-1);
+  slot_next = 0;
+  for (size_type i=0; i<num_slots; ++i)
+    slot_free.set(i);
 
   // Initialize cu_slot_usage
   for (size_type i=0; i<num_cus; ++i)
@@ -668,8 +704,9 @@ start_cu(size_type slot_idx)
   auto& slot = command_slots[slot_idx];
   auto& cus = slot.cus;
 
-  // Check all CUs against argument cus mask and against cu_status
-  for (size_type cu_idx=0; cu_idx<num_cus; ++cu_idx) {
+  // Check all CUs against argument cus mask and against cu_status,
+  // starting with the CU after the one last started
+  for (size_type i=0, cu_idx=cu_next; i<num_cus; ++i, cu_idx=(cu_idx+1==num_cus) ? 0 : cu_idx+1) {
     if (cus.test(cu_idx) && !cu_status.test(cu_idx)) {
       ERT_DEBUGF("start_cu cu(%d) for slot_idx(%d)\n",cu_idx,slot_idx);
       ERT_ASSERT(read_reg(cu_idx_to_addr(cu_idx))==4,"cu not ready");
@@ -681,6 +718,7 @@ start_cu(size_type slot_idx)
       }
       cu_status.toggle(cu_idx);     // toggle cu status bit, it is now busy
       set_cu_info(cu_idx,slot_idx); // record which slot cu associated with
+      cu_next = (cu_idx+1==num_cus) ? 0 : cu_idx+1;
       return cu_idx;
     }
   }
@@ -709,6 +747,7 @@ check_command(size_type slot_idx, size_type cu_idx)
   if (slot.cus.none()) {
     notify_host(slot_idx);
     slot.header_value = (slot.header_value & ~0xF) | 0x4; // free
+    slot_changed.set(slot_idx);
     ERT_DEBUGF("slot(%d) [running -> free]\n",slot_idx);
 
 #ifdef DEBUG_SLOT_STATE
@@ -999,19 +1038,221 @@ running_to_free(size_type slot_idx)
 }
 
 /**
- * Main routine executed by embedded scheduler loop
+ * Update slot state bitmasks per current state of slot
+ */
+inline void
+update_slot_masks(size_type slot_idx)
+{
+  slot_free.reset_bit(slot_idx);
+  slot_new.reset_bit(slot_idx);
+  slot_queued.reset_bit(slot_idx);
+  slot_running.reset_bit(slot_idx);
+
+  switch (command_slots[slot_idx].header_value & 0xF) {
+  case 0x1: slot_new.set(slot_idx); break;
+  case 0x2: slot_queued.set(slot_idx); break;
+  case 0x3: slot_running.set(slot_idx); break;
+  case 0x4: slot_free.set(slot_idx); break;
+  }
+}
+
+/**
+ * Merge slots changed by interrupt handler into slot state bitmasks
+ */
+inline void
+merge_changed_slots()
+{
+  if (!cu_interrupt_enabled && !cq_status_enabled)
+    return;
+
+  // skip the interrupt guard when nothing changed, a slot changed after
+  // this check is merged in the next pass
+  if (slot_changed.none())
+    return;
+
+  bitset_type changed;
+  {
+    disable_interrupt_guard guard;
+    changed = slot_changed;
+    slot_changed.clear();
+  }
+
+  for (size_type w=0,offset=0; w<num_slot_masks; ++w,offset+=32)
+    for (auto mask = changed.get_mask(w); mask; mask &= mask-1)
+      update_slot_masks(offset + __builtin_ctz(mask));
+}
+
+/**
+ * Get bitmask of idle CUs
+ *
+ * @param idle: set to the CUs that are not running
+ * @return true if any CU is idle
+ */
+inline bool
+idle_cus(bitset_type& idle)
+{
+  bool any = false;
+  for (size_type w=0,offset=0; w<num_cu_masks; ++w,offset+=32) {
+    auto bits = num_cus - offset;
+    bitmask_type all = bits >= 32 ? 0xFFFFFFFF : (1u << bits) - 1;
+    auto mask = ~cu_status.get_mask(w) & all;
+    idle.set_mask(w,mask);
+    any = any || mask;
+  }
+  return any;
+}
+
+/**
+ * Check if any of the CUs of a slot is in the idle mask
+ */
+inline bool
+slot_has_idle_cu(size_type slot_idx, const bitset_type& idle)
+{
+  auto& cus = command_slots[slot_idx].cus;
+  for (size_type w=0; w<num_cu_masks; ++w)
+    if (cus.get_mask(w) & idle.get_mask(w))
+      return true;
+  return false;
+}
+
+/**
+ * Bitmask of slots in word w that have a state change to check
+ *
+ * Free slots when polling for new commands, new slots, and running
+ * slots when polling CUs.  Queued slots are started separately.
+ */
+inline bitmask_type
+active_slots(size_type w)
+{
+  bitmask_type mask = slot_new.get_mask(w);
+  if (!cq_status_enabled)
+    mask |= slot_free.get_mask(w);
+  if (!cu_interrupt_enabled)
+    mask |= slot_running.get_mask(w);
+  return mask;
+}
+
+/**
+ * Advance simulation time in emulation builds
+ */
+inline void
+loop_tick()
+{
+#ifdef ERT_HW_EMU
+  if(sim_embedded_scheduler_sw_imp::getSchedularPtr()!=nullptr) {
+  sim_embedded_scheduler_sw_imp* sch=sim_embedded_scheduler_sw_imp::getSchedularPtr();
+    wait(sch->maxi_lite_mb_aclk.posedge_event());
+  } else {
+    sc_time t(1,SC_NS);
+    wait(t);
+  }
+#endif
+#ifdef ERT_SIM
+  ert_sim_tick();
+#endif
+}
+
+/**
+ * Check command in slot for state change
  *
- * For each command slot do
  *  1. If status is free (0x4), then read new command header
  *     Status remains free (0x4), or transitions to new (0x1)
  *  2. If status is new (0x1), then read CUs in command
  *     Status transitions to queued (0x2)
- *  3. If status is queued (0x2), then start command on available CU
- *     Status remains queued if no CUs available, or transitions to running (0x3)
- *  4. If status is running (0x4), then check CU status
- *     Status remains running (0x4) if CU is still running, or
+ *  3. If status is running (0x3), then check CU status
+ *     Status remains running (0x3) if CU is still running, or
  *     transitions to free if CU is done
  */
+inline void
+process_slot(size_type slot_idx)
+{
+  auto& slot = command_slots[slot_idx];
+
+  // CQ_STATUS_ENABLED CHECK WON'T WORK IF HOST TRANSITIONS
+  // FROM ENABLED -> DISABLED IN CONFIGURE COMMAND
+  if (!cq_status_enabled && ((slot.header_value & 0xF) == 0x4)) { // free
+    if (!free_to_new(slot_idx))
+      return;
+  }
+
+  if ((slot.header_value & 0xF) == 0x1) { // new
+    if (!new_to_queued(slot_idx))
+      return;
+  }
+
+  if (!cu_interrupt_enabled && ((slot.header_value & 0xF) == 0x3)) { // running
+    if (!running_to_free(slot_idx))
+      return;
+  }
+}
+
+/**
+ * Start queued commands on idle CUs
+ *
+ * Queued slots are tried round robin starting at slot_next, which
+ * moves past each started slot, so a queued command waits for at most
+ * num_slots other commands to start.
+ *
+ * Only slots with a CU in the idle mask are tried, so slots whose CUs
+ * are all busy cost a mask test.  The idle mask is a snapshot, CUs that
+ * complete meanwhile are used in the next pass.
+ *
+ * @param w: word of slot_queued to check
+ * @param range: bits of word to check
+ * @param idle: idle CUs, updated as CUs are started
+ * @return false if all CUs are busy
+ */
+inline bool
+start_slots(size_type w, bitmask_type range, bitset_type& idle)
+{
+  auto offset = w << 5;
+  for (auto mask = slot_queued.get_mask(w) & range; mask; mask &= mask-1) {
+    auto slot_idx = offset + __builtin_ctz(mask);
+    if (!slot_has_idle_cu(slot_idx,idle))
+      continue;
+    if (queued_to_running(slot_idx)) {
+      update_slot_masks(slot_idx);
+      slot_next = (slot_idx+1==num_slots) ? 0 : slot_idx+1;
+      if (!idle_cus(idle))
+        return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Start queued commands while any CU is idle
+ *
+ * Queued slots from slot_next to end of its word, following words,
+ * and wrapping around to the slots before slot_next.
+ */
+inline void
+start_queued()
+{
+  bitset_type idle;
+  if (!idle_cus(idle))
+    return;
+
+  auto first = slot_next >> 5;
+  bitmask_type low = (1u << (slot_next & 31)) - 1;
+  bool any = start_slots(first,~low,idle);
+  for (size_type w=first+1; any && w<num_slot_masks; ++w)
+    any = start_slots(w,0xFFFFFFFF,idle);
+  for (size_type w=0; any && w<first; ++w)
+    any = start_slots(w,0xFFFFFFFF,idle);
+  if (any)
+    start_slots(first,low,idle);
+}
+
+/**
+ * Main routine executed by embedded scheduler loop
+ *
+ * Each pass checks the slots that can change state per the slot state
+ * bitmasks, free slots for new commands and running slots for CU
+ * completion.  Queued commands are started whenever a CU is idle, at
+ * the start of the pass and after each slot checked, so an idle CU
+ * does not wait for the rest of the pass.
+ */
 ERT_UNUSED // don't warn when unused
 static void
 scheduler_loop()
@@ -1023,37 +1264,19 @@ scheduler_loop()
   setup();
 
   while (1) {
-    for (size_type slot_idx=0; slot_idx<num_slots; ++slot_idx) {
-      auto& slot = command_slots[slot_idx];
-#ifdef ERT_HW_EMU
-      if(sim_embedded_scheduler_sw_imp::getSchedularPtr()!=nullptr) {
-      sim_embedded_scheduler_sw_imp* sch=sim_embedded_scheduler_sw_imp::getSchedularPtr();
-        wait(sch->maxi_lite_mb_aclk.posedge_event());
-      } else {
-        sc_time t(1,SC_NS);
-        wait(t);
-      }
-#endif
-      // CQ_STATUS_ENABLED CHECK WON'T WORK IF HOST TRANSITIONS
-      // FROM ENABLED -> DISABLED IN CONFIGURE COMMAND
-      if (!cq_status_enabled && ((slot.header_value & 0xF) == 0x4)) { // free
-        if (!free_to_new(slot_idx))
-          continue;
-      }
+    // CUs freed by interrupts are restarted before merging, interrupts
+    // do not change queued slots
+    loop_tick();
+    start_queued();
+    merge_changed_slots();
 
-      if ((slot.header_value & 0xF) == 0x1) { // new
-        if (!new_to_queued(slot_idx))
-          continue;
-      }
-
-      if ((slot.header_value & 0xF) == 0x2) { // queued
-        if (!queued_to_running(slot_idx))
-          continue;
-      }
-
-      if (!cu_interrupt_enabled && ((slot.header_value & 0xF) == 0x3)) { // running
-        if (!running_to_free(slot_idx))
-          continue;
+    for (size_type w=0,offset=0; w<num_slot_masks; ++w,offset+=32) {
+      for (auto mask = active_slots(w); mask; mask &= mask-1) {
+        auto slot_idx = offset + __builtin_ctz(mask);
+        loop_tick();
+        process_slot(slot_idx);
+        update_slot_masks(slot_idx);
+        start_queued();
       }
     }
   } // while
@@ -1091,8 +1314,8 @@ cu_interrupt_handler()
       ERT_DEBUGF("command queue interrupt from host: 0x%x\n",slot_mask);
       // Transition each new command into new state
       for (size_type slot_idx=offset; slot_mask; slot_mask >>= 1, ++slot_idx)
-        if (slot_mask & 0x1)
-          free_to_new(slot_idx);
+        if ((slot_mask & 0x1) && free_to_new(slot_idx))
+          slot_changed.set(slot_idx);
     }
   }
 
@@ -1114,7 +1337,7 @@ cu_interrupt_handler()
 }
 
 } // ert
-#ifndef ERT_HW_EMU
+#if !defined(ERT_HW_EMU) && !defined(ERT_SIM)
 int main()
 {
   ert::scheduler_loop();
@@ -0,0 +1,590 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * Host simulator for the embedded runtime scheduler
+ *
+ * Builds the MicroBlaze scheduler_loop() on the host and runs it against
+ * a model of the command queue, the ERT CSRs, the interrupt controller
+ * and the CUs.  Time is counted in MicroBlaze clock cycles; every AXI-lite
+ * register access and every pass over a command slot costs a configurable
+ * number of cycles, and every CU runs for a scripted latency.  A host
+ * model keeps all command queue slots filled with start kernel commands
+ * and reuses a slot once the scheduler has notified its completion.
+ *
+ * % ertsim -s 16,32,128 -c 1,4,16 -l 10,2,50 -n 20000
+ *
+ * For each combination of slot count and CU count the simulator reports
+ * commands per second, slot-to-start latency (host writes a new command
+ * until its CU is started), done-to-notify latency (CU done until the host
+ * status register is written) and CU idle gaps (CU done or new command
+ * available, whichever is later, until the CU is started again).
+ */
+
+#include "driver/include/ert.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <getopt.h>
+
+// Hooks called by the firmware in ERT_SIM mode
+static uint32_t read_reg(uint32_t addr);
+static void write_reg(uint32_t addr, uint32_t val);
+static void microblaze_enable_interrupts();
+static void microblaze_disable_interrupts();
+static void ert_sim_tick();
+
+#include "../scheduler.cpp"
+
+namespace {
+
+using cycles_type = uint64_t;
+
+// Thrown from the firmware loop when all commands have completed
+struct sim_done {};
+
+struct config
+{
+  double mb_mhz = 100;              // MicroBlaze clock
+  cycles_type read_cycles = 16;     // AXI-lite read of CSR, CQ or CU
+  cycles_type write_cycles = 8;     // AXI-lite write
+  cycles_type slot_cycles = 12;     // loop overhead per slot visited
+  double host_us = 0;               // host turnaround to refill a notified slot
+  size_t commands = 10000;          // start kernel commands per run
+  size_t regmap_words = 8;          // CU register map size in command
+  std::vector<double> cu_latency_us = {10}; // cycled through by each CU
+  std::vector<size_t> slots = {16};
+  std::vector<size_t> cus = {4};
+  bool cu_isr = false;
+  bool cq_int = false;
+  bool cu_dma = false;
+};
+
+struct cu_model
+{
+  uint32_t addr = 0;
+  bool running = false;
+  bool resolved = false;             // command started on cu is known
+  cycles_type start = 0;
+  cycles_type done = 0;              // when running cu completes
+  cycles_type last_done = 0;
+  cycles_type busy = 0;
+  size_t next_latency = 0;
+  size_t cmd = 0;
+};
+
+struct command_record
+{
+  cycles_type submit = 0;
+  cycles_type start = 0;
+  cycles_type done = 0;
+  cycles_type notify = 0;
+  cycles_type gap = 0;
+};
+
+struct host_slot
+{
+  bool busy = false;
+  size_t cmd = 0;
+  cycles_type ready = 0;             // when host can reuse the slot
+};
+
+static const size_t no_cmd = std::numeric_limits<size_t>::max();
+static const uint32_t cu_base = 0x1800000;
+
+static config cfg;
+static cycles_type now = 0;
+static std::unordered_map<uint32_t,uint32_t> mem;
+static std::vector<cu_model> cus;
+static std::vector<host_slot> host_slots;
+static std::vector<command_record> records;
+static cycles_type host_cycles = 0;
+static size_t submitted = 0;
+static size_t completed = 0;
+static uint32_t slot_size = 0;
+static bool mb_interrupts = false;
+static bool configured = false;
+static cycles_type last_progress = 0;
+
+static cycles_type
+us_to_cycles(double us)
+{
+  return static_cast<cycles_type>(us * cfg.mb_mhz);
+}
+
+static double
+cycles_to_us(cycles_type cycles)
+{
+  return cycles / cfg.mb_mhz;
+}
+
+static uint32_t
+slot_addr(size_t slot_idx)
+{
+  return ERT_CQ_BASE_ADDR + slot_idx * slot_size;
+}
+
+static cu_model*
+cu_at(uint32_t addr)
+{
+  if (addr < cu_base)
+    return nullptr;
+  for (auto& cu : cus)
+    if (cu.addr == addr)
+      return &cu;
+  return nullptr;
+}
+
+static void
+start_cu(cu_model& cu)
+{
+  auto& latency = cfg.cu_latency_us;
+  cu.running = true;
+  cu.resolved = false;
+  cu.start = now;
+  cu.done = now + us_to_cycles(latency[cu.next_latency++ % latency.size()]);
+}
+
+// Associate a started cu with the command it runs, the firmware
+// records the slot right after starting the cu
+static void
+resolve(cu_model& cu)
+{
+  if (!cu.running || cu.resolved)
+    return;
+  auto cu_idx = &cu - cus.data();
+  auto slot_idx = ert::cu_slot_usage[cu_idx];
+  if (slot_idx == ert::no_index)
+    return;
+
+  cu.resolved = true;
+  cu.cmd = host_slots[slot_idx].cmd;
+  if (cu.cmd == no_cmd)
+    return;
+  auto& rec = records[cu.cmd];
+  rec.start = cu.start;
+  rec.gap = cu.start - std::max(rec.submit,cu.last_done);
+}
+
+static void
+complete_cu(cu_model& cu)
+{
+  resolve(cu);
+  cu.running = false;
+  cu.last_done = cu.done;
+  cu.busy += cu.done - cu.start;
+  if (cu.resolved && cu.cmd != no_cmd)
+    records[cu.cmd].done = cu.done;
+}
+
+static void
+notify(size_t slot_idx)
+{
+  auto& hs = host_slots.at(slot_idx);
+  if (!hs.busy)
+    throw std::runtime_error("notify for idle slot " + std::to_string(slot_idx));
+  hs.busy = false;
+  hs.ready = now + host_cycles;
+  if (hs.cmd != no_cmd) {
+    records[hs.cmd].notify = now;
+    ++completed;
+  }
+  last_progress = now;
+}
+
+static void
+write_command(size_t slot_idx, size_t cmd, uint32_t header, const std::vector<uint32_t>& payload)
+{
+  auto addr = slot_addr(slot_idx);
+  for (size_t i = 0; i < payload.size(); ++i)
+    mem[addr + 4 + i * 4] = payload[i];
+  mem[addr] = header;
+
+  auto& hs = host_slots[slot_idx];
+  hs.busy = true;
+  hs.cmd = cmd;
+
+  if (mem[ERT_CQ_STATUS_ENABLE_ADDR]) {
+    mem[ERT_CQ_STATUS_REGISTER_ADDR + (slot_idx >> 5) * 4] |= 1u << (slot_idx & 31);
+    mem[ERT_INTC_IPR_ADDR] |= 0x1;
+  }
+}
+
+static void
+submit_configure()
+{
+  uint32_t features = 0x1       // ert
+    | 0x2                       // polling, no mb->host interrupts
+    | (cfg.cu_dma ? 0x4 : 0)
+    | (cfg.cu_isr ? 0x8 : 0)
+    | (cfg.cq_int ? 0x10 : 0);
+  std::vector<uint32_t> payload = {
+    slot_size, static_cast<uint32_t>(cus.size()), 16, cu_base, features
+  };
+  for (auto& cu : cus)
+    payload.push_back(cu.addr);
+  uint32_t header = 0x1 | (payload.size() << 12) | (ERT_CONFIGURE << 23);
+  write_command(0,no_cmd,header,payload);
+}
+
+static void
+submit_commands()
+{
+  auto num_cu_masks = ((cus.size() - 1) >> 5) + 1;
+  for (size_t slot_idx = 0; slot_idx < host_slots.size() && submitted < cfg.commands; ++slot_idx) {
+    auto& hs = host_slots[slot_idx];
+    if (hs.busy || hs.ready > now)
+      continue;
+
+    // any cu can run the command
+    std::vector<uint32_t> payload;
+    for (size_t m = 0; m < num_cu_masks; ++m) {
+      auto bits = std::min<size_t>(32,cus.size() - m * 32);
+      payload.push_back(bits == 32 ? 0xffffffff : (1u << bits) - 1);
+    }
+    payload.resize(num_cu_masks + cfg.regmap_words,0);
+    uint32_t header = 0x1 | ((num_cu_masks - 1) << 10) | (payload.size() << 12) | (ERT_START_CU << 23);
+
+    records[submitted].submit = now;
+    write_command(slot_idx,submitted++,header,payload);
+  }
+}
+
+static void
+deliver_interrupts()
+{
+  // cu interrupts through cuisr, raised when cu is done
+  if (mem[ERT_CU_ISR_HANDLER_ENABLE_ADDR]) {
+    for (size_t cu_idx = 0; cu_idx < cus.size(); ++cu_idx) {
+      auto& cu = cus[cu_idx];
+      if (!cu.running || cu.done > now || !mem[cu.addr + 0x4])
+        continue;
+      complete_cu(cu);
+      mem[ERT_CU_STATUS_REGISTER_ADDR + (cu_idx >> 5) * 4] |= 1u << (cu_idx & 31);
+      mem[ERT_INTC_IPR_ADDR] |= 0x2;
+    }
+  }
+
+  auto pending = mem[ERT_INTC_IPR_ADDR] & mem[ERT_INTC_IER_ADDR];
+  if (mb_interrupts && (mem[ERT_INTC_MER_ADDR] & 0x3) == 0x3 && pending)
+    ert::cu_interrupt_handler();
+}
+
+}
+
+static uint32_t
+read_reg(uint32_t addr)
+{
+  now += cfg.read_cycles;
+
+  if (auto cu = cu_at(addr)) {
+    if (!cu->running)
+      return 0x4;                      // AP_IDLE
+    if (cu->done > now)
+      return 0x1;                      // AP_START
+    complete_cu(*cu);
+    return 0x6;                        // AP_DONE | AP_IDLE, done is clear on read
+  }
+
+  auto itr = mem.find(addr);
+  auto val = itr == mem.end() ? 0 : itr->second;
+
+  // status registers are clear on read
+  if ((addr >= ERT_CU_STATUS_REGISTER_ADDR0 && addr <= ERT_CU_STATUS_REGISTER_ADDR3)
+      || (addr >= ERT_CQ_STATUS_REGISTER_ADDR0 && addr <= ERT_CQ_STATUS_REGISTER_ADDR3))
+    mem[addr] = 0;
+
+  return val;
+}
+
+static void
+write_reg(uint32_t addr, uint32_t val)
+{
+  now += cfg.write_cycles;
+
+  if (auto cu = cu_at(addr)) {
+    if (val & 0x1)
+      start_cu(*cu);
+    return;
+  }
+
+  if (addr >= ERT_STATUS_REGISTER_ADDR0 && addr <= ERT_STATUS_REGISTER_ADDR3) {
+    // the firmware writes 1<<slot_idx to register slot_idx>>5
+    auto w = (addr - ERT_STATUS_REGISTER_ADDR0) >> 2;
+    for (uint32_t bit = 0; bit < 32; ++bit)
+      if (val & (1u << bit))
+        notify(w * 32 + bit);
+    return;
+  }
+
+  if (addr >= ERT_CU_DMA_REGISTER_ADDR0 && addr <= ERT_CU_DMA_REGISTER_ADDR3) {
+    // cu dma copies the regmap of the slot and starts the cu written
+    // to the cu section of the slot
+    auto w = (addr - ERT_CU_DMA_REGISTER_ADDR0) >> 2;
+    for (uint32_t bit = 0; bit < 32; ++bit) {
+      if (!(val & (1u << bit)))
+        continue;
+      auto sa = slot_addr(w * 32 + bit);
+      for (size_t m = 0; m < (cus.size() + 31) / 32; ++m) {
+        auto mask = mem[sa + 4 + m * 4];
+        for (uint32_t cu_bit = 0; cu_bit < 32; ++cu_bit)
+          if (mask & (1u << cu_bit)) {
+            now += cfg.regmap_words * cfg.write_cycles;
+            start_cu(cus.at(m * 32 + cu_bit));
+          }
+      }
+    }
+    return;
+  }
+
+  if (addr == ERT_INTC_IAR_ADDR) {
+    mem[ERT_INTC_IPR_ADDR] &= ~val;
+    return;
+  }
+
+  mem[addr] = val;
+}
+
+static void
+microblaze_enable_interrupts()
+{
+  mb_interrupts = true;
+}
+
+static void
+microblaze_disable_interrupts()
+{
+  mb_interrupts = false;
+}
+
+static void
+ert_sim_tick()
+{
+  now += cfg.slot_cycles;
+
+  // the firmware clears the command queue when it starts
+  if (!configured) {
+    submit_configure();
+    configured = true;
+  }
+
+  for (auto& cu : cus)
+    resolve(cu);
+
+  deliver_interrupts();
+
+  if (completed == cfg.commands)
+    throw sim_done();
+
+  // configure is done once slot 0 is free and commands can be sent
+  if (!host_slots[0].busy || submitted)
+    submit_commands();
+
+  // one second of simulated time without progress is a hang
+  if (now - last_progress > us_to_cycles(1000000))
+    throw std::runtime_error("scheduler made no progress for 1s");
+}
+
+namespace {
+
+struct stats
+{
+  double avg = 0;
+  double p50 = 0;
+  double p99 = 0;
+  double max = 0;
+};
+
+static stats
+summarize(std::vector<cycles_type> values)
+{
+  stats s;
+  if (values.empty())
+    return s;
+  std::sort(values.begin(),values.end());
+  double sum = 0;
+  for (auto v : values)
+    sum += v;
+  s.avg = cycles_to_us(sum / values.size());
+  s.p50 = cycles_to_us(values[values.size() / 2]);
+  s.p99 = cycles_to_us(values[values.size() * 99 / 100]);
+  s.max = cycles_to_us(values.back());
+  return s;
+}
+
+static void
+run(size_t num_slots, size_t num_cus)
+{
+  mem.clear();
+  now = 0;
+  last_progress = 0;
+  submitted = 0;
+  completed = 0;
+  host_cycles = us_to_cycles(cfg.host_us);
+  slot_size = ERT_CQ_SIZE / num_slots;
+  mb_interrupts = false;
+  configured = false;
+
+  // firmware state that survives setup() is reset by MicroBlaze reset
+  ert::cu_dma_enabled = 0;
+  ert::cu_interrupt_enabled = 0;
+  ert::cq_status_enabled = 0;
+  ert::mb_host_interrupt_enabled = 0;
+  ert::cu_dma_52 = 0;
+  ert::cdma_enabled = 0;
+
+  cus.assign(num_cus,cu_model());
+  for (size_t i = 0; i < num_cus; ++i)
+    cus[i].addr = cu_base + (i << 16);
+  host_slots.assign(num_slots,host_slot());
+  records.assign(cfg.commands,command_record());
+
+  try {
+    ert::scheduler_loop();
+  }
+  catch (const sim_done&) {
+  }
+
+  cycles_type first = records.front().submit;
+  cycles_type last = 0;
+  std::vector<cycles_type> to_start, to_notify, gaps;
+  for (auto& rec : records) {
+    last = std::max(last,rec.notify);
+    to_start.push_back(rec.start - rec.submit);
+    to_notify.push_back(rec.notify - rec.done);
+    gaps.push_back(rec.gap);
+  }
+
+  cycles_type busy = 0;
+  for (auto& cu : cus)
+    busy += cu.busy;
+
+  auto elapsed = last - first;
+  auto start = summarize(to_start);
+  auto done = summarize(to_notify);
+  auto gap = summarize(gaps);
+  std::printf("%5zu %4zu %12.0f %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f %6.1f%%\n"
+              ,num_slots,num_cus
+              ,cfg.commands / (cycles_to_us(elapsed) / 1e6)
+              ,start.avg,start.p99,start.max
+              ,done.avg,done.max
+              ,gap.avg,gap.max
+              ,100.0 * busy / (elapsed * num_cus));
+}
+
+static std::vector<double>
+parse_list(const char* arg)
+{
+  std::vector<double> values;
+  for (auto str = arg; *str; ) {
+    char* end = nullptr;
+    values.push_back(std::strtod(str,&end));
+    if (end == str)
+      throw std::runtime_error(std::string("bad list '") + arg + "'");
+    str = (*end == ',') ? end + 1 : end;
+  }
+  return values;
+}
+
+static std::vector<size_t>
+parse_sizes(const char* arg)
+{
+  std::vector<size_t> sizes;
+  for (auto v : parse_list(arg))
+    sizes.push_back(static_cast<size_t>(v));
+  return sizes;
+}
+
+static void
+usage()
+{
+  std::printf("usage: ertsim [options]\n"
+              "  -s <n,...>   command queue slots, 2-%u (16)\n"
+              "  -c <n,...>   compute units, 1-%u (4)\n"
+              "  -l <us,...>  cu latencies cycled through by each cu (10)\n"
+              "  -n <n>       start kernel commands per run (10000)\n"
+              "  -r <n>       cu register map words per command (8)\n"
+              "  -f <mhz>     MicroBlaze clock (100)\n"
+              "  -R <cycles>  AXI-lite read cycles (16)\n"
+              "  -W <cycles>  AXI-lite write cycles (8)\n"
+              "  -L <cycles>  loop cycles per slot visited (12)\n"
+              "  -H <us>      host turnaround to refill a slot (0)\n"
+              "  -i           cu interrupts (cuisr) instead of polling\n"
+              "  -q           host to MicroBlaze command queue interrupts\n"
+              "  -d           cu dma to configure and start cus\n"
+              ,ert::max_slots,ert::max_cus);
+}
+
+}
+
+int
+main(int argc, char* argv[])
+{
+  try {
+    int opt;
+    while ((opt = getopt(argc,argv,"s:c:l:n:r:f:R:W:L:H:iqdh")) != -1) {
+      switch (opt) {
+      case 's': cfg.slots = parse_sizes(optarg); break;
+      case 'c': cfg.cus = parse_sizes(optarg); break;
+      case 'l': cfg.cu_latency_us = parse_list(optarg); break;
+      case 'n': cfg.commands = std::strtoul(optarg,nullptr,0); break;
+      case 'r': cfg.regmap_words = std::strtoul(optarg,nullptr,0); break;
+      case 'f': cfg.mb_mhz = std::strtod(optarg,nullptr); break;
+      case 'R': cfg.read_cycles = std::strtoul(optarg,nullptr,0); break;
+      case 'W': cfg.write_cycles = std::strtoul(optarg,nullptr,0); break;
+      case 'L': cfg.slot_cycles = std::strtoul(optarg,nullptr,0); break;
+      case 'H': cfg.host_us = std::strtod(optarg,nullptr); break;
+      case 'i': cfg.cu_isr = true; break;
+      case 'q': cfg.cq_int = true; break;
+      case 'd': cfg.cu_dma = true; break;
+      default: usage(); return opt == 'h' ? 0 : 1;
+      }
+    }
+
+    if (!cfg.commands || cfg.cu_latency_us.empty())
+      throw std::runtime_error("no commands or cu latencies");
+    for (auto s : cfg.slots)
+      if (s < 2 || s > ert::max_slots || ERT_CQ_SIZE / s < (4 + 4 * 4 + 4 * cfg.regmap_words))
+        throw std::runtime_error("bad slot count " + std::to_string(s) + ", see -h");
+    for (auto c : cfg.cus)
+      if (c < 1 || c > ert::max_cus)
+        throw std::runtime_error("bad cu count " + std::to_string(c) + ", see -h");
+
+    std::printf("%5s %4s %12s %8s %8s %8s %8s %8s %8s %8s %7s\n"
+                ,"slots","cus","cmds/s"
+                ,"start","p99","max"
+                ,"notify","max"
+                ,"cu gap","max"
+                ,"cu use");
+    std::printf("%5s %4s %12s %26s %17s %17s\n","","",""
+                ,"slot to start (us)","done to host(us)","cu idle gap (us)");
+    for (auto s : cfg.slots)
+      for (auto c : cfg.cus)
+        run(s,c);
+  }
+  catch (const std::exception& ex) {
+    std::fprintf(stderr,"ertsim: %s\n",ex.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include "xdp/profile/rt_trace_writer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Binary timeline trace written as the runtime BinaryWriter does, converted
+// back with xdptrace (XDPTRACE is the path of the built executable)
+
+using XCL::trace::FileWriter;
+
+namespace {
+
+std::string
+tmp_name(const std::string& tag)
+{
+  return "/tmp/xdptracetest_" + std::to_string(getpid()) + "_" + tag + ".bin";
+}
+
+// Run xdptrace on file, return exit status and stdout lines
+int
+run_xdptrace(const std::string& file, std::vector<std::string>& lines)
+{
+  std::string cmd = std::string(XDPTRACE) + " " + file + " 2>/dev/null";
+  FILE* fp = popen(cmd.c_str(), "r");
+  if (!fp)
+    return -1;
+
+  std::string out;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+    out.append(buf, n);
+  int status = pclose(fp);
+
+  lines.clear();
+  std::istringstream iss(out);
+  for (std::string line; std::getline(iss, line); )
+    lines.push_back(line);
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+void
+write_trace(const std::string& file)
+{
+  FileWriter writer;
+  writer.setDocumentHeader("2018-06-01 10:00:00", "1527847200000", "host.exe",
+                           "xilinx_vcu1525_dynamic_5_1", "2018.2");
+  ASSERT_TRUE(writer.open(file));
+
+  writer.writeApiCall(1.5, "clCreateBuffer|General", "START");
+  writer.writeApiCall(1.75, "clCreateBuffer|General", "END");
+  writer.writeKernel(2.125, "KERNEL|vadd|all", "START", "2", "1", 0x1a2b, 1024);
+  writer.writeDataTransfer(3.0, "WRITE_BUFFER", "START", "3", "", 4096, 0x4000,
+                           "bank0", "0X7F1234");
+  writer.writeDataTransfer(3.5, "WRITE_BUFFER", "QUEUE", "3", "", 4096, 0x4000,
+                           "bank0", "");
+  writer.writeDependency(4.0, "KERNEL|vadd|all", "WAIT", "4", "3");
+  writer.writeDeviceKernel(5.0, 5.25, "KERNEL|vadd|cu0", "16:1:1");
+  writer.writeDeviceTransfer(5.0625, 5.125, "Write|vadd|cu0", "Write", "a|b",
+                             62.5, 1000, 1250, 16);
+  writer.setFooter("Footer,begin\nProject,vadd,\nFooter,end\n");
+  writer.close();
+}
+
+}
+
+TEST(XdpTrace, RoundTripCsv) {
+  auto file = tmp_name("csv");
+  write_trace(file);
+
+  std::vector<std::string> lines;
+  ASSERT_EQ(run_xdptrace(file, lines), 0);
+  std::remove(file.c_str());
+
+  const std::vector<std::string> expected = {
+    "SDAccel Timeline Trace",
+    "Generated on: 2018-06-01 10:00:00",
+    "Msec since Epoch: 1527847200000",
+    "Profiled application: host.exe",
+    "Target platform: xilinx_vcu1525_dynamic_5_1",
+    "Tool version: 2018.2",
+    "",
+    "",
+    "Time_msec,Name,Event,Address_Port,Size,Latency_cycles,Start_cycles,End_cycles,Latency_usec,Start_msec,End_msec,",
+    "1.5,clCreateBuffer|General,START,,,,,,,,,",
+    "1.75,clCreateBuffer|General,END,,,,,,,,,",
+    "2.125,KERNEL|vadd|all,START,0X1A2B,1024,,,,,,,2,1,",
+    "3,WRITE_BUFFER,START,0X000004000|bank0|0X7F1234,4096,,,,,,,3,,",
+    "3.5,WRITE_BUFFER,QUEUE,0X000004000|bank0,4096,,,,,,,3,,",
+    "4,KERNEL|vadd|all,WAIT,4,3,",
+    "5,KERNEL|vadd|cu0,START,,16:1:1,",
+    "5.25,KERNEL|vadd|cu0,END,,16:1:1,",
+    "5.0625,Write|vadd|cu0,Write,a|b,16,250,1000,1250,62.5,5.0625,5.125,",
+    "Footer,begin",
+    "Project,vadd,",
+    "Footer,end"
+  };
+  EXPECT_EQ(lines, expected);
+}
+
+TEST(XdpTrace, Incomplete) {
+  // Header and records only, as left by a run that did not finish
+  auto file = tmp_name("incomplete");
+  write_trace(file);
+  {
+    std::ifstream ifs(file, std::ios::binary);
+    std::vector<char> data(sizeof(XCL::trace::FileHeader) + sizeof(XCL::trace::Record));
+    ifs.read(data.data(), data.size());
+    XCL::trace::FileHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    header.RecordCount = 0;
+    header.StringCount = 0;
+    std::memcpy(data.data(), &header, sizeof(header));
+    std::ofstream ofs(file, std::ios::binary | std::ios::trunc);
+    ofs.write(data.data(), data.size());
+  }
+
+  std::vector<std::string> lines;
+  EXPECT_EQ(run_xdptrace(file, lines), 1);
+  EXPECT_TRUE(lines.empty());
+  std::remove(file.c_str());
+}
+
+TEST(XdpTrace, NotATrace) {
+  auto file = tmp_name("bad");
+  {
+    std::ofstream ofs(file, std::ios::binary);
+    ofs << std::string(sizeof(XCL::trace::FileHeader), 'x');
+  }
+  std::vector<std::string> lines;
+  EXPECT_EQ(run_xdptrace(file, lines), 1);
+  EXPECT_TRUE(lines.empty());
+  std::remove(file.c_str());
+}
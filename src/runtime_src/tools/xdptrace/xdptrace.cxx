@@ -0,0 +1,514 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+// ============================================================================
+// File Name: xdptrace.cxx
+//
+// Convert binary timeline trace (Debug.timeline_trace_format=binary) to
+// the CSV or HTML timeline written by the runtime, or to Chrome trace
+// JSON (chrome://tracing, Perfetto).
+// ============================================================================
+
+#include "xdp/profile/rt_trace_format.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+using namespace XCL::trace;
+
+////////////////////////////////////////////////////////////////
+// Read only mapping of a complete trace file
+////////////////////////////////////////////////////////////////
+class trace_file
+{
+  // Unmapped also when the constructor throws
+  struct mapping
+  {
+    void* addr = MAP_FAILED;
+    size_t size = 0;
+
+    mapping() = default;
+    mapping(const mapping&) = delete;
+    mapping& operator=(const mapping&) = delete;
+
+    ~mapping()
+    {
+      if (addr != MAP_FAILED)
+        munmap(addr, size);
+    }
+  };
+
+  mapping m_map;
+  const FileHeader* m_header = nullptr;
+  const Record* m_records = nullptr;
+  std::vector<std::string> m_strings;
+
+public:
+  explicit
+  trace_file(const std::string& path)
+  {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("cannot open '" + path + "'");
+    struct stat st;
+    if (fstat(fd, &st) == 0)
+      m_map.size = st.st_size;
+    if (m_map.size >= sizeof(FileHeader))
+      m_map.addr = mmap(nullptr, m_map.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m_map.addr == MAP_FAILED)
+      throw std::runtime_error("cannot map '" + path + "'");
+
+    m_header = static_cast<const FileHeader*>(m_map.addr);
+    if (std::memcmp(m_header->Magic, MAGIC, sizeof(MAGIC)))
+      throw std::runtime_error("'" + path + "' is not a binary timeline trace");
+    if (m_header->Version != VERSION)
+      throw std::runtime_error("unsupported trace version " + std::to_string(m_header->Version));
+    if (m_header->RecordSize != sizeof(Record))
+      throw std::runtime_error("unexpected record size " + std::to_string(m_header->RecordSize));
+    if (!m_header->StringCount)
+      throw std::runtime_error("'" + path + "' is incomplete, the run did not finish");
+    if (m_header->StringOffset > m_map.size
+        || m_header->RecordOffset + m_header->RecordCount * sizeof(Record) > m_header->StringOffset)
+      throw std::runtime_error("'" + path + "' is truncated");
+
+    m_records = reinterpret_cast<const Record*>(static_cast<const char*>(m_map.addr) + m_header->RecordOffset);
+
+    auto pos = static_cast<const char*>(m_map.addr) + m_header->StringOffset;
+    auto end = static_cast<const char*>(m_map.addr) + m_map.size;
+    m_strings.reserve(m_header->StringCount);
+    for (uint64_t i = 0; i < m_header->StringCount; ++i) {
+      uint32_t len = 0;
+      if (pos + sizeof(len) > end)
+        throw std::runtime_error("'" + path + "' has a truncated string table");
+      std::memcpy(&len, pos, sizeof(len));
+      pos += sizeof(len);
+      if (pos + len > end)
+        throw std::runtime_error("'" + path + "' has a truncated string table");
+      m_strings.emplace_back(pos, len);
+      pos += len;
+    }
+  }
+
+  const FileHeader&
+  header() const
+  {
+    return *m_header;
+  }
+
+  const Record*
+  begin() const
+  {
+    return m_records;
+  }
+
+  const Record*
+  end() const
+  {
+    return m_records + m_header->RecordCount;
+  }
+
+  const std::string&
+  str(uint64_t id) const
+  {
+    if (id >= m_strings.size())
+      throw std::runtime_error("invalid string id " + std::to_string(id));
+    return m_strings[id];
+  }
+};
+
+// Same formatting as the runtime CSV writer
+std::string
+time_str(double msec)
+{
+  std::stringstream ss;
+  ss << std::setprecision(10) << msec;
+  return ss.str();
+}
+
+template <typename T>
+std::string
+to_str(T value)
+{
+  std::stringstream ss;
+  ss << value;
+  return ss.str();
+}
+
+using row_type = std::vector<std::string>;
+
+// Expand a record to the timeline rows written by the runtime
+void
+get_rows(const trace_file& tf, const Record& r, std::vector<row_type>& rows)
+{
+  rows.clear();
+  switch (r.Kind) {
+  case API_CALL:
+    rows.push_back({time_str(r.Time), tf.str(r.Name), tf.str(r.Stage), "", "", "", "", "", "", "", ""});
+    break;
+  case KERNEL: {
+    std::stringstream objid;
+    objid << std::showbase << std::hex << std::uppercase << r.Value0;
+    rows.push_back({time_str(r.Time), tf.str(r.Name), tf.str(r.Stage), objid.str(), to_str(r.Value1),
+                    "", "", "", "", "", "", tf.str(r.Event), tf.str(r.Depend)});
+    break;
+  }
+  case DATA_TRANSFER: {
+    char addr[32];
+    std::snprintf(addr, sizeof(addr), "0X%09" PRIx64, r.Value0);
+    std::string address = std::string(addr) + "|" + tf.str(r.Extra);
+    if (r.Value2)
+      address += "|" + tf.str(r.Value2);
+    rows.push_back({time_str(r.Time), tf.str(r.Name), tf.str(r.Stage), address, to_str(r.Value1),
+                    "", "", "", "", "", "", tf.str(r.Event), tf.str(r.Depend)});
+    break;
+  }
+  case DEPENDENCY:
+    rows.push_back({time_str(r.Time), tf.str(r.Name), tf.str(r.Stage), tf.str(r.Event), tf.str(r.Depend)});
+    break;
+  case DEVICE_KERNEL:
+    rows.push_back({time_str(r.Time), tf.str(r.Name), "START", "", tf.str(r.Extra)});
+    rows.push_back({time_str(r.End), tf.str(r.Name), "END", "", tf.str(r.Extra)});
+    break;
+  case DEVICE_TRANSFER:
+    rows.push_back({time_str(r.Time), tf.str(r.Name), tf.str(r.Stage), tf.str(r.Event),
+                    to_str(static_cast<uint16_t>(r.Value1)), to_str(r.Value2 - r.Value0),
+                    to_str(r.Value0), to_str(r.Value2), to_str(r.Duration),
+                    time_str(r.Time), time_str(r.End)});
+    break;
+  default:
+    throw std::runtime_error("unknown record kind " + std::to_string(r.Kind));
+  }
+}
+
+const std::vector<std::string> csv_labels = {
+  "Time_msec", "Name", "Event", "Address_Port", "Size",
+  "Latency_cycles", "Start_cycles", "End_cycles",
+  "Latency_usec", "Start_msec", "End_msec"
+};
+
+const std::vector<std::string> html_labels = {
+  "Time (msec)", "Name", "Event", "Address/Port",
+  "Size (Bytes or Num)", "Latency (cycles)",
+  "Start (cycles)", "End (cycles)", "Latency (usec)",
+  "Start (msec)", "End (msec)"
+};
+
+void
+write_csv(const trace_file& tf, std::ostream& os)
+{
+  auto& h = tf.header();
+  os << "SDAccel Timeline Trace\n";
+  os << "Generated on: " << tf.str(h.GeneratedOn) << "\n";
+  os << "Msec since Epoch: " << tf.str(h.MsecSinceEpoch) << "\n";
+  if (!tf.str(h.Application).empty())
+    os << "Profiled application: " << tf.str(h.Application) << "\n";
+  os << "Target platform: " << tf.str(h.Platform) << "\n";
+  os << "Tool version: " << tf.str(h.ToolVersion) << "\n";
+
+  os << "\n\n";
+  for (auto& label : csv_labels)
+    os << label << ",";
+  os << "\n";
+
+  std::vector<row_type> rows;
+  for (auto& r : tf) {
+    get_rows(tf, r, rows);
+    for (auto& row : rows) {
+      for (auto& cell : row)
+        os << cell << ",";
+      os << "\n";
+    }
+  }
+
+  os << tf.str(h.Footer);
+}
+
+void
+write_html(const trace_file& tf, std::ostream& os)
+{
+  auto& h = tf.header();
+  os << "<!DOCTYPE html>\n<HTML>\n<BODY>\n";
+  os << "<STYLE>\n" << "\th1 {\n" << "\t\tfont-size:200%;\n" << "\t}\n";
+  os << "\ttable th,tr,td {\n";
+  os << "\t\tborder-collapse: collapse; /* share common border between cells */\n";
+  os << "\t\tpadding: 4px; /* padding within cells */\n";
+  os << "\t\ttable-layout : fixed\n";
+  os << "\t}\n";
+  os << "\ttable th {\n" << "\tbackground-color:lightsteelblue\n" << "\t}\n";
+  os << "</STYLE>\n";
+  os << "<h1>SDAccel Timeline Trace</h1>\n";
+  os << "<br>\n";
+  os << "<h3>Generated on: " << tf.str(h.GeneratedOn) << "</h3>\n";
+  if (!tf.str(h.Application).empty())
+    os << "<h3>Profiled application: " << tf.str(h.Application) << "</h3>\n";
+  os << "<h3>Target platform: " << tf.str(h.Platform) << "</h3>\n";
+  os << "<h3>Tool version: " << tf.str(h.ToolVersion) << "</h3>\n";
+
+  os << "<br>\n<h2></h2>\n\n<TABLE border=\"1\">\n<TR>\n";
+  for (auto& label : html_labels)
+    os << "<TH>" << label << "</TH>\n";
+  os << "</TR>\n";
+
+  std::vector<row_type> rows;
+  for (auto& r : tf) {
+    get_rows(tf, r, rows);
+    for (auto& row : rows) {
+      os << "<TR>";
+      for (auto& cell : row)
+        os << "<TD>" << cell << "</TD>";
+      os << "</TR>\n";
+    }
+  }
+
+  os << "</TABLE>\n</BODY>\n</HTML>\n";
+}
+
+std::string
+json_escape(const std::string& str)
+{
+  std::string out;
+  out.reserve(str.size());
+  for (char c : str) {
+    switch (c) {
+    case '"':  out += "\\\""; break;
+    case '\\': out += "\\\\"; break;
+    case '\n': out += "\\n"; break;
+    case '\t': out += "\\t"; break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        char buf[8];
+        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+        out += buf;
+      }
+      else
+        out += c;
+    }
+  }
+  return out;
+}
+
+////////////////////////////////////////////////////////////////
+// Chrome trace JSON.  START/END pairs become complete events, host
+// activity is process 0 with one lane per command queue or command
+// type, device activity is process 1 with one lane per trace name.
+////////////////////////////////////////////////////////////////
+class chrome_writer
+{
+  std::ostream& m_os;
+  bool m_first = true;
+  std::map<std::pair<int,std::string>, int> m_lanes;
+  std::map<std::pair<uint32_t,uint64_t>, std::vector<double>> m_starts;
+
+  void
+  event(const std::string& json)
+  {
+    m_os << (m_first ? "\n" : ",\n") << json;
+    m_first = false;
+  }
+
+  int
+  lane(int pid, const std::string& name)
+  {
+    auto itr = m_lanes.find(std::make_pair(pid, name));
+    if (itr != m_lanes.end())
+      return itr->second;
+    int tid = m_lanes.size() + 1;
+    m_lanes.emplace(std::make_pair(pid, name), tid);
+    event("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + std::to_string(pid)
+          + ",\"tid\":" + std::to_string(tid)
+          + ",\"args\":{\"name\":\"" + json_escape(name) + "\"}}");
+    return tid;
+  }
+
+  void
+  complete(int pid, int tid, const std::string& name, double start_msec, double end_msec,
+           const std::string& args = "")
+  {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(3)
+       << "{\"name\":\"" << json_escape(name) << "\",\"ph\":\"X\",\"pid\":" << pid
+       << ",\"tid\":" << tid << ",\"ts\":" << start_msec*1000.0
+       << ",\"dur\":" << (end_msec - start_msec)*1000.0;
+    if (!args.empty())
+      ss << ",\"args\":{" << args << "}";
+    ss << "}";
+    event(ss.str());
+  }
+
+  // Pair START and END of the same key, returns false until END
+  bool
+  pair(uint32_t name, uint64_t key, const std::string& stage, double time, double& start)
+  {
+    auto& starts = m_starts[std::make_pair(name, key)];
+    if (stage == "START") {
+      starts.push_back(time);
+      return false;
+    }
+    if (stage != "END" || starts.empty())
+      return false;
+    start = starts.front();
+    starts.erase(starts.begin());
+    return true;
+  }
+
+public:
+  explicit
+  chrome_writer(std::ostream& os)
+    : m_os(os)
+  {
+    m_os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    event("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"Host\"}}");
+    event("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Device\"}}");
+  }
+
+  ~chrome_writer()
+  {
+    m_os << "\n]}\n";
+  }
+
+  void
+  write(const trace_file& tf, const Record& r)
+  {
+    double start = 0.0;
+    auto& stage = tf.str(r.Stage);
+    switch (r.Kind) {
+    case API_CALL: {
+      if (!pair(r.Name, 0, stage, r.Time, start))
+        return;
+      // Name is function|queue
+      auto& name = tf.str(r.Name);
+      auto sep = name.find('|');
+      auto queue = (sep == std::string::npos) ? std::string("General") : name.substr(sep + 1);
+      complete(0, lane(0, "API " + queue), name.substr(0, sep), start, r.Time);
+      break;
+    }
+    case KERNEL:
+      if (!pair(r.Name, r.Value0, stage, r.Time, start))
+        return;
+      complete(0, lane(0, "Kernel Enqueues"), tf.str(r.Name), start, r.Time,
+               "\"event\":\"" + json_escape(tf.str(r.Event)) + "\"");
+      break;
+    case DATA_TRANSFER:
+      if (!pair(r.Name, r.Value0, stage, r.Time, start))
+        return;
+      complete(0, lane(0, tf.str(r.Name)), tf.str(r.Name), start, r.Time,
+               "\"size\":" + std::to_string(r.Value1) + ",\"bank\":\"" + json_escape(tf.str(r.Extra)) + "\"");
+      break;
+    case DEPENDENCY:
+      break;
+    case DEVICE_KERNEL:
+      complete(1, lane(1, tf.str(r.Name)), tf.str(r.Name), r.Time, r.End);
+      break;
+    case DEVICE_TRANSFER:
+      complete(1, lane(1, tf.str(r.Name)), stage, r.Time, r.End,
+               "\"burst\":" + std::to_string(r.Value1));
+      break;
+    default:
+      throw std::runtime_error("unknown record kind " + std::to_string(r.Kind));
+    }
+  }
+};
+
+void
+write_json(const trace_file& tf, std::ostream& os)
+{
+  chrome_writer writer(os);
+  for (auto& r : tf)
+    writer.write(tf, r);
+}
+
+void
+usage()
+{
+  std::cout
+    << "usage: xdptrace [-f csv|html|json] [-o <output>] <trace.bin>\n"
+    << "  Convert binary timeline trace to CSV or HTML timeline, or to\n"
+    << "  Chrome trace JSON.  Default format is csv, default output stdout.\n";
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+  std::string format = "csv";
+  std::string output;
+  std::string input;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if ((arg == "-f" || arg == "-o") && i + 1 < argc) {
+      (arg == "-f" ? format : output) = argv[++i];
+    }
+    else if (arg == "-h" || arg == "--help") {
+      usage();
+      return 0;
+    }
+    else if (input.empty() && arg[0] != '-') {
+      input = arg;
+    }
+    else {
+      usage();
+      return 1;
+    }
+  }
+
+  if (input.empty() || (format != "csv" && format != "html" && format != "json")) {
+    usage();
+    return 1;
+  }
+
+  try {
+    trace_file tf(input);
+
+    std::ofstream ofs;
+    if (!output.empty()) {
+      ofs.open(output);
+      if (!ofs.is_open())
+        throw std::runtime_error("cannot open '" + output + "' for writing");
+    }
+    std::ostream& os = output.empty() ? std::cout : ofs;
+
+    if (format == "csv")
+      write_csv(tf, os);
+    else if (format == "html")
+      write_html(tf, os);
+    else
+      write_json(tf, os);
+  }
+  catch (const std::exception& ex) {
+    std::cerr << "xdptrace: " << ex.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
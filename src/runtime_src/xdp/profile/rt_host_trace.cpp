@@ -0,0 +1,176 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "rt_host_trace.h"
+
+#include <algorithm>
+
+namespace XCL {
+
+  namespace {
+    // Cache of calling thread's buffer, tagged with the unique id of
+    // the owning trace buffer in case more than one is ever created
+    std::atomic<unsigned long> s_next_id {1};
+    thread_local unsigned long t_owner = 0;
+    thread_local void* t_buffer = nullptr;
+  }
+
+  HostTraceBuffer::ThreadBuffer::~ThreadBuffer()
+  {
+    while (Head) {
+      Chunk* next = Head->Next.load();
+      delete Head;
+      Head = next;
+    }
+  }
+
+  HostTraceBuffer::HostTraceBuffer(Classifier classify, Notifier chunkFull)
+  : Id(s_next_id++), Classify(std::move(classify)), ChunkFull(std::move(chunkFull))
+  {
+  }
+
+  HostTraceBuffer::~HostTraceBuffer()
+  {
+    for (auto chunk : FreeChunks)
+      delete chunk;
+  }
+
+  HostTraceBuffer::Chunk* HostTraceBuffer::newChunk()
+  {
+    {
+      std::lock_guard<std::mutex> lock(FreeMutex);
+      if (!FreeChunks.empty()) {
+        Chunk* chunk = FreeChunks.back();
+        FreeChunks.pop_back();
+        return chunk;
+      }
+    }
+    return new Chunk;
+  }
+
+  void HostTraceBuffer::recycle(Chunk* chunk)
+  {
+    chunk->Count.store(0, std::memory_order_relaxed);
+    chunk->Next.store(nullptr, std::memory_order_relaxed);
+    {
+      std::lock_guard<std::mutex> lock(FreeMutex);
+      if (FreeChunks.size() < MAX_FREE_CHUNKS) {
+        FreeChunks.push_back(chunk);
+        return;
+      }
+    }
+    delete chunk;
+  }
+
+  HostTraceBuffer::ThreadBuffer* HostTraceBuffer::getThreadBuffer()
+  {
+    if (t_owner == Id)
+      return static_cast<ThreadBuffer*>(t_buffer);
+
+    auto buffer = new ThreadBuffer;
+    buffer->ThreadId = std::this_thread::get_id();
+    buffer->Head = buffer->Tail = newChunk();
+    {
+      std::lock_guard<std::mutex> lock(Mutex);
+      Buffers.emplace_back(buffer);
+    }
+    t_owner = Id;
+    t_buffer = buffer;
+    return buffer;
+  }
+
+  std::pair<uint32_t,int> HostTraceBuffer::intern(const char* functionName)
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    auto itr = NameIds.find(functionName);
+    if (itr != NameIds.end())
+      return std::make_pair(itr->second, NameTags[itr->second]);
+
+    uint32_t id = Names.size();
+    Names.emplace_back(functionName);
+    NameTags.push_back(Classify(functionName));
+    NameIds.emplace(Names.back(), id);
+    return std::make_pair(id, NameTags[id]);
+  }
+
+  int HostTraceBuffer::log(const char* functionName, long long queueAddress, bool start, double timeStamp)
+  {
+    auto buffer = getThreadBuffer();
+
+    // Names are string literals, so the pointer identifies the name
+    auto itr = buffer->NameCache.find(functionName);
+    if (itr == buffer->NameCache.end())
+      itr = buffer->NameCache.emplace(functionName, intern(functionName)).first;
+
+    Chunk* chunk = buffer->Tail;
+    size_t count = chunk->Count.load(std::memory_order_relaxed);
+    bool full = (count == CHUNK_RECORDS);
+    if (full) {
+      Chunk* next = newChunk();
+      chunk->Next.store(next, std::memory_order_release);
+      buffer->Tail = chunk = next;
+      count = 0;
+    }
+
+    Record& record = chunk->Records[count];
+    record.Time = timeStamp;
+    record.QueueAddress = queueAddress;
+    record.NameId = itr->second.first;
+    record.Start = start;
+    chunk->Count.store(count + 1, std::memory_order_release);
+
+    if (full && ChunkFull)
+      ChunkFull();
+    return itr->second.second;
+  }
+
+  void HostTraceBuffer::drain(const std::function<void(const Event&)>& fn)
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    Entries.clear();
+    for (size_t idx = 0; idx < Buffers.size(); ++idx) {
+      auto& buffer = Buffers[idx];
+
+      // Collect what the owner has published so far.  A chunk with a
+      // successor is full and no longer touched by the owner, so it is
+      // recycled once collected.
+      Chunk* chunk = buffer->Head;
+      while (chunk) {
+        // Next is published after the chunk is full, so load it first
+        Chunk* next = chunk->Next.load(std::memory_order_acquire);
+        size_t count = chunk->Count.load(std::memory_order_acquire);
+        for (size_t i = buffer->DrainedCount; i < count; ++i)
+          Entries.push_back({chunk->Records[i], idx});
+        buffer->DrainedCount = count;
+        if (!next)
+          break;
+        recycle(chunk);
+        buffer->Head = chunk = next;
+        buffer->DrainedCount = 0;
+      }
+    }
+
+    std::stable_sort(Entries.begin(), Entries.end(),
+        [](const Entry& a, const Entry& b) { return a.Rec.Time < b.Rec.Time; });
+
+    for (auto& e : Entries) {
+      Event event {e.Rec.Time, e.Rec.QueueAddress, Names[e.Rec.NameId], e.Rec.NameId,
+                   e.Rec.Start != 0, Buffers[e.Buffer]->ThreadId};
+      fn(event);
+    }
+  }
+
+} // XCL
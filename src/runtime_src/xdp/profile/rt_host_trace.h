@@ -0,0 +1,127 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __XILINX_RT_HOST_TRACE_H
+#define __XILINX_RT_HOST_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace XCL {
+
+  // **************************************************************************
+  // Buffered host API trace
+  //
+  // Each host thread appends compact records to its own chunked buffer
+  // without taking any lock.  Function names are interned once per
+  // thread and recorded by ID.  Records are replayed in time order by
+  // the profiler, whenever a thread fills a chunk and at end of run,
+  // to update counters and write the timeline.  Replayed chunks are
+  // recycled.
+  // **************************************************************************
+  class HostTraceBuffer {
+  public:
+    struct Record {
+      double Time;
+      long long QueueAddress;
+      uint32_t NameId;
+      uint32_t Start;
+    };
+
+    // Replayed event
+    struct Event {
+      double Time;
+      long long QueueAddress;
+      const std::string& Name;
+      uint32_t NameId;
+      bool Start;
+      std::thread::id ThreadId;
+    };
+
+    // Classifier called once per distinct function name, its result
+    // is returned by log() for every call of that function
+    typedef std::function<int(const char*)> Classifier;
+
+    // Called by a logging thread after it has filled a chunk
+    typedef std::function<void()> Notifier;
+
+  public:
+    HostTraceBuffer(Classifier classify, Notifier chunkFull);
+    ~HostTraceBuffer();
+
+    // Append a record to calling thread's buffer, lock free except the
+    // first time a thread logs, the first time it sees a name, and when
+    // it starts a new chunk
+    int log(const char* functionName, long long queueAddress, bool start, double timeStamp);
+
+    // Replay all records appended so far, sorted by time.  Records
+    // are only replayed once.  Must not be called concurrently with
+    // itself.
+    void drain(const std::function<void(const Event&)>& fn);
+
+  private:
+    static const size_t CHUNK_RECORDS = 4096;
+    static const size_t MAX_FREE_CHUNKS = 64;
+
+    struct Chunk {
+      Record Records[CHUNK_RECORDS];
+      std::atomic<size_t> Count {0};
+      std::atomic<Chunk*> Next {nullptr};
+    };
+
+    struct ThreadBuffer {
+      std::thread::id ThreadId;
+      Chunk* Head = nullptr;                                // drain only
+      Chunk* Tail = nullptr;                                // owner thread only
+      size_t DrainedCount = 0;                              // drain only
+      std::unordered_map<const char*, std::pair<uint32_t,int>> NameCache;  // owner thread only
+      ~ThreadBuffer();
+    };
+
+    ThreadBuffer* getThreadBuffer();
+    std::pair<uint32_t,int> intern(const char* functionName);
+    Chunk* newChunk();
+    void recycle(Chunk* chunk);
+
+    struct Entry {
+      Record Rec;
+      size_t Buffer;
+    };
+
+  private:
+    const unsigned long Id;
+    Classifier Classify;
+    Notifier ChunkFull;
+    std::mutex Mutex;  // registration, name table and drain
+    std::mutex FreeMutex;
+    std::vector<Chunk*> FreeChunks;
+    std::vector<Entry> Entries;  // drain only
+    std::vector<std::unique_ptr<ThreadBuffer>> Buffers;
+    std::vector<std::string> Names;
+    std::vector<int> NameTags;
+    std::unordered_map<std::string, uint32_t> NameIds;
+  };
+
+} // XCL
+
+#endif
@@ -40,29 +40,28 @@ namespace XCL {
   template <typename T>
   void TimeTraceSortedTopUsage<T>::push(T* newElement)
   {
-    auto itr = Storage.begin();
-    while (itr != Storage.end()) {
-      if ((*itr)->getDuration() < newElement->getDuration()) {
-        break;
-      }
-      itr++;
-    }
-    if (itr == Storage.end()) {
+    if (Storage.size() < Limit) {
       Storage.push_back(newElement);
+      std::push_heap(Storage.begin(), Storage.end(), longer);
+      return;
     }
-    else {
-      Storage.insert(itr, newElement);
-    }
-    if (Storage.size() > Limit) {
-      T::recycle(Storage.back());
-      Storage.pop_back();
+    // Full: keep the new trace only if it beats the shortest one kept
+    if (Storage.empty() || !longer(newElement, Storage.front())) {
+      T::recycle(newElement);
+      return;
     }
+    std::pop_heap(Storage.begin(), Storage.end(), longer);
+    T::recycle(Storage.back());
+    Storage.back() = newElement;
+    std::push_heap(Storage.begin(), Storage.end(), longer);
   }
 
   template <typename T>
   void TimeTraceSortedTopUsage<T>::writeTopUsageSummary(WriterI* writer) const
   {
-    for (const auto &it : Storage) {
+    std::vector<T*> sorted(Storage);
+    std::stable_sort(sorted.begin(), sorted.end(), longer);
+    for (const auto &it : sorted) {
       it->write(writer);
     }
   }
@@ -23,6 +23,7 @@
 #include <cstdint>
 #include <map>
 #include <list>
+#include <vector>
 #include <string>
 
 //#define BUFFER_STAT_PER_CONTEXT 1
@@ -33,9 +34,10 @@
 namespace XCL {
   class WriterI;
 
-  // Sorted list that keeps top 10 most time taking (end - start) Kernel/Buffer Trace
-  // A simple singly linked list where a linear search is done to ensure sorted
-  // list. This is expected to have at max 10 elements
+  // Keeps top 10 most time taking (end - start) Kernel/Buffer Trace
+  // Stored as a min-heap on duration so the shortest kept trace is at the
+  // front and can be compared/evicted without walking the whole storage.
+  // Traces are sorted only when the summary is written.
   template <typename T>
   class TimeTraceSortedTopUsage {
 
@@ -47,9 +49,15 @@ namespace XCL {
     void push(T* newElement);
     void writeTopUsageSummary(WriterI* writer) const;
 
+  private:
+    static bool longer(const T* a, const T* b)
+    {
+      return a->getDuration() > b->getDuration();
+    }
+
   private:
     size_t Limit;   // Maximum numbers of elements allowed
-    std::list<T*> Storage;
+    std::vector<T*> Storage;
   };
 
   // Performance counters
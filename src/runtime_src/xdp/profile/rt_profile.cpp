@@ -21,12 +21,14 @@
 #include "rt_profile_device.h"
 #include "rt_profile_rule_checks.h"
 #include "rt_perf_counters.h"
+#include "rt_host_trace.h"
 #include "xdp/rt_singleton.h"
 #include "debug.h"
 
 //#include <CL/opencl.h>
 #include "xocl/core/device.h"
 #include "xocl/xclbin/xclbin.h"
+#include "xrt/util/config_reader.h"
 #include "../../driver/include/xclperf.h"
 
 #include <iostream>
@@ -52,13 +54,25 @@ namespace XCL {
     MigrateMemCalls(0),
     FunctionStartLogged(false),
     DeviceTraceOption(DEVICE_TRACE_OFF),
-    StallTraceOption(STALL_TRACE_OFF)
+    StallTraceOption(STALL_TRACE_OFF),
+    HostTrace(nullptr)
   {
     // Create device profiler (may or may not be used during given run)
     DeviceProfile = new RTProfileDevice();
 
     // Profile rule checks
     RuleChecks = new ProfileRuleChecks();
+
+    // API calls are buffered per thread and replayed whenever a thread
+    // fills a chunk, and at end of run
+    if (xrt::config::get_buffered_host_trace())
+      HostTrace = new HostTraceBuffer(
+        [this](const char* name) {
+          return static_cast<int>(getFunctionEventID(name, 0));
+        },
+        [this]() {
+          flushHostTrace(false);
+        });
     
     memset(&CUPortsToDDRBanks, 0, MAX_DDR_BANKS*sizeof(int));
 
@@ -78,6 +92,9 @@ namespace XCL {
     if (RuleChecks != nullptr)
       delete RuleChecks;
 
+    if (HostTrace != nullptr)
+      delete HostTrace;
+
     FinalCounterResultsMap.clear();
     RolloverCounterResultsMap.clear();
     RolloverCountsMap.clear();
@@ -597,6 +614,14 @@ else if (functionName.find("clEnqueueMigrateMemObjects") != std::string::npos)
     double timeStamp = getTraceTime();
 #endif
 
+    if (HostTrace) {
+      FunctionStartLogged = true;
+      auto eventID = static_cast<xclPerfMonEventID>(HostTrace->log(functionName, queueAddress, true, timeStamp));
+      if (eventID != XCL_PERF_MON_IGNORE_EVENT)
+        xdp::profile::platform::write_host_event(XCL::RTSingleton::Instance()->getcl_platform_id(), XCL_PERF_MON_START_EVENT, eventID);
+      return;
+    }
+
     std::string name(functionName);
     if (name.find("MigrateMem") != std::string::npos)
       MigrateMemCalls++;
@@ -631,6 +656,13 @@ else if (functionName.find("clEnqueueMigrateMemObjects") != std::string::npos)
     double timeStamp = getTraceTime();
 #endif
 
+    if (HostTrace) {
+      auto eventID = static_cast<xclPerfMonEventID>(HostTrace->log(functionName, queueAddress, false, timeStamp));
+      if (eventID != XCL_PERF_MON_IGNORE_EVENT)
+        xdp::profile::platform::write_host_event(XCL::RTSingleton::Instance()->getcl_platform_id(), XCL_PERF_MON_END_EVENT, eventID);
+      return;
+    }
+
     std::string name(functionName);
     if (queueAddress == 0)
       name += "|General";
@@ -649,6 +681,58 @@ else if (functionName.find("clEnqueueMigrateMemObjects") != std::string::npos)
     }
   }
 
+  // Replay buffered API calls into counters and timeline trace.
+  // Calls are paired per thread, so concurrent calls of the same
+  // function get their own durations.  Unless wait is set, the replay
+  // is skipped when LogMutex is busy, remaining calls are replayed by
+  // the next flush.
+  void RTProfile::flushHostTrace(bool wait)
+  {
+    if (!HostTrace)
+      return;
+
+    std::unique_lock<std::mutex> lock(LogMutex, std::defer_lock);
+    if (wait)
+      lock.lock();
+    else if (!lock.try_lock())
+      return;
+
+    HostTrace->drain([this](const HostTraceBuffer::Event& e) {
+      // Timeline name is built once per function and queue
+      auto key = std::make_pair(e.NameId, e.QueueAddress);
+      auto itr = HostTraceNames.find(key);
+      if (itr == HostTraceNames.end()) {
+        std::string name(e.Name);
+        if (e.QueueAddress == 0)
+          name += "|General";
+        else
+          (name += "|") += std::to_string(e.QueueAddress);
+        bool migrate = (e.Name.find("MigrateMem") != std::string::npos);
+        itr = HostTraceNames.emplace(key, std::make_pair(std::move(name), migrate)).first;
+      }
+      const char* name = itr->second.first.c_str();
+
+      auto& starts = HostTraceStarts[std::make_pair(e.ThreadId, e.NameId)];
+      if (e.Start) {
+        if (itr->second.second)
+          MigrateMemCalls++;
+        starts.push_back(e.Time);
+        writeTimelineTrace(e.Time, name, "START");
+        return;
+      }
+
+      // An END without START is logged as zero duration
+      double start = e.Time;
+      if (!starts.empty()) {
+        start = starts.back();
+        starts.pop_back();
+      }
+      PerfCounters.logFunctionCallStart(e.Name, start);
+      PerfCounters.logFunctionCallEnd(e.Name, e.Time);
+      writeTimelineTrace(e.Time, name, "END");
+    });
+  }
+
   // Write API call events to trace
   void RTProfile::writeTimelineTrace( double traceTime,
       const char* functionName, const char* eventName) const
@@ -1451,6 +1535,8 @@ else if (functionName.find("clEnqueueMigrateMemObjects") != std::string::npos)
     if(!this->isApplicationProfileOn())
       return;
 
+    flushHostTrace();
+
     for (auto w : Writers) {
       w->writeSummary(this);
     }
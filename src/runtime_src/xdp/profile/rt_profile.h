@@ -43,6 +43,7 @@ namespace XCL {
   class BufferTrace;
   class DeviceTrace;
   class ProfileRuleChecks;
+  class HostTraceBuffer;
 
   // **************************************************************************
   // Top-level profile class
@@ -264,6 +265,7 @@ namespace XCL {
         std::string& stageString) const;
     void setTimeStamp(e_profile_command_state objStage, TimeTrace* traceObject, double timeStamp);
     xclPerfMonEventID getFunctionEventID(const std::string &functionName, long long queueAddress);
+    void flushHostTrace(bool wait = true);
 
     void setArgumentsBank(const std::string& deviceName);
 
@@ -311,6 +313,12 @@ namespace XCL {
     std::mutex LogMutex;
     RTProfileDevice* DeviceProfile;
     ProfileRuleChecks* RuleChecks;
+    // Buffered API call trace (Debug.buffered_host_trace), start
+    // times of replayed calls not yet ended per thread and function,
+    // and timeline name and MigrateMem flag per function and queue
+    HostTraceBuffer* HostTrace;
+    std::map<std::pair<std::thread::id, uint32_t>, std::vector<double>> HostTraceStarts;
+    std::map<std::pair<uint32_t, long long>, std::pair<std::string, bool>> HostTraceNames;
 
   private:
     std::vector<WriterI*> Writers;
@@ -21,6 +21,7 @@
 #include <chrono>
 #include <iomanip>
 #include <algorithm>
+#include <cmath>
 #include <time.h>
 // #include <unistd.h>
 #include "rt_profile_results.h"
@@ -34,6 +35,85 @@ XCL::DeviceTrace* XCL::DeviceTrace::RecycleHead = nullptr;
 
 namespace XCL {
 
+  //
+  // LatencyHistogram
+  //
+
+  // Values below SubBuckets ns map one to one, larger values use the
+  // SubBucketBits bits below their most significant bit
+  unsigned LatencyHistogram::getIndex(uint64_t nsec)
+  {
+    if (nsec < SubBuckets)
+      return static_cast<unsigned>(nsec);
+
+    unsigned msb = 0;
+    for (unsigned step = 32; step > 0; step >>= 1) {
+      if (nsec >> (msb + step))
+        msb += step;
+    }
+    if (msb >= MaxBits)
+      return NumBuckets - 1;
+
+    unsigned shift = msb - SubBucketBits;
+    return (shift + 1) * SubBuckets + static_cast<unsigned>((nsec >> shift) - SubBuckets);
+  }
+
+  uint64_t LatencyHistogram::getLowerBound(unsigned index)
+  {
+    if (index < SubBuckets)
+      return index;
+    unsigned shift = index / SubBuckets - 1;
+    return static_cast<uint64_t>(SubBuckets + index % SubBuckets) << shift;
+  }
+
+  uint64_t LatencyHistogram::getWidth(unsigned index)
+  {
+    return (index < SubBuckets) ? 1 : (1ULL << (index / SubBuckets - 1));
+  }
+
+  void LatencyHistogram::add(double duration)
+  {
+    if (Buckets.empty())
+      Buckets.resize(NumBuckets, 0);
+
+    uint64_t nsec = (duration > 0.0) ? static_cast<uint64_t>(duration * 1.0e6 + 0.5) : 0;
+    Buckets[getIndex(nsec)]++;
+    Count++;
+    if (MinNsec > nsec)
+      MinNsec = nsec;
+    if (MaxNsec < nsec)
+      MaxNsec = nsec;
+  }
+
+  // Report the middle of the bucket holding the requested rank, clamped
+  // to the exact extremes so p0/p100 are never outside the samples
+  double LatencyHistogram::getPercentile(double pct) const
+  {
+    if (Count == 0)
+      return 0.0;
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(pct / 100.0 * Count));
+    if (rank < 1)
+      rank = 1;
+    if (rank >= Count)
+      return MaxNsec / 1.0e6;
+
+    uint64_t seen = 0;
+    unsigned index = 0;
+    for (; index < NumBuckets; ++index) {
+      seen += Buckets[index];
+      if (seen >= rank)
+        break;
+    }
+
+    uint64_t nsec = getLowerBound(index) + getWidth(index) / 2;
+    if (index == NumBuckets - 1 || nsec > MaxNsec)
+      nsec = MaxNsec;
+    if (nsec < MinNsec)
+      nsec = MinNsec;
+    return nsec / 1.0e6;
+  }
+
   //
   // BufferStats
   //
@@ -48,6 +128,7 @@ namespace XCL {
     // by ms duration to get MB/s
     double transferRate = (size / (1000.0 * duration));
     AveTransferRate = (AveTransferRate * Count + transferRate) / (Count + 1);
+    Histogram.add(duration);
     Count++;
     if (Max < size)
       Max = size;
@@ -76,6 +157,7 @@ namespace XCL {
     double time = EndTime - StartTime;
     TotalTime += time;
     AveTime = (AveTime * NoOfCalls + time) / (NoOfCalls + 1);
+    Histogram.add(time);
     NoOfCalls++;
     if (MaxTime < time)
       MaxTime = time;
@@ -36,6 +36,43 @@
 namespace XCL {
   class WriterI;
 
+  // Fixed-memory log-bucketed latency histogram used for percentiles
+  // Samples are kept in ns: every power of two is split into SubBuckets
+  // linear buckets so a reported percentile is within 1/SubBuckets of the
+  // true value. Buckets are allocated on the first sample and never grow.
+  class LatencyHistogram {
+  public:
+    static const unsigned SubBucketBits = 4;
+    static const unsigned SubBuckets = 1 << SubBucketBits;
+    // Largest distinct bucket covers 2^MaxBits ns (~4.9 hours)
+    static const unsigned MaxBits = 44;
+    static const unsigned NumBuckets = (MaxBits - SubBucketBits + 1) * SubBuckets;
+
+  public:
+    LatencyHistogram()
+      : Count( 0 ),
+        MinNsec( (std::numeric_limits<uint64_t>::max)() ),
+        MaxNsec( 0 )
+      {};
+  public:
+    // Duration in ms
+    void add(double duration);
+    // Value at percentile pct (0-100] in ms, 0 if no samples
+    double getPercentile(double pct) const;
+    inline uint64_t getCount() const { return Count; }
+
+  private:
+    static unsigned getIndex(uint64_t nsec);
+    static uint64_t getLowerBound(unsigned index);
+    static uint64_t getWidth(unsigned index);
+
+  private:
+    uint64_t Count;
+    uint64_t MinNsec;
+    uint64_t MaxNsec;
+    std::vector<uint64_t> Buckets;
+  };
+
   // Class to record stats on buffer read and writes
   // All sizes are in bytes and times are in ms
   class BufferStats {
@@ -80,6 +117,7 @@ namespace XCL {
     }
     inline double getClockFreqMhz() const { return ClockFreqMhz; }
     inline std::string getDeviceName() const { return DeviceName; }
+    inline const LatencyHistogram& getHistogram() const { return Histogram; }
 
     inline void setContextId(uint32_t contextId) { ContextId = contextId; }
     inline void setNumDevices(uint32_t numDevices) { NumDevices = numDevices; }
@@ -102,6 +140,7 @@ namespace XCL {
     double AveTransferRate;
     double ClockFreqMhz;
     std::string DeviceName;
+    LatencyHistogram Histogram;
   };
 
   // Class to record stats on time such as time spent in an API call
@@ -131,6 +170,8 @@ namespace XCL {
     inline double getMinTime() const {return MinTime; }
     inline uint32_t getNoOfCalls() const {return NoOfCalls; }
     inline uint32_t getClockFreqMhz() const { return ClockFreqMhz; }
+    // Percentiles are only known for calls timed with logStart/logEnd
+    inline const LatencyHistogram& getHistogram() const { return Histogram; }
   private:
     double TotalTime;
     double StartTime;
@@ -140,6 +181,7 @@ namespace XCL {
     double MinTime;
     uint32_t NoOfCalls;
     uint32_t ClockFreqMhz;
+    LatencyHistogram Histogram;
   };
 
   // Class to store time trace of kernel execution, buffer read, or buffer write
@@ -112,7 +112,8 @@ namespace XCL {
     //Table 1: API Call summary
     std::vector<std::string> APICallSummaryColumnLabels = { "API Name",
         "Number Of Calls", "Total Time (ms)", "Minimum Time (ms)",
-        "Average Time (ms)", "Maximum Time (ms)" };
+        "Average Time (ms)", "Maximum Time (ms)",
+        "P50 Time (ms)", "P99 Time (ms)", "P99.9 Time (ms)" };
 
     writeTableHeader(getSummaryStream(), "OpenCL API Calls", APICallSummaryColumnLabels);
     profile->writeAPISummary(this);
@@ -121,7 +122,8 @@ namespace XCL {
     // Table 2: Kernel Execution Summary
     std::vector<std::string> KernelExecutionSummaryColumnLabels = {
         "Kernel", "Number Of Enqueues", "Total Time (ms)",
-        "Minimum Time (ms)", "Average Time (ms)", "Maximum Time (ms)" };
+        "Minimum Time (ms)", "Average Time (ms)", "Maximum Time (ms)",
+        "P50 Time (ms)", "P99 Time (ms)", "P99.9 Time (ms)" };
 
     std::string table2Caption = (flowMode == XCL::RTSingleton::HW_EM) ?
         "Kernel Execution (includes estimated device times)" : "Kernel Execution";
@@ -170,7 +172,8 @@ namespace XCL {
     std::vector<std::string> DataTransferSummaryColumnLabels = {
         "Context:Number of Devices", "Transfer Type", "Number Of Transfers",
         "Transfer Rate (MB/s)", "Average Bandwidth Utilization (%)",
-        "Average Size (KB)", "Total Time (ms)", "Average Time (ms)"
+        "Average Size (KB)", "Total Time (ms)", "Average Time (ms)",
+        "P50 Time (ms)", "P99 Time (ms)", "P99.9 Time (ms)"
     };
     writeTableHeader(getSummaryStream(), "Data Transfer: Host and Global Memory",
         DataTransferSummaryColumnLabels);
@@ -206,14 +209,26 @@ namespace XCL {
     writeTableFooter(getSummaryStream());
   }
 
+  // Percentile cell of a latency histogram, N/A when no samples were timed
+  std::string WriterI::getPercentileStr(const LatencyHistogram& histogram, double pct)
+  {
+    if (histogram.getCount() == 0)
+      return "N/A";
+    return std::to_string(histogram.getPercentile(pct));
+  }
+
   // Tables 1 and 2: API Call and Kernel Execution Summary: Name, Number Of Calls,
-  // Total Time (ms), Minimum Time (ms), Average Time (ms), Maximum Time (ms)
+  // Total Time (ms), Minimum Time (ms), Average Time (ms), Maximum Time (ms),
+  // P50/P99/P99.9 Time (ms)
   void WriterI::writeSummary(const std::string& name, const TimeStats& stats)
   {
+    const LatencyHistogram& histogram = stats.getHistogram();
     writeTableRowStart(getSummaryStream());
     writeTableCells(getSummaryStream(), name, stats.getNoOfCalls(),
         stats.getTotalTime(), stats.getMinTime(),
-        stats.getAveTime(), stats.getMaxTime());
+        stats.getAveTime(), stats.getMaxTime(),
+        getPercentileStr(histogram, 50.0), getPercentileStr(histogram, 99.0),
+        getPercentileStr(histogram, 99.9));
     writeTableRowEnd(getSummaryStream());
   }
 
@@ -228,7 +243,7 @@ namespace XCL {
 
   // Table 4: Data Transfer: Host & Global Memory
   // Context ID, Transfer Type, Number Of Transfers, Transfer Rate (MB/s),
-  // Average Size (KB), Total Time (ms), Average Time (ms)
+  // Average Size (KB), Total Time (ms), Average Time (ms), P50/P99/P99.9 Time (ms)
   void WriterI::writeHostTransferSummary(const std::string& name,
       const BufferStats& stats, uint64_t totalBytes, uint64_t totalTranx,
       double totalTimeMsec, double maxTransferRateMBps)
@@ -265,11 +280,17 @@ namespace XCL {
     std::string aveBWUtilStr = std::to_string(aveBWUtil);
     std::string totalTimeStr = std::to_string(totalTimeMsec);
     std::string aveTimeStr = std::to_string(aveTimeMsec);
+    std::string p50TimeStr = getPercentileStr(stats.getHistogram(), 50.0);
+    std::string p99TimeStr = getPercentileStr(stats.getHistogram(), 99.0);
+    std::string p999TimeStr = getPercentileStr(stats.getHistogram(), 99.9);
     if (XCL::RTSingleton::Instance()->getFlowMode() == XCL::RTSingleton::HW_EM) {
       transferRateStr = "N/A";
       aveBWUtilStr = "N/A";
       totalTimeStr = "N/A";
       aveTimeStr = "N/A";
+      p50TimeStr = "N/A";
+      p99TimeStr = "N/A";
+      p999TimeStr = "N/A";
     }
 
     std::string contextDevices = "context" + std::to_string(stats.getContextId())
@@ -277,7 +298,8 @@ namespace XCL {
 
     writeTableRowStart(getSummaryStream());
     writeTableCells(getSummaryStream(), contextDevices, name, totalTranx,
-        transferRateStr, aveBWUtilStr, aveBytes/1000.0, totalTimeStr, aveTimeStr);
+        transferRateStr, aveBWUtilStr, aveBytes/1000.0, totalTimeStr, aveTimeStr,
+        p50TimeStr, p99TimeStr, p999TimeStr);
 
     writeTableRowEnd(getSummaryStream());
   }
@@ -692,6 +714,80 @@ namespace XCL {
   }
 
   // Functions for device trace
+  // Name and argument names of a device trace row, false if the
+  // row is not shown
+  bool WriterI::getDeviceTraceName(const DeviceTrace& tr, std::string deviceName,
+      const std::string& binaryName, std::string& traceName,
+      std::string& argNames, std::string& workGroupSize)
+  {
+    auto rts = XCL::RTSingleton::Instance();
+    bool showKernelCUNames = true;
+    bool showPortName = false;
+    uint32_t ddrBank;
+    std::string cuName;
+    argNames.clear();
+    workGroupSize.clear();
+
+    // Populate trace name string
+    if (tr.Kind == DeviceTrace::DEVICE_KERNEL) {
+      if (tr.Type == "Kernel") {
+        traceName = "KERNEL";
+      } else if (tr.Type.find("Stall") != std::string::npos) {
+        traceName = "Kernel_Stall";
+        showPortName = false;
+      } else if (tr.Type == "Write") {
+        showPortName = true;
+        traceName = "Kernel_Write";
+      } else {
+        showPortName = true;
+        traceName = "Kernel_Read";
+      }
+    }
+    else {
+      showKernelCUNames = false;
+      if (tr.Type == "Write")
+        traceName = "Host_Write";
+      else
+        traceName = "Host_Read";
+    }
+
+    traceName += ("|" + deviceName + "|" + binaryName);
+
+    if (showKernelCUNames || showPortName) {
+      std::string portName;
+      std::string cuPortName;
+      if (tr.Kind == DeviceTrace::DEVICE_KERNEL && (tr.Type == "Kernel" || tr.Type.find("Stall") != std::string::npos)) {
+        rts->getProfileSlotName(XCL_PERF_MON_ACCEL, deviceName, tr.SlotNum, cuName);
+      }
+      else {
+        rts->getProfileSlotName(XCL_PERF_MON_MEMORY, deviceName, tr.SlotNum, cuPortName);
+        cuName = cuPortName.substr(0, cuPortName.find_first_of("/"));
+        portName = cuPortName.substr(cuPortName.find_first_of("/")+1);
+        std::transform(portName.begin(), portName.end(), portName.begin(), ::tolower);
+      }
+      std::string kernelName;
+      XCL::RTSingleton::Instance()->getProfileKernelName(deviceName, cuName, kernelName);
+
+      if (showKernelCUNames)
+        traceName += ("|" + kernelName + "|" + cuName);
+
+      if (showPortName) {
+        rts->getProfileManager()->getArgumentsBank(deviceName, cuName, portName, argNames, ddrBank);
+        traceName += ("|" + portName + "|" + std::to_string(ddrBank));
+      }
+    }
+
+    if (tr.Type == "Kernel") {
+      rts->getProfileManager()->getTraceStringFromComputeUnit(deviceName, cuName, traceName);
+      if (traceName.empty())
+        return false;
+      size_t pos = traceName.find_last_of("|");
+      workGroupSize = traceName.substr(pos + 1);
+      traceName = traceName.substr(0, pos);
+    }
+    return true;
+  }
+
   void WriterI::writeDeviceTrace(const RTProfileDevice::TraceResultVector &resultVector,
       std::string deviceName, std::string binaryName)
   {
@@ -722,70 +818,13 @@ namespace XCL {
       std::stringstream endStr;
       endStr << std::setprecision(10) << tr.End;
 
-      bool showKernelCUNames = true;
-      bool showPortName = false;
-      uint32_t ddrBank;
       std::string traceName;
-      std::string cuName;
       std::string argNames;
-
-      // Populate trace name string
-      if (tr.Kind == DeviceTrace::DEVICE_KERNEL) {
-        if (tr.Type == "Kernel") {
-          traceName = "KERNEL";
-        } else if (tr.Type.find("Stall") != std::string::npos) {
-          traceName = "Kernel_Stall";
-          showPortName = false;
-        } else if (tr.Type == "Write") {
-          showPortName = true;
-          traceName = "Kernel_Write";
-        } else {
-          showPortName = true;
-          traceName = "Kernel_Read";
-        }
-      }
-      else {
-        showKernelCUNames = false;
-        if (tr.Type == "Write")
-          traceName = "Host_Write";
-        else
-          traceName = "Host_Read";
-      }
-
-      traceName += ("|" + deviceName + "|" + binaryName);
-
-      if (showKernelCUNames || showPortName) {
-        std::string portName;
-        std::string cuPortName;
-        if (tr.Kind == DeviceTrace::DEVICE_KERNEL && (tr.Type == "Kernel" || tr.Type.find("Stall") != std::string::npos)) {
-          rts->getProfileSlotName(XCL_PERF_MON_ACCEL, deviceName, tr.SlotNum, cuName);
-        }
-        else {
-          rts->getProfileSlotName(XCL_PERF_MON_MEMORY, deviceName, tr.SlotNum, cuPortName);
-          cuName = cuPortName.substr(0, cuPortName.find_first_of("/"));
-          portName = cuPortName.substr(cuPortName.find_first_of("/")+1);
-          std::transform(portName.begin(), portName.end(), portName.begin(), ::tolower);
-        }
-        std::string kernelName;
-        XCL::RTSingleton::Instance()->getProfileKernelName(deviceName, cuName, kernelName);
-
-        if (showKernelCUNames)
-          traceName += ("|" + kernelName + "|" + cuName);
-
-        if (showPortName) {
-          rts->getProfileManager()->getArgumentsBank(deviceName, cuName, portName, argNames, ddrBank);
-          traceName += ("|" + portName + "|" + std::to_string(ddrBank));
-        }
-      }
+      std::string workGroupSize;
+      if (!getDeviceTraceName(tr, deviceName, binaryName, traceName, argNames, workGroupSize))
+        continue;
 
       if (tr.Type == "Kernel") {
-        std::string workGroupSize;
-        rts->getProfileManager()->getTraceStringFromComputeUnit(deviceName, cuName, traceName);
-        if (traceName.empty()) continue;
-        size_t pos = traceName.find_last_of("|");
-        workGroupSize = traceName.substr(pos + 1);
-        traceName = traceName.substr(0, pos);
-        
         writeTableRowStart(getTimelineStream());
         writeTableCells(getTimelineStream(), startStr.str(), traceName, "START", "", workGroupSize);
         writeTableRowEnd(getTimelineStream());
@@ -1171,11 +1210,8 @@ namespace XCL {
     }
   }
 
-  void CSVWriter::writeTimelineFooter(std::ofstream& ofs)
+  void CSVWriter::writeTimelineFooter(std::ostream& ofs)
   {
-    if (!ofs.is_open())
-      return;
-
     auto rts = XCL::RTSingleton::Instance();
     auto profile = rts->getProfileManager();
 
@@ -1264,7 +1300,8 @@ namespace XCL {
 
     ofs << "Footer,end\n";
 
-    writeDocumentFooter(ofs);
+    // Document footer
+    ofs << "\n";
   }
   
   // ******************
@@ -1301,7 +1338,8 @@ namespace XCL {
     // Table 1: Software Functions
     std::vector<std::string> SoftwareFunctionColumnLabels = { 
         "Function", "Number Of Calls", "Total Time (ms)", "Minimum Time (ms)",
-        "Average Time (ms)", "Maximum Time (ms)" };
+        "Average Time (ms)", "Maximum Time (ms)",
+        "P50 Time (ms)", "P99 Time (ms)", "P99.9 Time (ms)" };
 
     writeTableHeader(getSummaryStream(), "Software Functions", SoftwareFunctionColumnLabels);
     profile->writeAPISummary(this);
@@ -1310,7 +1348,8 @@ namespace XCL {
     // Table 2: Hardware Functions
     std::vector<std::string> HardwareFunctionColumnLabels = {
         "Function", "Number Of Calls", "Total Time (ms)", "Minimum Time (ms)", 
-        "Average Time (ms)", "Maximum Time (ms)" };
+        "Average Time (ms)", "Maximum Time (ms)",
+        "P50 Time (ms)", "P99 Time (ms)", "P99.9 Time (ms)" };
 
     std::string table2Caption = (XCL::RTSingleton::Instance()->getFlowMode() == XCL::RTSingleton::HW_EM) ?
         "Hardware Functions (includes estimated device times)" : "Hardware Functions";
@@ -1366,7 +1405,8 @@ namespace XCL {
     // Table 7: Data Transfer: Host and DDR Memory
     std::vector<std::string> HostTransferColumnLabels = {
         "Transfer Type", "Number Of Transfers", "Transfer Rate (MB/s)", 
-        "Average Bandwidth Utilization (%)", "Average Size (KB)", "Average Time (ms)"
+        "Average Bandwidth Utilization (%)", "Average Size (KB)", "Average Time (ms)",
+        "P50 Time (ms)", "P99 Time (ms)", "P99.9 Time (ms)"
     };
     writeTableHeader(getSummaryStream(), "Data Transfer: Host and DDR Memory",
         HostTransferColumnLabels);
@@ -1526,7 +1566,8 @@ namespace XCL {
 
   // Table 7: Data Transfer: Host & DDR Memory
   // Transfer Type, Number Of Transfers, Transfer Rate (MB/s),
-  // Average Bandwidth Utilization (%), Average Size (KB), Average Time (ms)
+  // Average Bandwidth Utilization (%), Average Size (KB), Average Time (ms),
+  // P50/P99/P99.9 Time (ms)
   void UnifiedCSVWriter::writeHostTransferSummary(const std::string& name,
       const BufferStats& stats, uint64_t totalBytes, uint64_t totalTranx,
       double totalTimeMsec, double maxTransferRateMBps)
@@ -1563,19 +1604,128 @@ namespace XCL {
     std::string aveBWUtilStr = std::to_string(aveBWUtil);
     std::string totalTimeStr = std::to_string(totalTimeMsec);
     std::string aveTimeStr = std::to_string(aveTimeMsec);
+    std::string p50TimeStr = getPercentileStr(stats.getHistogram(), 50.0);
+    std::string p99TimeStr = getPercentileStr(stats.getHistogram(), 99.0);
+    std::string p999TimeStr = getPercentileStr(stats.getHistogram(), 99.9);
     if (XCL::RTSingleton::Instance()->getFlowMode() == XCL::RTSingleton::HW_EM) {
       transferRateStr = "N/A";
       aveBWUtilStr = "N/A";
       totalTimeStr = "N/A";
       aveTimeStr = "N/A";
+      p50TimeStr = "N/A";
+      p99TimeStr = "N/A";
+      p999TimeStr = "N/A";
     }
 
     writeTableRowStart(getSummaryStream());
     writeTableCells(getSummaryStream(), name, totalTranx, transferRateStr, 
-        aveBWUtilStr, aveBytes/1000.0, aveTimeStr);
+        aveBWUtilStr, aveBytes/1000.0, aveTimeStr, p50TimeStr, p99TimeStr, p999TimeStr);
 
     writeTableRowEnd(getSummaryStream());
   }
-}
 
+  // *************
+  // Binary Writer
+  // *************
+  BinaryWriter::BinaryWriter(const std::string& timelineFileName,
+      const std::string& platformName) :
+        TimelineFileName(timelineFileName),
+        PlatformName(platformName)
+  {
+    Binary.setDocumentHeader(WriterI::getCurrentDateTime(), WriterI::getCurrentTimeMsec(),
+        WriterI::getCurrentExecutableName(), PlatformName, getToolVersion());
+
+    if (TimelineFileName != "") {
+      TimelineFileName += FileExtension;
+      if (!Binary.open(TimelineFileName))
+        throw std::runtime_error("Unable to open binary timeline trace for writing");
+    }
+  }
+
+  BinaryWriter::~BinaryWriter()
+  {
+    if (!Binary.isOpen())
+      return;
 
+    std::stringstream footer;
+    CSVWriter::writeTimelineFooter(footer);
+    Binary.setFooter(footer.str());
+    Binary.close();
+  }
+
+  void BinaryWriter::writeTimeline(double time, const std::string& functionName,
+      const std::string& eventName)
+  {
+    Binary.writeApiCall(time, functionName, eventName);
+  }
+
+  void BinaryWriter::writeTimeline(double traceTime, const std::string& commandString,
+            const std::string& stageString, const std::string& eventString,
+            const std::string& dependString, uint64_t objId, size_t size)
+  {
+    Binary.writeKernel(traceTime, commandString, stageString, eventString,
+        dependString, objId, size);
+  }
+
+  void BinaryWriter::writeTimeline(double traceTime, const std::string& commandString,
+            const std::string& stageString, const std::string& eventString,
+            const std::string& dependString, size_t size, uint64_t address,
+            const std::string& bank, std::thread::id threadId)
+  {
+    // Thread ID is only valid for START and END, formatted once per thread
+    static const std::string noThread;
+    const std::string* threadStr = &noThread;
+    if (stageString == "START" || stageString == "END") {
+      auto itr = ThreadStrings.find(threadId);
+      if (itr == ThreadStrings.end()) {
+        std::stringstream ss;
+        ss << std::showbase << std::hex << std::uppercase << threadId;
+        itr = ThreadStrings.emplace(threadId, ss.str()).first;
+      }
+      threadStr = &itr->second;
+    }
+    Binary.writeDataTransfer(traceTime, commandString, stageString, eventString,
+        dependString, size, address, bank, *threadStr);
+  }
+
+  void BinaryWriter::writeTimeline(double traceTime, const std::string& commandString,
+            const std::string& stageString, const std::string& eventString,
+            const std::string& dependString)
+  {
+    Binary.writeDependency(traceTime, commandString, stageString, eventString,
+        dependString);
+  }
+
+  void BinaryWriter::writeDeviceTrace(const RTProfileDevice::TraceResultVector &resultVector,
+      std::string deviceName, std::string binaryName)
+  {
+    if (!Binary.isOpen())
+      return;
+
+    auto rts = XCL::RTSingleton::Instance();
+    double deviceClockDurationUsec = (1.0 / (rts->getProfileManager()->getKernelClockFreqMHz(deviceName)));
+
+    for (auto& tr : resultVector) {
+#ifndef XDP_VERBOSE
+      if (tr.Kind == DeviceTrace::DEVICE_BUFFER)
+        continue;
+#endif
+
+      std::string traceName;
+      std::string argNames;
+      std::string workGroupSize;
+      if (!getDeviceTraceName(tr, deviceName, binaryName, traceName, argNames, workGroupSize))
+        continue;
+
+      if (tr.Type == "Kernel") {
+        Binary.writeDeviceKernel(tr.Start, tr.End, traceName, workGroupSize);
+        continue;
+      }
+
+      double deviceDuration = 1000.0*(tr.End - tr.Start);
+      if (!(deviceDuration > 0.0)) deviceDuration = deviceClockDurationUsec;
+      Binary.writeDeviceTransfer(tr.Start, tr.End, traceName, tr.Type, argNames,
+          deviceDuration, tr.StartTime, tr.EndTime, tr.BurstLength);
+    }
+  }
+}
@@ -21,6 +21,7 @@
 #include <limits>
 #include <cstdint>
 #include <map>
+#include <unordered_map>
 #include <list>
 #include <vector>
 #include <string>
@@ -34,6 +35,7 @@
 #include <CL/opencl.h>
 #include "rt_profile_device.h"
 #include "rt_profile_rule_checks.h"
+#include "rt_trace_writer.h"
 
 // Use this class to build run time user services functions
 // such as debugging and profiling
@@ -92,18 +94,18 @@ namespace XCL {
 
 	    // Functions for timeline trace log
 	    // Write timeline trace of a function call such as cl API call
-	    void writeTimeline(double time, const std::string& functionName,
+	    virtual void writeTimeline(double time, const std::string& functionName,
 	        const std::string& eventName);
 	    // Write timeline trace of Kernel execution
-	    void writeTimeline(double traceTime, const std::string& commandString,
+	    virtual void writeTimeline(double traceTime, const std::string& commandString,
             const std::string& stageString, const std::string& eventString,
             const std::string& dependString, uint64_t objId, size_t size);
 	    // Write timeline trace of read/write of buffer
-	    void writeTimeline(double traceTime, const std::string& commandString,
+	    virtual void writeTimeline(double traceTime, const std::string& commandString,
             const std::string& stageString, const std::string& eventString,
             const std::string& dependString, size_t size, uint64_t address,
             const std::string& bank, std::thread::id threadId);
-	    void writeTimeline(double traceTime, const std::string& commandString,
+	    virtual void writeTimeline(double traceTime, const std::string& commandString,
             const std::string& stageString, const std::string& eventString,
             const std::string& dependString);
 
@@ -112,7 +114,7 @@ namespace XCL {
 		      double timestamp, uint32_t sampleNum, bool firstReadAfterProgram);
 
 	    // Functions for device trace
-	    void writeDeviceTrace(const RTProfileDevice::TraceResultVector &resultVector,
+	    virtual void writeDeviceTrace(const RTProfileDevice::TraceResultVector &resultVector,
 	        std::string deviceName, std::string binaryName);
 
 	    // Function for profile rule checks
@@ -146,6 +148,16 @@ namespace XCL {
 		    writeTableCells(ofs, args...);
 		}
 
+	protected:
+	    static std::string getPercentileStr(const LatencyHistogram& histogram, double pct);
+
+	protected:
+	    // Name and argument names of a device trace row, false if the
+	    // row is not shown.  Kernel rows also return work group size.
+	    bool getDeviceTraceName(const DeviceTrace& tr, std::string deviceName,
+	        const std::string& binaryName, std::string& traceName,
+	        std::string& argNames, std::string& workGroupSize);
+
 	protected:
 	    void openStream(std::ofstream& ofs, const std::string& fileName);
 	    std::ofstream& getSummaryStream() {return Summary_ofs;}
@@ -200,7 +212,10 @@ namespace XCL {
 	    void writeTableRowEnd(std::ofstream& ofs) override { ofs << "\n";}
 	    void writeTableFooter(std::ofstream& ofs) override { ofs << "\n";};
 	    void writeDocumentFooter(std::ofstream& ofs) override;
-	    void writeTimelineFooter(std::ofstream& ofs);
+
+	public:
+	    // Footer of timeline trace, also stored by the binary writer
+	    static void writeTimelineFooter(std::ostream& ofs);
 
 	    // Cell and Row marking tokens
 	    const char* cellStart() override { return ""; }
@@ -300,6 +315,48 @@ namespace XCL {
       const std::string FileExtension = ".html";
     };
 
+    //
+    // Binary Writer
+    //
+    // Timeline trace only, as fixed size records with a string table,
+    // see rt_trace_format.h.  Convert with xdptrace.
+    //
+    class BinaryWriter: public WriterI {
+
+	public:
+      BinaryWriter(const std::string& timelineFileName, const std::string& platformName);
+	    ~BinaryWriter();
+
+	    // Summary is written by the other writers
+	    void writeSummary(RTProfile* profile) override {}
+
+	    void writeTimeline(double time, const std::string& functionName,
+	        const std::string& eventName) override;
+	    void writeTimeline(double traceTime, const std::string& commandString,
+            const std::string& stageString, const std::string& eventString,
+            const std::string& dependString, uint64_t objId, size_t size) override;
+	    void writeTimeline(double traceTime, const std::string& commandString,
+            const std::string& stageString, const std::string& eventString,
+            const std::string& dependString, size_t size, uint64_t address,
+            const std::string& bank, std::thread::id threadId) override;
+	    void writeTimeline(double traceTime, const std::string& commandString,
+            const std::string& stageString, const std::string& eventString,
+            const std::string& dependString) override;
+	    void writeDeviceTrace(const RTProfileDevice::TraceResultVector &resultVector,
+	        std::string deviceName, std::string binaryName) override;
+
+	protected:
+	    void writeTableHeader(std::ofstream& ofs, const std::string& caption,
+	        const std::vector<std::string>& columnLabels) override {}
+
+	private:
+	    std::string TimelineFileName;
+	    std::string PlatformName;
+	    trace::FileWriter Binary;
+	    std::map<std::thread::id, std::string> ThreadStrings;
+	    const std::string FileExtension = ".bin";
+    };
+
 };
 #endif
 
@@ -0,0 +1,106 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __XILINX_RT_TRACE_FORMAT_H
+#define __XILINX_RT_TRACE_FORMAT_H
+
+#include <cstdint>
+
+// Binary timeline trace format
+//
+// This header is shared by the runtime writer and the offline
+// converter, it must not depend on anything but the standard library.
+//
+// File layout, all values little endian as written by the host:
+//
+//   FileHeader
+//   Record[RecordCount]             at FileHeader::RecordOffset
+//   string table                    at FileHeader::StringOffset
+//
+// The string table is StringCount entries of a uint32_t length
+// followed by that many bytes, no terminator.  String ID 0 is always
+// the empty string.  Records refer to strings by ID.
+//
+// Records are streamed while the run is in progress.  The string
+// table and the counts in the header are written when the writer is
+// closed, a file with RecordCount and StringCount 0 is incomplete.
+
+namespace XCL { namespace trace {
+
+  const char MAGIC[8] = {'X','D','P','T','R','A','C','E'};
+  const uint32_t VERSION = 1;
+
+  // Record kinds, one per timeline row shape
+  enum e_record_kind : uint16_t {
+    // Name=function|queue, Stage=START/END
+    API_CALL = 1,
+    // Name=command, Stage, Event, Depend, Value0=object id, Value1=size
+    KERNEL = 2,
+    // Name=command, Stage, Event, Depend, Extra=bank, Value0=address,
+    // Value1=size, Value2=thread string ID (0 if none)
+    DATA_TRANSFER = 3,
+    // Name=command, Stage, Event, Depend
+    DEPENDENCY = 4,
+    // Device kernel row, Time=start, End=end, Name=trace name,
+    // Extra=work group size
+    DEVICE_KERNEL = 5,
+    // Device transfer or stall row, Time=start, End=end, Name=trace name,
+    // Stage=type, Event=argument names, Value0=start cycles,
+    // Value1=burst length, Value2=end cycles, Duration=latency usec
+    DEVICE_TRANSFER = 6
+  };
+
+  struct FileHeader {
+    char Magic[8];
+    uint32_t Version;
+    uint32_t RecordSize;
+    uint64_t RecordOffset;
+    uint64_t RecordCount;
+    uint64_t StringOffset;
+    uint64_t StringCount;
+    // String IDs of document header values
+    uint32_t GeneratedOn;
+    uint32_t MsecSinceEpoch;
+    uint32_t Application;
+    uint32_t Platform;
+    uint32_t ToolVersion;
+    // String ID of footer written at end of run, CSV text
+    uint32_t Footer;
+  };
+
+  // Fixed size record, see e_record_kind for the meaning of each field
+  struct Record {
+    uint16_t Kind;
+    uint16_t Reserved;
+    uint32_t Name;
+    uint32_t Stage;
+    uint32_t Event;
+    uint32_t Depend;
+    uint32_t Extra;
+    double Time;      // msec
+    double End;       // msec
+    double Duration;  // usec
+    uint64_t Value0;
+    uint64_t Value1;
+    uint64_t Value2;
+  };
+
+  static_assert(sizeof(FileHeader) == 72, "trace file header layout changed");
+  static_assert(sizeof(Record) == 72, "trace record layout changed");
+
+}} // trace,XCL
+
+#endif
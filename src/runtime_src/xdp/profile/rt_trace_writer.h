@@ -0,0 +1,228 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __XILINX_RT_TRACE_WRITER_H
+#define __XILINX_RT_TRACE_WRITER_H
+
+#include "rt_trace_format.h"
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Writer of the binary timeline trace format in rt_trace_format.h
+//
+// Encodes one record per timeline row shape.  Used by the runtime
+// BinaryWriter, and like the format it depends on nothing but the
+// standard library so that the encoding can be tested against the
+// offline converter.
+
+namespace XCL { namespace trace {
+
+  class FileWriter {
+  public:
+    FileWriter()
+    {
+      std::memset(&Header, 0, sizeof(Header));
+      std::memcpy(Header.Magic, MAGIC, sizeof(Header.Magic));
+      Header.Version = VERSION;
+      Header.RecordSize = sizeof(Record);
+      Header.RecordOffset = sizeof(FileHeader);
+
+      // String 0 is the empty string
+      getStringId("");
+    }
+
+    ~FileWriter()
+    {
+      close();
+    }
+
+    // Document header values, must be set before open
+    void setDocumentHeader(const std::string& generatedOn, const std::string& msecSinceEpoch,
+        const std::string& application, const std::string& platform,
+        const std::string& toolVersion)
+    {
+      Header.GeneratedOn = getStringId(generatedOn);
+      Header.MsecSinceEpoch = getStringId(msecSinceEpoch);
+      Header.Application = getStringId(application);
+      Header.Platform = getStringId(platform);
+      Header.ToolVersion = getStringId(toolVersion);
+    }
+
+    // Footer CSV text, must be set before close
+    void setFooter(const std::string& footer)
+    {
+      Header.Footer = getStringId(footer);
+    }
+
+    bool open(const std::string& fileName)
+    {
+      Ofs.open(fileName, std::ios::binary);
+      if (!Ofs.is_open())
+        return false;
+      Ofs.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+      return true;
+    }
+
+    bool isOpen() const
+    {
+      return Ofs.is_open();
+    }
+
+    // Write string table and final header, the file is complete after this
+    void close()
+    {
+      if (!Ofs.is_open())
+        return;
+
+      Header.StringOffset = Header.RecordOffset + Header.RecordCount * sizeof(Record);
+      Header.StringCount = Strings.size();
+      for (auto& str : Strings) {
+        uint32_t len = str.size();
+        Ofs.write(reinterpret_cast<const char*>(&len), sizeof(len));
+        Ofs.write(str.data(), len);
+      }
+
+      Ofs.seekp(0);
+      Ofs.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+      Ofs.close();
+    }
+
+    uint32_t getStringId(const std::string& str)
+    {
+      auto itr = StringIds.find(str);
+      if (itr != StringIds.end())
+        return itr->second;
+
+      uint32_t id = Strings.size();
+      Strings.push_back(str);
+      StringIds.emplace(str, id);
+      return id;
+    }
+
+    void writeApiCall(double time, const std::string& functionName,
+        const std::string& eventName)
+    {
+      Record record = {};
+      record.Kind = API_CALL;
+      record.Time = time;
+      record.Name = getStringId(functionName);
+      record.Stage = getStringId(eventName);
+      writeRecord(record);
+    }
+
+    void writeKernel(double time, const std::string& commandString,
+        const std::string& stageString, const std::string& eventString,
+        const std::string& dependString, uint64_t objId, size_t size)
+    {
+      Record record = {};
+      record.Kind = KERNEL;
+      record.Time = time;
+      record.Name = getStringId(commandString);
+      record.Stage = getStringId(stageString);
+      record.Event = getStringId(eventString);
+      record.Depend = getStringId(dependString);
+      record.Value0 = objId;
+      record.Value1 = size;
+      writeRecord(record);
+    }
+
+    // Empty thread string for rows without thread ID
+    void writeDataTransfer(double time, const std::string& commandString,
+        const std::string& stageString, const std::string& eventString,
+        const std::string& dependString, size_t size, uint64_t address,
+        const std::string& bank, const std::string& threadString)
+    {
+      Record record = {};
+      record.Kind = DATA_TRANSFER;
+      record.Time = time;
+      record.Name = getStringId(commandString);
+      record.Stage = getStringId(stageString);
+      record.Event = getStringId(eventString);
+      record.Depend = getStringId(dependString);
+      record.Extra = getStringId(bank);
+      record.Value0 = address;
+      record.Value1 = size;
+      record.Value2 = getStringId(threadString);
+      writeRecord(record);
+    }
+
+    void writeDependency(double time, const std::string& commandString,
+        const std::string& stageString, const std::string& eventString,
+        const std::string& dependString)
+    {
+      Record record = {};
+      record.Kind = DEPENDENCY;
+      record.Time = time;
+      record.Name = getStringId(commandString);
+      record.Stage = getStringId(stageString);
+      record.Event = getStringId(eventString);
+      record.Depend = getStringId(dependString);
+      writeRecord(record);
+    }
+
+    void writeDeviceKernel(double start, double end, const std::string& traceName,
+        const std::string& workGroupSize)
+    {
+      Record record = {};
+      record.Kind = DEVICE_KERNEL;
+      record.Time = start;
+      record.End = end;
+      record.Name = getStringId(traceName);
+      record.Extra = getStringId(workGroupSize);
+      writeRecord(record);
+    }
+
+    void writeDeviceTransfer(double start, double end, const std::string& traceName,
+        const std::string& type, const std::string& argNames, double durationUsec,
+        uint64_t startCycles, uint64_t endCycles, uint16_t burstLength)
+    {
+      Record record = {};
+      record.Kind = DEVICE_TRANSFER;
+      record.Time = start;
+      record.End = end;
+      record.Name = getStringId(traceName);
+      record.Stage = getStringId(type);
+      record.Event = getStringId(argNames);
+      record.Duration = durationUsec;
+      record.Value0 = startCycles;
+      record.Value1 = burstLength;
+      record.Value2 = endCycles;
+      writeRecord(record);
+    }
+
+  private:
+    void writeRecord(const Record& record)
+    {
+      if (!Ofs.is_open())
+        return;
+      Ofs.write(reinterpret_cast<const char*>(&record), sizeof(record));
+      ++Header.RecordCount;
+    }
+
+  private:
+    std::ofstream Ofs;
+    FileHeader Header;
+    std::vector<std::string> Strings;
+    std::unordered_map<std::string, uint32_t> StringIds;
+  };
+
+}} // trace,XCL
+
+#endif
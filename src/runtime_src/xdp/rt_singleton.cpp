@@ -148,9 +148,13 @@ namespace XCL {
       timelineFile2 = "sdx_timeline_trace";
     }
 
+    // Binary timeline trace replaces the CSV timeline, convert with xdptrace
+    bool binaryTimeline = !timelineFile.empty()
+        && (xrt::config::get_timeline_trace_format() == "binary");
+
     // HTML and CSV writers
     //HTMLWriter* htmlWriter = new HTMLWriter(profileFile, timelineFile, "Xilinx");
-    CSVWriter* csvWriter = new CSVWriter(profileFile, timelineFile, "Xilinx");
+    CSVWriter* csvWriter = new CSVWriter(profileFile, binaryTimeline ? "" : timelineFile, "Xilinx");
 
     //Writers.push_back(htmlWriter);
     Writers.push_back(csvWriter);
@@ -158,6 +162,12 @@ namespace XCL {
     //ProfileMgr->attach(htmlWriter);
     ProfileMgr->attach(csvWriter);
 
+    if (binaryTimeline) {
+      BinaryWriter* binaryWriter = new BinaryWriter(timelineFile, "Xilinx");
+      Writers.push_back(binaryWriter);
+      ProfileMgr->attach(binaryWriter);
+    }
+
     if (std::getenv("SDX_NEW_PROFILE")) {
       UnifiedCSVWriter* csvWriter2 = new UnifiedCSVWriter(profileFile2, timelineFile2, "Xilinx");
       Writers.push_back(csvWriter2);
@@ -269,34 +269,11 @@ clEnqueueCopyBufferRect(cl_command_queue     command_queue ,
   uevent->queue(true/*wait*/);
   uevent->set_status(CL_RUNNING);
 
-  //memcpy
-  {  
-    for(size_t zit=0;zit<region[2];++zit) {
-      for(size_t yit=0;yit<region[1];++yit) {
-        size_t src_row_origin_in_bytes = 
-          src_origin_in_bytes(src_origin,src_row_pitch,src_slice_pitch)
-          + zit*src_slice_pitch
-          + yit*src_row_pitch;
-                                  
-        size_t dst_row_origin_in_bytes = 
-          dst_origin_in_bytes(dst_origin,dst_row_pitch,dst_slice_pitch)
-          + zit*dst_slice_pitch
-          + yit*dst_row_pitch;
-
-        auto device = xocl(command_queue)->get_device();
-        auto xdevice = device->get_xrt_device();
-        auto src_boh = xocl(src_buffer)->get_buffer_object_or_error(device);
-        auto dst_boh = xocl(dst_buffer)->get_buffer_object_or_error(device);
-        void* host_ptr_src = xdevice->map(src_boh);
-        void* host_ptr_dst = xdevice->map(dst_boh);
-        std::memcpy( &((uint8_t *)(host_ptr_dst))[dst_row_origin_in_bytes],
-                     &((uint8_t *)(host_ptr_src))[src_row_origin_in_bytes],
-                     region[0]);
-        xdevice->unmap(src_boh);
-        xdevice->unmap(dst_boh);
-      }
-    }
-  }
+  auto device = xocl(command_queue)->get_device();
+  device->copy_buffer_rect(xocl(src_buffer),xocl(dst_buffer)
+                           ,src_origin_in_bytes(src_origin,src_row_pitch,src_slice_pitch)
+                           ,dst_origin_in_bytes(dst_origin,dst_row_pitch,dst_slice_pitch)
+                           ,region,src_row_pitch,src_slice_pitch,dst_row_pitch,dst_slice_pitch);
 
   //set event CL_COMPLETE
   uevent->set_status(CL_COMPLETE);
@@ -87,6 +87,15 @@ clEnqueueWriteBufferRect(cl_command_queue     command_queue ,
                ,buffer_row_pitch,buffer_slice_pitch,host_row_pitch,host_slice_pitch
                ,ptr,num_events_in_wait_list ,event_wait_list,event);
 
+  if (!buffer_row_pitch)
+    buffer_row_pitch = region[0];
+  if (!buffer_slice_pitch)
+    buffer_slice_pitch = region[1]*buffer_row_pitch;
+  if (!host_row_pitch)
+    host_row_pitch = region[0];
+  if (!host_slice_pitch)
+    host_slice_pitch = region[1]*host_row_pitch;
+
   size_t buffer_origin_in_bytes = 
     buffer_origin[2]*buffer_slice_pitch+
     buffer_origin[1]*buffer_row_pitch+
@@ -113,27 +122,9 @@ clEnqueueWriteBufferRect(cl_command_queue     command_queue ,
 
   // Now the event is running, this should be hard_event and handle asynchronously
   auto device = xocl::xocl(command_queue)->get_device();
-  auto xdevice = device->get_xrt_device();
-  auto boh = xocl::xocl(buffer)->get_buffer_object_or_error(device);
-  void* host_ptr = xdevice->map(boh);
-  
-  size_t yit,zit;
-  for(zit=0;zit<region[2];zit++){
-    for(yit=0;yit<region[1];yit++){
-      size_t buffer_row_origin_in_bytes =
-        buffer_origin_in_bytes+
-        zit*buffer_slice_pitch+
-        yit*buffer_row_pitch;
-      size_t host_row_origin_in_bytes =
-        host_origin_in_bytes+
-        zit*host_slice_pitch+
-        yit*host_row_pitch;
-      memcpy( &((uint8_t *)(host_ptr))[buffer_row_origin_in_bytes],
-              &((uint8_t *)(ptr))[host_row_origin_in_bytes],
-              region[0]);
-    }
-  }
-  xdevice->unmap(boh);
+  device->write_buffer_rect(xocl::xocl(buffer),buffer_origin_in_bytes,region
+                           ,buffer_row_pitch,buffer_slice_pitch,host_row_pitch,host_slice_pitch
+                           ,static_cast<const uint8_t*>(ptr)+host_origin_in_bytes);
 
   if (event)
     xocl::xocl(*event)->set_status(CL_COMPLETE);
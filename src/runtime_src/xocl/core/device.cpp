@@ -28,11 +28,18 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <vector>
+#include <cstring>
 
 namespace {
 
 static unsigned int uid_count = 0;
 
+// Bytes written from host when filling a buffer in device memory,
+// fills smaller than this are done on host
+static const size_t fill_seed_size = 4096;
+
 static
 std::string
 to_hex(void* addr)
@@ -190,7 +197,7 @@ alloc(memory* mem, unsigned int memidx)
   if (is_aligned_ptr(host_ptr)) {
     auto boh = m_xdevice->alloc(sz,xrt::device::memoryDomain::XRT_DEVICE_RAM,memidx,host_ptr);
     track(mem);
-    return boh;
+    return m_memidx_usage->account(std::move(boh),memidx,sz);
   }
 
   auto p2p_flag = (mem->get_ext_flags() >> 30) & 0x1;
@@ -208,7 +215,7 @@ alloc(memory* mem, unsigned int memidx)
     memcpy(bo_host_ptr, host_ptr, sz);
     m_xdevice->unmap(boh);
   }
-  return boh;
+  return m_memidx_usage->account(std::move(boh),memidx,sz);
 }
 
 xrt::device::BufferObjectHandle
@@ -543,9 +550,9 @@ allocate_buffer_object(memory* mem)
   }
 
   // If buffer could not be allocated on the requested bank,
-  // or if no bank was specified, then allocate on the bank
-  // (memidx) matching the CU connectivity of CUs in device.
-  auto memidx = get_cu_memidx();
+  // or if no bank was specified, then allocate on the least used
+  // bank (memidx) matching the CU connectivity of CUs in device.
+  auto memidx = get_balanced_memidx();
   if (memidx>=0) {
     try {
       auto boh = alloc(mem,memidx);
@@ -652,33 +659,62 @@ get_boh_banktag(const xrt::device::BufferObjectHandle& boh) const
   return m_xclbin.memidx_to_banktag(memidx);
 }
 
-int
+void
 device::
-get_cu_memidx() const
+init_cu_memidx() const
 {
-  std::lock_guard<std::mutex> lk(m_mutex);
-  if (m_cu_memidx == -2) {
-    m_cu_memidx = -1;
-
-    if (get_num_cus()) {
-      // compute intersection of all CU memory masks
-      memidx_bitmask_type mask;
-      mask.set();
-      for (auto& cu : get_cu_range())
-        mask &= cu->get_memidx_intersect();
-
-      // select first common memory bank index if any
-      for (size_t idx=0; idx<mask.size(); ++idx) {
-        if (mask.test(idx)) {
-          m_cu_memidx = idx;
-          break;
-        }
+  if (m_cu_memidx != -2)
+    return;
+
+  m_cu_memidx = -1;
+  m_cu_memidx_mask.reset();
+
+  if (get_num_cus()) {
+    // compute intersection of all CU memory masks, a CU without global
+    // arguments has all bits set so limit to banks used in the xclbin
+    memidx_bitmask_type mask;
+    mask.set();
+    for (auto& cu : get_cu_range())
+      mask &= cu->get_memidx_intersect();
+    if (m_xclbin.get_mem_topology())
+      mask &= m_xclbin.used_memidx_mask();
+    m_cu_memidx_mask = mask;
+
+    // select first common memory bank index if any
+    for (size_t idx=0; idx<mask.size(); ++idx) {
+      if (mask.test(idx)) {
+        m_cu_memidx = idx;
+        break;
       }
     }
   }
+}
+
+int
+device::
+get_cu_memidx() const
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  init_cu_memidx();
   return m_cu_memidx;
 }
 
+int
+device::
+get_balanced_memidx() const
+{
+  // index and mask are reset together when a program is loaded
+  memidx_bitmask_type mask;
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    init_cu_memidx();
+    if (m_cu_memidx < 0 || !xrt::config::get_balance_banks())
+      return m_cu_memidx;
+    mask = m_cu_memidx_mask;
+  }
+  return m_memidx_usage->least_used(mask);
+}
+
 device::memidx_bitmask_type
 device::
 get_cu_memidx(kernel* kernel, int argidx) const
@@ -867,6 +903,18 @@ void
 device::
 copy_buffer(memory* src_buffer, memory* dst_buffer, size_t src_offset, size_t dst_offset, size_t size)
 {
+  // Copy within device memory if both buffers are resident, the
+  // host side buffer object of dst is stale afterwards, but any
+  // subsequent read or map of a resident buffer syncs from device.
+  auto xdevice = get_xrt_device();
+  if (xdevice->hasCopyBO() && src_buffer->is_resident(this) && dst_buffer->is_resident(this)) {
+    auto src_boh = src_buffer->get_buffer_object_or_error(this);
+    auto dst_boh = dst_buffer->get_buffer_object_or_error(this);
+    if (xdevice->copy(dst_boh,src_boh,size,dst_offset,src_offset).get<int>()==0)
+      return;
+    XOCL_DEBUG(std::cout,"device side copy failed, using host copy\n");
+  }
+
   char* hbuf_src = static_cast<char*>(map_buffer(src_buffer,CL_MAP_READ,src_offset,size,nullptr));
   char* hbuf_dst = static_cast<char*>(map_buffer(dst_buffer,CL_MAP_WRITE_INVALIDATE_REGION,dst_offset,size,nullptr));
   std::memcpy(hbuf_dst,hbuf_src,size);
@@ -884,11 +932,84 @@ copy_p2p_buffer(memory* src_buffer, memory* dst_buffer, size_t src_offset, size_
   xdevice->copy(dst_boh, src_boh, size, dst_offset, src_offset);
 }
 
+void
+device::
+copy_buffer_rect(memory* src_buffer, memory* dst_buffer, size_t src_offset, size_t dst_offset,
+                 const size_t* region,
+                 size_t src_row_pitch, size_t src_slice_pitch,
+                 size_t dst_row_pitch, size_t dst_slice_pitch)
+{
+  auto xdevice = get_xrt_device();
+  auto src_boh = src_buffer->get_buffer_object_or_error(this);
+  auto dst_boh = dst_buffer->get_buffer_object_or_error(this);
+
+  if (xdevice->hasCopyBO() && src_buffer->is_resident(this) && dst_buffer->is_resident(this)) {
+    // Rows are contiguous in both buffers, one copy for entire region
+    if (region[0]==src_row_pitch && region[0]==dst_row_pitch
+        && (region[2]==1 || (src_slice_pitch==src_row_pitch*region[1] && dst_slice_pitch==dst_row_pitch*region[1]))) {
+      if (xdevice->copy(dst_boh,src_boh,region[0]*region[1]*region[2],dst_offset,src_offset).get<int>()==0)
+        return;
+    }
+    else {
+      // One copy per row
+      bool ok = true;
+      for (size_t z=0; ok && z<region[2]; ++z)
+        for (size_t y=0; ok && y<region[1]; ++y)
+          ok = xdevice->copy(dst_boh,src_boh,region[0]
+                             ,dst_offset + z*dst_slice_pitch + y*dst_row_pitch
+                             ,src_offset + z*src_slice_pitch + y*src_row_pitch).get<int>()==0;
+      if (ok)
+        return;
+    }
+    XOCL_DEBUG(std::cout,"device side rect copy failed, using host copy\n");
+  }
+
+  // Host copy through maps of the extents covering the region.  The
+  // source is synced from device, so is the destination to preserve
+  // bytes between rows when it is synced back on unmap.
+  auto src_extent = (region[2]-1)*src_slice_pitch + (region[1]-1)*src_row_pitch + region[0];
+  auto dst_extent = (region[2]-1)*dst_slice_pitch + (region[1]-1)*dst_row_pitch + region[0];
+  char* hbuf_src = static_cast<char*>(map_buffer(src_buffer,CL_MAP_READ,src_offset,src_extent,nullptr));
+  char* hbuf_dst = static_cast<char*>(map_buffer(dst_buffer,CL_MAP_WRITE,dst_offset,dst_extent,nullptr));
+  for (size_t z=0; z<region[2]; ++z)
+    for (size_t y=0; y<region[1]; ++y)
+      std::memcpy(hbuf_dst + z*dst_slice_pitch + y*dst_row_pitch
+                  ,hbuf_src + z*src_slice_pitch + y*src_row_pitch
+                  ,region[0]);
+  unmap_buffer(src_buffer,hbuf_src);
+  unmap_buffer(dst_buffer,hbuf_dst);
+}
+
 void
 device::
 fill_buffer(memory* buffer, const void* pattern, size_t pattern_size, size_t offset, size_t size)
 {
   auto boh = xocl::xocl(buffer)->get_buffer_object(this);
+
+  // Fill a resident buffer in device memory.  The pattern is written
+  // from host to a small seed region only, which is then doubled by
+  // device side copies until size is filled.  Since size and seed are
+  // multiples of pattern_size, each copy preserves the pattern phase.
+  auto xdevice = get_xrt_device();
+  if (size>=fill_seed_size && xdevice->hasCopyBO() && buffer->is_resident(this)) {
+    size_t seed = std::max(pattern_size,fill_seed_size - fill_seed_size%pattern_size);
+    std::vector<char> hseed(seed);
+    for (size_t idx=0; idx<seed; idx+=pattern_size)
+      std::memcpy(hseed.data()+idx,pattern,pattern_size);
+    xdevice->write(boh,hseed.data(),seed,offset,false);
+    xdevice->sync(boh,seed,offset,xrt::hal::device::direction::HOST2DEVICE,false);
+
+    bool ok = true;
+    for (size_t filled=seed; ok && filled<size; ) {
+      auto sz = std::min(filled,size-filled);
+      ok = xdevice->copy(boh,boh,sz,offset+filled,offset).get<int>()==0;
+      filled += sz;
+    }
+    if (ok)
+      return;
+    XOCL_DEBUG(std::cout,"device side fill failed, using host fill\n");
+  }
+
   char* hbuf = static_cast<char*>(map_buffer(buffer,CL_MAP_WRITE_INVALIDATE_REGION,offset,size,nullptr));
   char* dst = hbuf;
   for (; pattern_size <= size; size-=pattern_size, dst+=pattern_size)
@@ -898,80 +1019,101 @@ fill_buffer(memory* buffer, const void* pattern, size_t pattern_size, size_t off
   unmap_buffer(buffer,hbuf);
 }
 
+// Transfer a rectangular region between host memory and buffer.  A
+// resident buffer syncs only the rows of the region, with one request
+// per contiguous range of rows.
 static void
-rw_image(device* device,
-         memory* image,const size_t* origin,const size_t* region,size_t row_pitch,size_t slice_pitch
-         ,char* read_to,const char* write_from)
+rw_rect(device* device, memory* buffer, const xrt::device::rect_region& region
+        ,char* read_to, const char* write_from)
 {
-  auto boh = image->get_buffer_object(device);
+  if (!region.width || !region.height || !region.depth)
+    return;
+
+  auto boh = buffer->get_buffer_object(device);
   auto xdevice = device->get_xrt_device();
+  bool resident = buffer->is_resident(device);
+
+  if (read_to) {
+    if (resident)
+      xdevice->sync_rect(boh,region,xrt::hal::device::direction::DEVICE2HOST);
+    xdevice->read_rect(boh,read_to,region);
+    return;
+  }
+
+  xdevice->write_rect(boh,write_from,region);
+  if (resident)
+    xdevice->sync_rect(boh,region,xrt::hal::device::direction::HOST2DEVICE);
+}
 
-  size_t image_offset = image->get_image_data_offset()
+static xrt::device::rect_region
+image_region(memory* image,const size_t* origin,const size_t* region,size_t row_pitch,size_t slice_pitch)
+{
+  xrt::device::rect_region r;
+  r.bo_offset = image->get_image_data_offset()
     + image->get_image_bytes_per_pixel()*origin[0]
     + image->get_image_row_pitch()*origin[1]
     + image->get_image_slice_pitch()*origin[2];
+  r.bo_row_pitch = image->get_image_row_pitch();
+  r.bo_slice_pitch = image->get_image_slice_pitch();
+  r.host_row_pitch = row_pitch;
+  r.host_slice_pitch = slice_pitch;
+  r.width = image->get_image_bytes_per_pixel()*region[0];
+  r.height = region[1];
+  r.depth = region[2];
+  return r;
+}
 
-  if (!origin[0] && region[0]==image->get_image_width() && row_pitch==image->get_image_row_pitch()
-      && (region[2]==1
-          || (!origin[1] && region[1]==image->get_image_height() && slice_pitch==image->get_image_slice_pitch())
-          )
-      ) {
-    size_t sz = region[2]==1 ? row_pitch*region[1] : slice_pitch*region[2];
-    if (read_to)
-      xdevice->read(boh,read_to,sz,image_offset,false);
-    else
-      xdevice->write(boh,write_from,sz,image_offset,false);
-  }
-  else {
-    size_t image_offset_tmp = image_offset;
-    for (unsigned int j=0; j<region[2]; ++j) {
-      size_t offset = image_offset_tmp;
-      for (unsigned int i=0; i<region[1]; ++i) {
-        if (read_to) {
-          xdevice->read(boh,read_to,image->get_image_bytes_per_pixel()*region[0],offset,false);
-          read_to += row_pitch;
-        }
-        else {
-          xdevice->write(boh,write_from,image->get_image_bytes_per_pixel()*region[0],offset, false);
-          write_from += row_pitch;
-        }
-        offset += image->get_image_row_pitch();
-      }
-      image_offset_tmp += image->get_image_slice_pitch();
-      if (read_to)
-        read_to += slice_pitch;
-      else
-        write_from += slice_pitch;
-    }
-  }
+static xrt::device::rect_region
+buffer_region(size_t buffer_offset, const size_t* region,
+              size_t buffer_row_pitch, size_t buffer_slice_pitch,
+              size_t host_row_pitch, size_t host_slice_pitch)
+{
+  xrt::device::rect_region r;
+  r.bo_offset = buffer_offset;
+  r.bo_row_pitch = buffer_row_pitch;
+  r.bo_slice_pitch = buffer_slice_pitch;
+  r.host_row_pitch = host_row_pitch;
+  r.host_slice_pitch = host_slice_pitch;
+  r.width = region[0];
+  r.height = region[1];
+  r.depth = region[2];
+  return r;
 }
 
 void
 device::
-write_image(memory* image,const size_t* origin,const size_t* region,size_t row_pitch,size_t slice_pitch,const void *ptr)
+write_buffer_rect(memory* buffer, size_t buffer_offset, const size_t* region,
+                  size_t buffer_row_pitch, size_t buffer_slice_pitch,
+                  size_t host_row_pitch, size_t host_slice_pitch, const void* ptr)
 {
-  // Write from ptr into image
-  rw_image(this,image,origin,region,row_pitch,slice_pitch,nullptr,static_cast<const char*>(ptr));
+  auto r = buffer_region(buffer_offset,region,buffer_row_pitch,buffer_slice_pitch,host_row_pitch,host_slice_pitch);
+  rw_rect(this,buffer,r,nullptr,static_cast<const char*>(ptr));
+}
 
-  // Sync newly writte data to device if image is resident
-  if (image->is_resident(this)) {
-    auto boh = image->get_buffer_object_or_error(this);
-    get_xrt_device()->sync(boh, image->get_size(), 0,xrt::hal::device::direction::HOST2DEVICE,false);
-  }
+void
+device::
+read_buffer_rect(memory* buffer, size_t buffer_offset, const size_t* region,
+                 size_t buffer_row_pitch, size_t buffer_slice_pitch,
+                 size_t host_row_pitch, size_t host_slice_pitch, void* ptr)
+{
+  auto r = buffer_region(buffer_offset,region,buffer_row_pitch,buffer_slice_pitch,host_row_pitch,host_slice_pitch);
+  rw_rect(this,buffer,r,static_cast<char*>(ptr),nullptr);
 }
 
 void
 device::
-read_image(memory* image,const size_t* origin,const size_t* region,size_t row_pitch,size_t slice_pitch,void *ptr)
+write_image(memory* image,const size_t* origin,const size_t* region,size_t row_pitch,size_t slice_pitch,const void *ptr)
 {
-  // Sync back from device if image is resident
-  if (image->is_resident(this)) {
-    auto boh = image->get_buffer_object_or_error(this);
-    get_xrt_device()->sync(boh,image->get_size(),0,xrt::hal::device::direction::DEVICE2HOST,false);
-  }
+  auto r = image_region(image,origin,region,row_pitch,slice_pitch);
+  rw_rect(this,image,r,nullptr,static_cast<const char*>(ptr));
+}
 
-  // Now read from image into ptr
-  rw_image(this,image,origin,region,row_pitch,slice_pitch,static_cast<char*>(ptr),nullptr);
+void
+device::
+read_image(memory* image,const size_t* origin,const size_t* region,size_t row_pitch,size_t slice_pitch,void *ptr)
+{
+  auto r = image_region(image,origin,region,row_pitch,slice_pitch);
+  rw_rect(this,image,r,static_cast<char*>(ptr),nullptr);
 }
 
 void
@@ -1115,7 +1257,11 @@ load_program(program* program)
   // so iterating kernel names and looking up symbols from kernels
   // isn't possible, we *must* iterator symbols explicitly
   m_computeunits.clear();
-  m_cu_memidx = -2;
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_cu_memidx = -2;
+    m_cu_memidx_mask.reset();
+  }
   for (auto symbol : m_xclbin.kernel_symbols()) {
     for (auto& inst : symbol->instances) {
       add_cu(xrt::make_unique<compute_unit>(symbol,inst.name,this));
@@ -21,6 +21,7 @@
 #include "xocl/core/refcount.h"
 #include "xocl/core/error.h"
 #include "xocl/core/compute_unit.h"
+#include "xocl/core/memidx_usage.h"
 #include "xocl/xclbin/xclbin.h"
 #include "xrt/device/device.h"
 
@@ -341,6 +342,19 @@ public:
   int
   get_cu_memidx() const;
 
+  /**
+   * Get the memory index of the bank for a buffer without explicit bank
+   *
+   * Of the banks used in the xclbin and connected to all CUs in this
+   * device, the bank with the fewest bytes currently allocated in it
+   * by this device.
+   *
+   * @return Memory index for DDR bank, -1 if CUs are not all connected
+   *  to a common bank
+   */
+  int
+  get_balanced_memidx() const;
+
   /**
    * Get the indices of memory banks which CU argument is connected to
    * for specified kernel.
@@ -434,6 +448,27 @@ public:
   void
   copy_buffer(memory* src_buffer, memory* dst_buffer, size_t src_offset, size_t dst_offset, size_t size);
 
+  /**
+   * Copy a 3D region from src_buffer to dst_buffer
+   *
+   * The copy is done in device memory when both buffers are resident
+   * and the device supports it, otherwise the region is copied
+   * between host maps of the buffers, synced as by map_buffer and
+   * unmap_buffer.
+   *
+   * @param src_offset
+   *  Byte offset of region origin in src_buffer
+   * @param dst_offset
+   *  Byte offset of region origin in dst_buffer
+   * @param region
+   *  Width in bytes, height in rows, and depth in slices of region
+   */
+  void
+  copy_buffer_rect(memory* src_buffer, memory* dst_buffer, size_t src_offset, size_t dst_offset,
+                   const size_t* region,
+                   size_t src_row_pitch, size_t src_slice_pitch,
+                   size_t dst_row_pitch, size_t dst_slice_pitch);
+
 
 
 
@@ -460,6 +495,35 @@ public:
   void
   fill_buffer(memory* buffer, const void* pattern, size_t pattern_size, size_t offset, size_t size);
 
+  /**
+   * Write a 3D region of buffer from host memory
+   *
+   * The region is transferred to device with one request if and only
+   * if the buffer is resident on the device.
+   *
+   * @param buffer_offset
+   *  Byte offset of region origin in buffer
+   * @param region
+   *  Width in bytes, height in rows, and depth in slices of region
+   * @param ptr
+   *  Host memory at region origin
+   */
+  void
+  write_buffer_rect(memory* buffer, size_t buffer_offset, const size_t* region,
+                    size_t buffer_row_pitch, size_t buffer_slice_pitch,
+                    size_t host_row_pitch, size_t host_slice_pitch, const void* ptr);
+
+  /**
+   * Read a 3D region of buffer into host memory
+   *
+   * The region is synced from device with one request if and only
+   * if the buffer is resident on the device.
+   */
+  void
+  read_buffer_rect(memory* buffer, size_t buffer_offset, const size_t* region,
+                   size_t buffer_row_pitch, size_t buffer_slice_pitch,
+                   size_t host_row_pitch, size_t host_slice_pitch, void* ptr);
+
   void
   write_image(memory* image,const size_t* origin,const size_t* region,size_t row_pitch,size_t slice_pitch,const void *ptr);
 
@@ -703,6 +767,13 @@ private:
   xrt::device::BufferObjectHandle
   alloc(memory* mem);
 
+  /**
+   * Compute the memory index and mask of banks common to all CUs
+   * if not already computed.  Caller must hold m_mutex.
+   */
+  void
+  init_cu_memidx() const;
+
 
 private:
   struct mapinfo {
@@ -742,6 +813,10 @@ private:
 
   // Caching.  Purely implementation detail (-2 => not initialized)
   mutable int m_cu_memidx = -2;
+  mutable memidx_bitmask_type m_cu_memidx_mask;
+
+  // Bytes allocated per memory index
+  std::shared_ptr<memidx_usage> m_memidx_usage = std::make_shared<memidx_usage>();
 };
 
 } // xocl
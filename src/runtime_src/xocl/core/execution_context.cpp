@@ -21,10 +21,13 @@
 #include "xrt/scheduler/command.h"
 #include "xrt/scheduler/scheduler.h"
 
+#include "xocl/api/plugin/xdp/profile.h"
+
 #include "impl/spir.h"
 
 #include <iostream>
 #include <fstream>
+#include <cstring>
 
 namespace {
 
@@ -184,26 +187,24 @@ fill_regmap(execution_context::regmap_type& regmap, size_t offset,
             const void* data, const size_t size,
             const xocl::kernel::argument::arginfo_range_type& arginforange)
 {
-  // scale raw data input to specified size so that the
-  // value when cast to uint32_t* doesn't carry junk in case
-  // size is less than sizeof(uint32_t). Fill host_data
-  // conservative with an additional sizeof(uint32_t) bytes.
+  // Words are copied from raw data input such that the value
+  // doesn't carry junk in case fewer than sizeof(uint32_t) bytes
+  // remain in the data.
   const char* cdata = reinterpret_cast<const char*>(data);
-  std::vector<char> host_data(cdata,cdata+size);
-  host_data.resize(size+sizeof(uint32_t));
 
   // For each component of the argument
   for (auto arginfo : arginforange) {
-    const char* component = host_data.data() + arginfo->hostoffset;
-    const uint32_t* word = reinterpret_cast<const uint32_t*>(component);
+    size_t host_offset = arginfo->hostoffset;
     // For each 32-bit word of the component
     for (size_t wi=0, we=arginfo->size/sizeof(uint32_t); wi!=we; ++wi) {
       size_t device_offset = arginfo->offset + wi*sizeof(uint32_t);
-      uint32_t device_value = *word;
+      uint32_t device_value = 0;
+      if (host_offset < size)
+        std::memcpy(&device_value,cdata+host_offset,std::min(sizeof(uint32_t),size-host_offset));
       size_t register_offset = device_offset / sizeof(uint32_t);
       regmap[offset+register_offset] = device_value;
       //      std::cout << "regmap[" << register_offset << "]=" << device_value << "\n";
-      ++word;
+      host_offset += sizeof(uint32_t);
     }
   }
   return 0;
@@ -233,6 +234,7 @@ execution_context(device* device
 
   // Bind the kernel arguments to this context so that the same kernel
   // object can be reused while this context is executing
+  m_argument_version = m_kernel->get_argument_version();
   for (auto& arg : m_kernel->get_argument_range())
     m_kernel_args.push_back(arg->clone());
 
@@ -351,26 +353,33 @@ update_work()
   m_done = true;
 }
 
-void
+std::shared_ptr<const kernel::regmap_image>
 execution_context::
-start()
+get_regmap_image() const
 {
-  XOCL_DEBUGF("execution_context(%d) starting workgroup(%d,%d,%d)\n"
-              ,get_uid(),m_cu_group_id[0],m_cu_group_id[1],m_cu_group_id[2]);
+  // Conformance mode may reload program and change CUs
+  if (conformance::on())
+    return nullptr;
+
+  auto image = m_kernel->get_regmap_image();
+  if (image
+      && image->dev == m_device
+      && image->version == m_argument_version
+      && image->dim == m_dim
+      && image->goffset == m_goffset
+      && image->gsize == m_gsize
+      && image->lsize == m_lsize)
+    return image;
 
-  // On first work load, transition event to CL_RUNNING
-  if ( (m_cu_group_id[0]==0) && (m_cu_group_id[1]==0) && (m_cu_group_id[2]==0))
-    m_event->set_status(CL_RUNNING);
+  return nullptr;
+}
 
+void
+execution_context::
+encode_static_regmap(packet_type& packet)
+{
   auto xdevice = m_device->get_xrt_device();
 
-  // Construct command packet and send to hardware
-  auto cmd = conformance::on()
-    ? std::make_shared<start_kernel_conformance>(xdevice,this)
-    : std::make_shared<start_kernel>(xdevice,this);
-  ++m_active;
-  auto& packet = cmd->get_packet();
-
   // Encode CUs in cu bitmasks with bits in position according to the
   // CUs that can be used
   encode_compute_units(packet);
@@ -386,13 +395,9 @@ start()
   }
 
   // Push kernel args
-  xocl::memory* printf_buffer = nullptr;
   for (auto& arg : m_kernel_args) {
-    if (arg->is_printf()) {
-      printf_buffer = arg->get_memory_object();
-      assert(printf_buffer);
+    if (arg->is_printf())
       continue;
-    }
 
     auto address_space = arg->get_address_space();
     if (address_space == SPIR_ADDRSPACE_PRIVATE)
@@ -428,8 +433,47 @@ start()
     fill_regmap(regmap,offset,&physaddr,arg->get_size(),arg->get_arginfo_range());
   }
 
-  // Set runtime arguments as required
+  // Push workgroup invariant runtime args
   size3 local_id {0,0,0};
+  for (auto& arg : m_kernel->get_rtinfo_argument_range()) {
+    auto nm = arg->get_name();
+    XOCL_DEBUGF("execution_context(%d) sets rtinfo(%s)\n",get_uid(),nm.c_str());
+    if (nm=="work_dim")
+      fill_regmap(regmap,offset,&m_dim,sizeof(cl_uint),arg->get_arginfo_range());
+    else if (nm=="global_offset")
+      fill_regmap(regmap,offset,m_goffset.data(),3*sizeof(size_t),arg->get_arginfo_range());
+    else if (nm=="global_size")
+      fill_regmap(regmap,offset,m_gsize.data(),3*sizeof(size_t),arg->get_arginfo_range());
+    else if (nm=="local_size")
+      fill_regmap(regmap,offset,m_lsize.data(),3*sizeof(size_t),arg->get_arginfo_range());
+    else if (nm=="num_groups")
+      fill_regmap(regmap,offset,num_workgroups.data(),3*sizeof(size_t),arg->get_arginfo_range());
+    else if (nm=="local_id")
+      fill_regmap(regmap,offset,local_id.data(),3*sizeof(size_t),arg->get_arginfo_range());
+  }
+}
+
+void
+execution_context::
+encode_workgroup_regmap(packet_type& packet)
+{
+  auto xdevice = m_device->get_xrt_device();
+  auto& regmap = packet;
+
+  // Offset of regmap is past header and cu masks
+  auto epacket = reinterpret_cast<ert_start_kernel_cmd*>(packet.data());
+  size_t offset = 1 + 1 + epacket->extra_cu_masks;
+
+  xocl::memory* printf_buffer = nullptr;
+  for (auto& arg : m_kernel_args) {
+    if (arg->is_printf()) {
+      printf_buffer = arg->get_memory_object();
+      assert(printf_buffer);
+      break;
+    }
+  }
+
+  // Set runtime arguments as required
   uint64_t printf_buffer_addr = 0;
   if ( printf_buffer ) {
     // This computes the offset that gets added to a physical printf buffer
@@ -452,29 +496,70 @@ start()
     printf_buffer_addr = printf_buffer_base_addr + printf_buffer_offset;
   }
 
-  // Push runtime args
+  // Push workgroup dependent runtime args
   for (auto& arg : m_kernel->get_rtinfo_argument_range()) {
     auto nm = arg->get_name();
-    XOCL_DEBUGF("execution_context(%d) sets rtinfo(%s)\n",get_uid(),nm.c_str());
-    if (nm=="work_dim")
-      fill_regmap(regmap,offset,&m_dim,sizeof(cl_uint),arg->get_arginfo_range());
-    else if (nm=="global_offset")
-      fill_regmap(regmap,offset,m_goffset.data(),3*sizeof(size_t),arg->get_arginfo_range());
-    else if (nm=="global_size")
-      fill_regmap(regmap,offset,m_gsize.data(),3*sizeof(size_t),arg->get_arginfo_range());
-    else if (nm=="local_size")
-      fill_regmap(regmap,offset,m_lsize.data(),3*sizeof(size_t),arg->get_arginfo_range());
-    else if (nm=="num_groups")
-      fill_regmap(regmap,offset,num_workgroups.data(),3*sizeof(size_t),arg->get_arginfo_range());
-    else if (nm=="global_id")
+    if (nm=="global_id")
       fill_regmap(regmap,offset,m_cu_global_id.data(),3*sizeof(size_t),arg->get_arginfo_range());
-    else if (nm=="local_id")
-      fill_regmap(regmap,offset,local_id.data(),3*sizeof(size_t),arg->get_arginfo_range());
     else if (nm=="group_id")
       fill_regmap(regmap,offset,m_cu_group_id.data(),3*sizeof(size_t),arg->get_arginfo_range());
     else if (nm=="printf_buffer")
       fill_regmap(regmap,offset,&printf_buffer_addr,sizeof(printf_buffer_addr),arg->get_arginfo_range());
   }
+}
+
+void
+execution_context::
+start()
+{
+  XOCL_DEBUGF("execution_context(%d) starting workgroup(%d,%d,%d)\n"
+              ,get_uid(),m_cu_group_id[0],m_cu_group_id[1],m_cu_group_id[2]);
+
+  // On first work load, transition event to CL_RUNNING
+  if ( (m_cu_group_id[0]==0) && (m_cu_group_id[1]==0) && (m_cu_group_id[2]==0))
+    m_event->set_status(CL_RUNNING);
+
+  auto xdevice = m_device->get_xrt_device();
+
+  // Construct command packet and send to hardware.  Command
+  // construction is logged as a separate profiling item.
+  command_type cmd;
+  {
+    xocl::profile::function_call_logger log("xrtCommandCreate");
+    cmd = conformance::on()
+      ? command_type(xrt::make_command<start_kernel_conformance>(xdevice,this))
+      : command_type(xrt::make_command<start_kernel>(xdevice,this));
+  }
+  ++m_active;
+  auto& packet = cmd->get_packet();
+
+  // The workgroup invariant part of the packet is encoded once per
+  // kernel argument version and copied for subsequent workgroups
+  // and launches.
+  if (!m_regmap_image)
+    m_regmap_image = get_regmap_image();
+
+  if (m_regmap_image) {
+    auto& words = m_regmap_image->words;
+    packet.assign(words.data(),words.size());
+  }
+  else {
+    encode_static_regmap(packet);
+
+    auto image = std::make_shared<kernel::regmap_image>();
+    image->dev = m_device;
+    image->version = m_argument_version;
+    image->dim = m_dim;
+    image->goffset = m_goffset;
+    image->gsize = m_gsize;
+    image->lsize = m_lsize;
+    image->words.assign(packet.data(),packet.data()+packet.size());
+    m_regmap_image = image;
+    if (!conformance::on())
+      m_kernel->set_regmap_image(std::move(image));
+  }
+
+  encode_workgroup_regmap(packet);
 
   // send command to mbs
   write(cmd);
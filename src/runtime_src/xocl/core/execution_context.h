@@ -93,6 +93,14 @@ private:
   using argument_iterator_type = argument_vector_type::const_iterator;
   argument_vector_type m_kernel_args;
 
+  // Version of kernel arguments bound to this context
+  unsigned long m_argument_version = 0;
+
+  // Encoded register map of the workgroup invariant part of a
+  // start_kernel command.  Shared with other contexts of same
+  // kernel through the kernel's regmap cache.
+  std::shared_ptr<const kernel::regmap_image> m_regmap_image;
+
   // The context maintains a list of kernel compute units represented
   // by xcl::cu.  These cus (their base addresses) are used in the command
   // that starts the mbs. 
@@ -119,6 +127,25 @@ private:
   void
   encode_compute_units(packet_type& pkt);
 
+  /**
+   * Encode workgroup invariant part of command packet, i.e. cu masks,
+   * kernel arguments, and runtime arguments other than workgroup ids.
+   */
+  void
+  encode_static_regmap(packet_type& pkt);
+
+  /**
+   * Encode workgroup dependent part of command packet
+   */
+  void
+  encode_workgroup_regmap(packet_type& pkt);
+
+  /**
+   * Get cached register map image if valid for this context
+   */
+  std::shared_ptr<const kernel::regmap_image>
+  get_regmap_image() const;
+
   /**
    * Update workgroup accounting.
    */
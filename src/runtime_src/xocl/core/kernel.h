@@ -24,6 +24,11 @@
 
 #include "xrt/util/td.h"
 #include <limits>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include <iostream>
 
@@ -502,18 +507,64 @@ public:
   set_argument(unsigned long idx, size_t sz, const void* arg)
   {
     m_indexed_args.at(idx)->set(idx,sz,arg);
+    ++m_argument_version;
   }
 
   void
   set_svm_argument(unsigned long idx, size_t sz, const void* arg)
   {
     m_indexed_args.at(idx)->set_svm(sz,arg);
+    ++m_argument_version;
   }
 
   void
   set_printf_argument(size_t sz, const void* arg)
   {
     m_printf_args.at(0)->set(sz,arg);
+    ++m_argument_version;
+  }
+
+  /**
+   * Version of argument values.
+   *
+   * The version changes whenever an argument is set.  It is used
+   * to validate state derived from the argument values.
+   */
+  unsigned long
+  get_argument_version() const
+  {
+    return m_argument_version;
+  }
+
+  /**
+   * Encoded command register map cached by execution_context
+   *
+   * The register map image is valid only for the device, the
+   * argument version, and the NDRange it was encoded for.
+   */
+  struct regmap_image
+  {
+    const device* dev = nullptr;
+    unsigned long version = 0;
+    size_t dim = 0;
+    std::array<size_t,3> goffset {{0,0,0}};
+    std::array<size_t,3> gsize {{0,0,0}};
+    std::array<size_t,3> lsize {{0,0,0}};
+    std::vector<uint32_t> words;
+  };
+
+  std::shared_ptr<const regmap_image>
+  get_regmap_image() const
+  {
+    std::lock_guard<std::mutex> lk(m_regmap_mutex);
+    return m_regmap_image;
+  }
+
+  void
+  set_regmap_image(std::shared_ptr<const regmap_image> image)
+  {
+    std::lock_guard<std::mutex> lk(m_regmap_mutex);
+    m_regmap_image = std::move(image);
   }
 
   /**
@@ -586,6 +637,10 @@ private:
   argument_vector_type m_printf_args;
   argument_vector_type m_progvar_args;
   argument_vector_type m_rtinfo_args;
+
+  std::atomic<unsigned long> m_argument_version {0};
+  mutable std::mutex m_regmap_mutex;
+  std::shared_ptr<const regmap_image> m_regmap_image;
 };
 
 } // xocl
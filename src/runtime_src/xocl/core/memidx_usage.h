@@ -0,0 +1,101 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef xocl_core_memidx_usage_h_
+#define xocl_core_memidx_usage_h_
+
+#include "xrt/device/device.h"
+
+#include <array>
+#include <bitset>
+#include <memory>
+#include <mutex>
+
+namespace xocl {
+
+/**
+ * Bytes of buffer objects allocated per memory index
+ *
+ * Used by a device to place buffers that have no explicit memory bank
+ * in the least used bank.  Must be created with std::make_shared, the
+ * buffer objects accounted to it share ownership.
+ */
+class memidx_usage : public std::enable_shared_from_this<memidx_usage>
+{
+public:
+  using memidx_bitmask_type = std::bitset<64>;
+
+  /**
+   * Account bytes of a buffer object to its memory index
+   *
+   * @return
+   *   Handle that owns the argument handle, the bytes are released
+   *   when the buffer object is deleted
+   */
+  xrt::device::BufferObjectHandle
+  account(xrt::device::BufferObjectHandle boh, unsigned int memidx, size_t sz)
+  {
+    if (memidx >= m_bytes.size())
+      return boh;
+
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      m_bytes[memidx] += sz;
+    }
+
+    auto usage = shared_from_this();
+    auto bo = boh.get();
+    return xrt::device::BufferObjectHandle(bo,[usage,boh,memidx,sz](xrt::hal::buffer_object*) {
+      std::lock_guard<std::mutex> lk(usage->m_mutex);
+      usage->m_bytes[memidx] -= sz;
+    });
+  }
+
+  /**
+   * @return
+   *   Memory index in mask with the fewest bytes allocated, the lowest
+   *   such index if several, -1 if mask is empty
+   */
+  int
+  least_used(const memidx_bitmask_type& mask) const
+  {
+    int memidx = -1;
+    std::lock_guard<std::mutex> lk(m_mutex);
+    for (size_t idx=0; idx<mask.size(); ++idx)
+      if (mask.test(idx) && (memidx < 0 || m_bytes[idx] < m_bytes[memidx]))
+        memidx = idx;
+    return memidx;
+  }
+
+  /**
+   * @return
+   *   Bytes currently allocated in memory index
+   */
+  size_t
+  bytes(unsigned int memidx) const
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    return m_bytes.at(memidx);
+  }
+
+private:
+  mutable std::mutex m_mutex;
+  std::array<size_t,memidx_bitmask_type().size()> m_bytes {{}};
+};
+
+} // xocl
+
+#endif
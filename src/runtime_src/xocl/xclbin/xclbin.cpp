@@ -1118,6 +1118,20 @@ public:
     return bankidx;
   }
 
+  xocl::xclbin::memidx_bitmask_type
+  used_memidx_mask() const
+  {
+    xocl::xclbin::memidx_bitmask_type bitmask = 0;
+    if (!m_mem)
+      return bitmask;
+    for (int32_t memidx=0; memidx<m_mem->m_count && memidx<64; ++memidx) {
+      auto& mem = m_mem->m_mem_data[memidx];
+      if (mem.m_used && mem.m_type!=MEM_STREAMING)
+        bitmask.set(memidx);
+    }
+    return bitmask;
+  }
+
   std::string
   memidx_to_banktag(xocl::xclbin::memidx_type memidx) const
   {
@@ -1246,6 +1260,10 @@ struct xclbin::impl
   mem_address_to_first_memidx(addr_type memaddr) const
   { return m_sections.mem_address_to_first_memidx(memaddr); }
 
+  memidx_bitmask_type
+  used_memidx_mask() const
+  { return m_sections.used_memidx_mask(); }
+
   std::string
   memidx_to_banktag(memidx_type memidx) const
   { return m_sections.memidx_to_banktag(memidx); }
@@ -1467,6 +1485,13 @@ mem_address_to_first_memidx(addr_type memaddr) const
   return m_impl->mem_address_to_first_memidx(memaddr);
 }
 
+xclbin::memidx_bitmask_type
+xclbin::
+used_memidx_mask() const
+{
+  return m_impl->used_memidx_mask();
+}
+
 std::string
 xclbin::
 memidx_to_banktag(memidx_type bankidx) const
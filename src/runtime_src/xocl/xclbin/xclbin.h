@@ -353,6 +353,14 @@ public:
   memidx_type
   mem_address_to_first_memidx(addr_type addr) const;
 
+  /**
+   * @return
+   *   Bitmask with mem_data indices of the memories in use that buffer
+   *   objects can be allocated in, streaming memories are excluded
+   */
+  memidx_bitmask_type
+  used_memidx_mask() const;
+
   /**
    * Get the bank string tag for the memory at specified index
    *
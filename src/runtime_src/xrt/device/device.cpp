@@ -18,12 +18,22 @@
 
 #include "xrt/util/task.h"
 #include "xrt/util/event.h"
+#include "xrt/scheduler/command.h"
 
 #include <future>
 #include <cstring> // for std::memset
 
 namespace xrt {
 
+void
+device::
+close()
+{
+  // recycled exec buffer objects must be released while open
+  purge_command_freelist(this);
+  m_hal->close();
+}
+
 std::ostream&
 device::
 printDeviceInfo(std::ostream& ostr) const
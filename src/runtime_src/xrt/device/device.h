@@ -46,6 +46,7 @@ public:
   using stream_handle = hal::StreamHandle;
   using stream_flags = hal::StreamFlags;
   using stream_attrs = hal::StreamAttributes;
+  using rect_region = hal::rect_region;
   using stream_xfer_flags = hal::StreamXferFlags;
   using stream_buf = hal::StreamBuf;
   using stream_buf_handle = hal::StreamBufHandle;
@@ -121,6 +122,28 @@ public:
   std::ostream&
   printDeviceInfo(std::ostream&) const;
 
+  /**
+   * @return
+   *   Statistics of the buffer object cache, see Runtime.bo_cache_size
+   */
+  hal::bo_cache_stats
+  getBOCacheStats() const
+  {
+    return m_hal->getBOCacheStats();
+  }
+
+  /**
+   * Limit the buffer object cache to bytes, 0 disables the cache
+   *
+   * Overrides Runtime.bo_cache_size.  Cached buffer objects are freed
+   * if they exceed the new limit.
+   */
+  void
+  setBOCacheSize(size_t bytes)
+  {
+    m_hal->setBOCacheSize(bytes);
+  }
+
   /**
    * Hack to accomodate sw_em missing device info
    */
@@ -147,10 +170,7 @@ public:
   }
 
   void
-  close()
-  {
-    m_hal->close();
-  }
+  close();
 
   ExecBufferObjectHandle
   allocExecBuffer(size_t sz)
@@ -258,6 +278,36 @@ public:
   sync(const BufferObjectHandle& bo, size_t sz, size_t offset, direction dir, bool async=true)
   { return m_hal->sync(bo,sz,offset,dir,async); }
 
+  /**
+   * Write rectangular region from host memory to buffer object host memory
+   *
+   * @param buffer
+   *   Host memory at start of region
+   * @param region
+   *   Region descriptor with buffer object and host pitches
+   */
+  event
+  write_rect(const BufferObjectHandle& bo, const void* buffer, const rect_region& region)
+  { return m_hal->write_rect(bo,buffer,region); }
+
+  /**
+   * Read rectangular region from buffer object host memory to host memory
+   */
+  event
+  read_rect(const BufferObjectHandle& bo, void* buffer, const rect_region& region)
+  { return m_hal->read_rect(bo,buffer,region); }
+
+  /**
+   * Sync rectangular region of buffer object to/from device
+   *
+   * The HAL transfers the contiguous range covering the region in
+   * one request.  Bytes between rows are left as they are on the
+   * receiving side.
+   */
+  event
+  sync_rect(const BufferObjectHandle& bo, const rect_region& region, direction dir)
+  { return m_hal->sync_rect(bo,region,dir); }
+
   /**
    * Copy sz bytes at offset from device to device/host
    *
@@ -583,6 +633,12 @@ public:
     return m_hal->hasBankAlloc();
   }
 
+  bool
+  hasCopyBO() const
+  {
+    return m_hal->hasCopyBO();
+  }
+
   /**
    * Check if this device is an ARE device
    */
@@ -709,6 +765,17 @@ public:
     return m_hal->getDeviceTime();
   }
 
+  /**
+   * @return
+   *   Driver usage information, per bank bytes and buffer objects
+   *   allocated and DMA transfer counts
+   */
+  hal::operations_result<int>
+  getUsageInfo(xclDeviceUsage* info)
+  {
+    return m_hal->getUsageInfo(info);
+  }
+
   hal::operations_result<double>
   getDeviceMaxRead()
   {
@@ -154,6 +154,16 @@ loadDevices()
 
   // xrt
   bfs::path xrt(emptyOrValue(getenv("XILINX_XRT")));
+
+  // null device for measuring runtime overhead, replaces all other drivers
+  if (!xrt.empty() && getenv("XCL_NULL_DEVICE")) {
+    directoryOrError(xrt);
+    bfs::path p(xrt / "lib/libxrt_null.so");
+    if (isDLL(p))
+      createHalDevices(devices,p.string());
+    return devices;
+  }
+
   if (!xrt.empty() && !isEmulationMode()) {
     directoryOrError(xrt);
     bfs::path p(xrt / "lib/libxrt_core.so");
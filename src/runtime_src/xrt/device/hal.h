@@ -32,6 +32,7 @@
 
 //struct xclBin;
 struct axlf;
+struct xclDeviceUsage;
 
 namespace xrt {
 
@@ -69,6 +70,60 @@ typedef uint32_t StreamAttributes;
 typedef uint32_t StreamXferFlags;
 typedef uint64_t StreamFlags;
 
+/**
+ * Rectangular region transfer between a buffer object and host memory
+ *
+ * The region is width bytes by height rows by depth slices.  The
+ * region starts at bo_offset in the buffer object and at the host
+ * pointer passed along with the descriptor.
+ */
+struct rect_region
+{
+  size_t bo_offset;
+  size_t bo_row_pitch;
+  size_t bo_slice_pitch;
+  size_t host_row_pitch;
+  size_t host_slice_pitch;
+  size_t width;
+  size_t height;
+  size_t depth;
+
+  /**
+   * @return
+   *   True if the region is one contiguous range of the buffer object
+   */
+  bool
+  bo_contiguous() const
+  {
+    return (height==1 && depth==1)
+      || (width==bo_row_pitch && (depth==1 || bo_slice_pitch==bo_row_pitch*height));
+  }
+
+  /**
+   * @return
+   *   Number of bytes from first to last byte of region in buffer object
+   */
+  size_t
+  bo_extent() const
+  {
+    return (depth-1)*bo_slice_pitch + (height-1)*bo_row_pitch + width;
+  }
+};
+
+/**
+ * Buffer object cache statistics
+ *
+ * Hits and misses count allocations that could use the cache, cached
+ * bytes and buffer objects are what the cache currently holds.
+ */
+struct bo_cache_stats
+{
+  size_t hits = 0;
+  size_t misses = 0;
+  size_t cached_bytes = 0;
+  size_t cached_bos = 0;
+};
+
 /**
  * Helper class to encapsulate return values from HAL operations.
  *
@@ -207,6 +262,16 @@ public:
   virtual void*
   alloc_svm(size_t sz) = 0;
 
+  virtual bo_cache_stats
+  getBOCacheStats() const
+  {
+    return bo_cache_stats();
+  }
+
+  virtual void
+  setBOCacheSize(size_t bytes)
+  {}
+
   virtual BufferObjectHandle
   import(const BufferObjectHandle& bo) = 0;
 
@@ -229,6 +294,15 @@ public:
   copy(const BufferObjectHandle& dst_bo, const BufferObjectHandle& src_bo, size_t sz,
        size_t dst_offset, size_t src_offset) = 0;
 
+  virtual event
+  write_rect(const BufferObjectHandle& bo, const void* buffer, const rect_region& region) = 0;
+
+  virtual event
+  read_rect(const BufferObjectHandle& bo, void* buffer, const rect_region& region) = 0;
+
+  virtual event
+  sync_rect(const BufferObjectHandle& bo, const rect_region& region, direction dir) = 0;
+
   virtual size_t
   read_register(size_t offset, void* buffer, size_t size) = 0;
 
@@ -377,6 +451,15 @@ public:
     return operations_result<int>(); // invalid result
   }
 
+  /**
+   * Get usage information such as bytes and buffer objects per bank
+   */
+  virtual operations_result<int>
+  getUsageInfo(xclDeviceUsage* info)
+  {
+    return operations_result<int>(); // invalid result
+  }
+
   /**
    * Load an xclbin
    *
@@ -422,6 +505,18 @@ public:
     return false;
   }
 
+  /**
+   * Check if device side buffer copy is supported
+   *
+   * @return
+   *   true if copy() is supported, false otherwise
+   */
+  virtual bool
+  hasCopyBO() const
+  {
+    return false;
+  }
+
   /**
    * Read kernel control register
    *
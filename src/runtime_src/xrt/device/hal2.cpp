@@ -18,16 +18,38 @@
 #include "xrt/util/memory.h"
 #include "xrt/util/thread.h"
 
+#include <algorithm>
 #include <cstring> // for std::memcpy
 #include <iostream>
 #include <sys/mman.h> // for POSIX munmap
 
+namespace {
+
+// Size class of cached buffer objects.  Sizes up to four pages are
+// rounded up to whole pages as the driver would allocate anyway, larger
+// sizes to a quarter of the power of two below them, which adds less
+// than 25% to the size.
+static size_t
+size_class(size_t sz)
+{
+  const size_t page = 4096;
+  if (sz <= page)
+    return page;
+  auto n = sz - 1;
+  auto msb = 8*sizeof(unsigned long long) - 1 - __builtin_clzll(n);
+  auto step = std::max(size_t(1) << (msb - 2), page);
+  return (n | (step - 1)) + 1;
+}
+
+}
+
 namespace xrt { namespace hal2 {
 
 device::
 device(std::shared_ptr<operations> ops, unsigned int idx)
   : m_ops(std::move(ops)), m_idx(idx), m_handle(nullptr), m_devinfo{}
 {
+  m_bo_cache.max_bytes = static_cast<size_t>(config::get_bo_cache_size()) << 20;
 }
 
 device::
@@ -144,10 +166,138 @@ allocExecBuffer(size_t sz)
   return ExecBufferObjectHandle(ubo.release(),delBufferObject);
 }
 
+BufferObjectHandle
+device::
+allocCached(size_t sz, unsigned int flags)
+{
+  auto capacity = size_class(sz);
+  BufferObject* bo = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(m_bo_cache.mutex);
+    auto itr = m_bo_cache.free.find(std::make_pair(flags,capacity));
+    if (itr != m_bo_cache.free.end() && !itr->second.empty()) {
+      bo = itr->second.back();
+      itr->second.pop_back();
+      m_bo_cache.stats.cached_bytes -= capacity;
+      --m_bo_cache.stats.cached_bos;
+      ++m_bo_cache.stats.hits;
+    }
+    else
+      ++m_bo_cache.stats.misses;
+  }
+
+  if (!bo) {
+    xclBOKind kind = XCL_BO_DEVICE_RAM;
+    auto ubo = xrt::make_unique<BufferObject>();
+    ubo->handle = m_ops->mAllocBO(m_handle, capacity, kind, flags);
+    if (ubo->handle == 0xffffffff) {
+      // memory may be held by cached buffer objects, release them and retry
+      clearBOCache();
+      ubo->handle = m_ops->mAllocBO(m_handle, capacity, kind, flags);
+    }
+    if (ubo->handle == 0xffffffff)
+      throw std::bad_alloc();
+
+    ubo->kind = kind;
+    ubo->flags = flags;
+    ubo->capacity = capacity;
+    ubo->owner = m_handle;
+    ubo->deviceAddr = m_ops->mGetDeviceAddr(m_handle, ubo->handle);
+    ubo->hostAddr = m_ops->mMapBO(m_handle, ubo->handle, true /*write*/);
+    bo = ubo.release();
+  }
+  bo->size = sz;
+
+  auto delBufferObject = [this](BufferObjectHandle::element_type* vbo) {
+    releaseCached(static_cast<BufferObject*>(vbo));
+  };
+
+  XRT_DEBUG(std::cout,"allocated cached buffer object device address(",bo->deviceAddr,",",bo->size,")\n");
+  return BufferObjectHandle(bo, delBufferObject);
+}
+
+void
+device::
+releaseCached(BufferObject* bo)
+{
+  // buffer object explicitly freed by free()
+  if (bo->handle == 0xffffffff) {
+    munmap(bo->hostAddr, bo->capacity);
+    delete bo;
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(m_bo_cache.mutex);
+
+    // device closed since, the driver has released the buffer object
+    if (bo->owner != m_bo_cache.owner) {
+      munmap(bo->hostAddr, bo->capacity);
+      delete bo;
+      return;
+    }
+
+    if (!bo->exported
+        && m_bo_cache.stats.cached_bytes + bo->capacity <= m_bo_cache.max_bytes) {
+      m_bo_cache.free[std::make_pair(bo->flags,bo->capacity)].push_back(bo);
+      m_bo_cache.stats.cached_bytes += bo->capacity;
+      ++m_bo_cache.stats.cached_bos;
+      return;
+    }
+  }
+
+  XRT_DEBUG(std::cout,"deleted cached buffer object device address(",bo->deviceAddr,",",bo->size,")\n");
+  munmap(bo->hostAddr, bo->capacity);
+  m_ops->mFreeBO(m_handle, bo->handle);
+  delete bo;
+}
+
+void
+device::
+clearBOCache()
+{
+  std::lock_guard<std::mutex> lk(m_bo_cache.mutex);
+  for (auto& entry : m_bo_cache.free) {
+    for (auto bo : entry.second) {
+      munmap(bo->hostAddr, bo->capacity);
+      m_ops->mFreeBO(m_handle, bo->handle);
+      delete bo;
+    }
+  }
+  m_bo_cache.free.clear();
+  m_bo_cache.stats.cached_bytes = 0;
+  m_bo_cache.stats.cached_bos = 0;
+}
+
+void
+device::
+setBOCacheSize(size_t bytes)
+{
+  {
+    std::lock_guard<std::mutex> lk(m_bo_cache.mutex);
+    m_bo_cache.max_bytes = bytes;
+    if (m_bo_cache.stats.cached_bytes <= bytes)
+      return;
+  }
+  clearBOCache();
+}
+
+hal::bo_cache_stats
+device::
+getBOCacheStats() const
+{
+  std::lock_guard<std::mutex> lk(m_bo_cache.mutex);
+  return m_bo_cache.stats;
+}
+
 BufferObjectHandle
 device::
 alloc(size_t sz)
 {
+  unsigned int flags = 0xFFFFFF; //TODO: check default, any bank.
+  if (m_bo_cache.max_bytes)
+    return allocCached(sz,flags);
+
   auto delBufferObject = [this](BufferObjectHandle::element_type* vbo) {
     BufferObject* bo = static_cast<BufferObject*>(vbo);
     XRT_DEBUG(std::cout,"deleted buffer object device address(",bo->deviceAddr,",",bo->size,")\n");
@@ -157,7 +307,6 @@ alloc(size_t sz)
   };
 
   xclBOKind kind = XCL_BO_DEVICE_RAM; //TODO: check default
-  uint64_t flags = 0xFFFFFF; //TODO: check default, any bank.
   auto ubo = xrt::make_unique<BufferObject>();
   ubo->handle = m_ops->mAllocBO(m_handle, sz, kind, flags);
   if (ubo->handle == 0xffffffff)
@@ -205,6 +354,13 @@ device::
 alloc(size_t sz, Domain domain, uint64_t memory_index, void* userptr)
 {
   const bool mmapRequired = (userptr == nullptr);
+  if (mmapRequired && m_bo_cache.max_bytes && domain!=Domain::XRT_DEVICE_PREALLOCATED_BRAM) {
+    unsigned int flags = memory_index;
+    if (domain==Domain::XRT_DEVICE_P2P_RAM)
+      flags |= (1<<30);
+    return allocCached(sz,flags);
+  }
+
   auto delBufferObject = [mmapRequired, this](BufferObjectHandle::element_type* vbo) {
     BufferObject* bo = static_cast<BufferObject*>(vbo);
     XRT_DEBUG(std::cout,"deleted buffer object device address(",bo->deviceAddr,",",bo->size,")\n");
@@ -301,6 +457,8 @@ free(const BufferObjectHandle& boh)
 {
   BufferObject* bo = getBufferObject(boh);
   m_ops->mFreeBO(m_handle, bo->handle);
+  if (bo->capacity)
+    bo->handle = 0xffffffff; // not to be cached when released
 }
 
 void
@@ -355,9 +513,81 @@ device::sync(const BufferObjectHandle& boh, size_t sz, size_t offset, direction
 event
 device::copy(const BufferObjectHandle& dst_boh, const BufferObjectHandle& src_boh, size_t sz, size_t dst_offset, size_t src_offset)
 {
+  if (!m_ops->mCopyBO)
+    throw std::runtime_error("copy not supported");
   BufferObject* dst_bo = getBufferObject(dst_boh);
   BufferObject* src_bo = getBufferObject(src_boh);
-  return event(typed_event<int>(m_ops->mCopyBO(m_handle, dst_bo->handle, src_bo->handle, sz, dst_offset, src_offset)));
+  return event(typed_event<int>(m_ops->mCopyBO(m_handle, dst_bo->handle, src_bo->handle, sz, dst_offset+dst_bo->offset, src_offset+src_bo->offset)));
+}
+
+event
+device::
+write_rect(const BufferObjectHandle& boh, const void* src, const hal::rect_region& r)
+{
+  BufferObject* bo = getBufferObject(boh);
+  char* hostAddr = static_cast<char*>(bo->hostAddr) + r.bo_offset;
+  auto host = static_cast<const char*>(src);
+  for (size_t z=0; z<r.depth; ++z)
+    for (size_t y=0; y<r.height; ++y)
+      std::memcpy(hostAddr + z*r.bo_slice_pitch + y*r.bo_row_pitch
+                  ,host + z*r.host_slice_pitch + y*r.host_row_pitch
+                  ,r.width);
+  return event(typed_event<int>(0));
+}
+
+event
+device::
+read_rect(const BufferObjectHandle& boh, void* dst, const hal::rect_region& r)
+{
+  BufferObject* bo = getBufferObject(boh);
+  const char* hostAddr = static_cast<const char*>(bo->hostAddr) + r.bo_offset;
+  auto host = static_cast<char*>(dst);
+  for (size_t z=0; z<r.depth; ++z)
+    for (size_t y=0; y<r.height; ++y)
+      std::memcpy(host + z*r.host_slice_pitch + y*r.host_row_pitch
+                  ,hostAddr + z*r.bo_slice_pitch + y*r.bo_row_pitch
+                  ,r.width);
+  return event(typed_event<int>(0));
+}
+
+event
+device::
+sync_rect(const BufferObjectHandle& boh, const hal::rect_region& r, direction dir)
+{
+  if (r.bo_contiguous())
+    return sync(boh,r.bo_extent(),r.bo_offset,dir,false);
+
+  // The HAL API has no strided sync, the extent covering the region is
+  // synced once.  The rows of the region are staged so that the other
+  // side of bytes between rows is kept: for HOST2DEVICE the extent is
+  // first refreshed from device, for DEVICE2HOST the host bytes of the
+  // extent are restored except for the rows.
+  BufferObject* bo = getBufferObject(boh);
+  auto extent = r.bo_extent();
+  auto offset = bo->offset + r.bo_offset;
+  auto hostAddr = static_cast<char*>(bo->hostAddr) + r.bo_offset;
+
+  hal::rect_region packed = r;
+  packed.host_row_pitch = r.width;
+  packed.host_slice_pitch = r.width*r.height;
+  std::vector<char> rows(r.width*r.height*r.depth);
+
+  int ret = 0;
+  if (dir==direction::HOST2DEVICE) {
+    read_rect(boh,rows.data(),packed);
+    ret = m_ops->mSyncBO(m_handle,bo->handle,XCL_BO_SYNC_BO_FROM_DEVICE,extent,offset);
+    write_rect(boh,rows.data(),packed);
+    if (!ret)
+      ret = m_ops->mSyncBO(m_handle,bo->handle,XCL_BO_SYNC_BO_TO_DEVICE,extent,offset);
+  }
+  else {
+    std::vector<char> saved(hostAddr,hostAddr+extent);
+    ret = m_ops->mSyncBO(m_handle,bo->handle,XCL_BO_SYNC_BO_FROM_DEVICE,extent,offset);
+    read_rect(boh,rows.data(),packed);
+    std::memcpy(hostAddr,saved.data(),extent);
+    write_rect(boh,rows.data(),packed);
+  }
+  return event(typed_event<int>(std::move(ret)));
 }
 
 size_t
@@ -414,6 +644,8 @@ int
 device::
 exec_wait(int timeout_ms) const
 {
+  if (!m_ops->mExecWait)
+    throw std::runtime_error("exec_wait not supported");
   return m_ops->mExecWait(m_handle,timeout_ms);
 }
 
@@ -454,7 +686,13 @@ getMemObjectFd(const BufferObjectHandle& boh)
 {
   if (!m_ops->mExportBO)
     throw std::runtime_error("ExportBO function not found in FPGA driver. Please install latest driver");
-  return m_ops->mExportBO(m_handle, getBufferObject(boh)->handle);
+  auto bo = getBufferObject(boh);
+  if (bo->capacity) {
+    // shared with the importer, must not be reused when released
+    std::lock_guard<std::mutex> lk(m_bo_cache.mutex);
+    bo->exported = true;
+  }
+  return m_ops->mExportBO(m_handle, bo->handle);
 }
 
 BufferObjectHandle
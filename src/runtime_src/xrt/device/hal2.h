@@ -21,6 +21,7 @@
 #include "xrt/device/halops2.h"
 #include "xrt/device/PMDOperations.h"
 
+#include <atomic>
 #include <cassert>
 
 #include <functional>
@@ -28,6 +29,8 @@
 #include <cstring>
 #include <memory>
 #include <map>
+#include <mutex>
+#include <vector>
 
 
 namespace xrt { namespace hal2 {
@@ -79,6 +82,8 @@ class device : public xrt::hal::device
     unsigned int flags = 0;
     hal2::device_handle owner = nullptr;
     BufferObjectHandle parent = nullptr;
+    size_t capacity = 0; // allocated size of a cacheable buffer object
+    bool exported = false; // cacheable buffer object shared by getMemObjectFd
   };
 
   struct ExecBufferObject : hal::exec_buffer_object
@@ -89,9 +94,41 @@ class device : public xrt::hal::device
     hal2::device_handle owner = nullptr;
   };
 
+  // Released buffer objects kept allocated and mapped for reuse,
+  // keyed by memory bank flags and size class.  Enabled when
+  // Runtime.bo_cache_size is non zero.  Only buffer objects of the
+  // currently open device handle (owner) are cached.
+  struct bo_cache
+  {
+    mutable std::mutex mutex;
+    std::map<std::pair<unsigned int,size_t>,std::vector<BufferObject*>> free;
+    std::atomic<size_t> max_bytes {0};
+    device_handle owner = nullptr;
+    hal::bo_cache_stats stats;
+  };
+  bo_cache m_bo_cache;
+
   BufferObject*
   getBufferObject(const BufferObjectHandle& boh) const;
 
+  /**
+   * Allocate mapped buffer object from cache or from driver
+   *
+   * The buffer object is allocated with the size class of sz and
+   * returned to the cache when released.
+   */
+  BufferObjectHandle
+  allocCached(size_t sz, unsigned int flags);
+
+  void
+  releaseCached(BufferObject* bo);
+
+  /**
+   * Free all cached buffer objects
+   */
+  void
+  clearBOCache();
+
   ExecBufferObject*
   getExecBufferObject(const ExecBufferObjectHandle& boh) const;
 
@@ -194,6 +231,10 @@ public:
     if (m_handle)
       retval = true;
 #endif
+    {
+      std::lock_guard<std::mutex> lk(m_bo_cache.mutex);
+      m_bo_cache.owner = m_handle;
+    }
     getDeviceInfo(&m_devinfo);
     return retval;
   }
@@ -202,6 +243,12 @@ public:
   close()
   {
     if (m_handle) {
+      {
+        // buffer objects released from now on are not cached
+        std::lock_guard<std::mutex> lk(m_bo_cache.mutex);
+        m_bo_cache.owner = nullptr;
+      }
+      clearBOCache();
       m_ops->mClose(m_handle);
       m_handle=nullptr;
     }
@@ -271,6 +318,12 @@ public:
   virtual void*
   alloc_svm(size_t sz);
 
+  virtual hal::bo_cache_stats
+  getBOCacheStats() const;
+
+  virtual void
+  setBOCacheSize(size_t bytes);
+
   virtual BufferObjectHandle
   import(const BufferObjectHandle& bo);
 
@@ -292,6 +345,15 @@ public:
   virtual event
   copy(const BufferObjectHandle& dst_bo, const BufferObjectHandle& src_bo, size_t sz, size_t dst_offset, size_t src_offset);
 
+  virtual event
+  write_rect(const BufferObjectHandle& bo, const void* buffer, const hal::rect_region& region);
+
+  virtual event
+  read_rect(const BufferObjectHandle& bo, void* buffer, const hal::rect_region& region);
+
+  virtual event
+  sync_rect(const BufferObjectHandle& bo, const hal::rect_region& region, direction dir);
+
   virtual size_t
   read_register(size_t offset, void* buffer, size_t size);
 
@@ -388,6 +450,12 @@ public:
     return (m_devinfo.mDeviceId != 0xffff);
   }
 
+  virtual bool
+  hasCopyBO() const
+  {
+    return m_ops->mCopyBO != nullptr;
+  }
+
   virtual hal::operations_result<ssize_t>
   readKernelCtrl(uint64_t offset,void* hbuf,size_t size)
   {
@@ -437,6 +505,14 @@ public:
     return m_ops->mGetDeviceClock(m_handle);
   }
 
+  virtual hal::operations_result<int>
+  getUsageInfo(xclDeviceUsage* info)
+  {
+    if (!m_ops->mGetUsageInfo)
+      return hal::operations_result<int>();
+    return m_ops->mGetUsageInfo(m_handle,info);
+  }
+
   virtual hal::operations_result<size_t>
   getDeviceTime()
   {
@@ -47,6 +47,7 @@ operations(const std::string &fileName, void *fileHandle, unsigned int count)
   ,mLockDevice(0)
   ,mUnlockDevice(0)
   ,mGetDeviceInfo(0)
+  ,mGetUsageInfo(0)
   ,mGetDeviceTime(0)
   ,mGetDeviceClock(0)
   ,mGetDeviceMaxRead(0)
@@ -122,6 +123,7 @@ operations(const std::string &fileName, void *fileHandle, unsigned int count)
   mLockDevice = (lockDeviceFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclLockDevice");
   mUnlockDevice = (unlockDeviceFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclUnlockDevice");
   mGetDeviceInfo = (getDeviceInfoFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclGetDeviceInfo2");
+  mGetUsageInfo = (getUsageInfoFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclGetUsageInfo");
 
   mCreateWriteQueue = (createWriteQueueFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclCreateWriteQueue");
   mCreateReadQueue = (createReadQueueFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclCreateReadQueue");
@@ -86,6 +86,7 @@ private:
   typedef int (* unlockDeviceFuncType)(xclDeviceHandle handle);
 
   typedef int (* getDeviceInfoFuncType)(xclDeviceHandle handle, xclDeviceInfo2 *info);
+  typedef int (* getUsageInfoFuncType)(xclDeviceHandle handle, xclDeviceUsage *info);
 
   typedef size_t (* getDeviceTimeFuncType)(xclDeviceHandle handle);
   typedef double (* getDeviceClockFuncType)(xclDeviceHandle handle);
@@ -170,6 +171,7 @@ public:
   lockDeviceFuncType mLockDevice;
   unlockDeviceFuncType mUnlockDevice;
   getDeviceInfoFuncType mGetDeviceInfo;
+  getUsageInfoFuncType mGetUsageInfo;
 
   getDeviceTimeFuncType mGetDeviceTime;
   getDeviceClockFuncType mGetDeviceClock;
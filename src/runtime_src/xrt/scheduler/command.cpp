@@ -18,12 +18,152 @@
 
 #include <map>
 #include <vector>
+#include <memory>
+#include <atomic>
+#include <array>
+#include <algorithm>
 
 namespace {
 
 using buffer_type = xrt::device::ExecBufferObjectHandle;
+using value_type = xrt::command::value_type;
 static std::mutex s_mutex;
 
+/**
+ * Recycled exec buffer object.
+ *
+ * The buffer object remains mapped while on the freelist, and
+ * records how many leading words were used by the command that
+ * released it.  Only those words need clearing when recycled.
+ */
+struct exec_buffer
+{
+  buffer_type bo;
+  value_type* data;
+  size_t used;
+};
+
+// Max number of exec buffers kept on a device freelist
+const size_t max_exec_buffers = 1024;
+
+/**
+ * Per device exec buffer freelist
+ *
+ * The freelist is cleared when the device is closed, and buffers
+ * released while the device is closed are not recycled.
+ */
+struct device_pool
+{
+  std::mutex mutex;
+  std::vector<exec_buffer> freelist;
+  bool closed = false;
+};
+
+/**
+ * Bounded lock-free freelist of command storage of one size
+ *
+ * Multi producer multi consumer ring of pointers.  The sequence
+ * number of a cell tells whether the cell is free or holds a
+ * pointer for the current lap over the ring.
+ */
+class storage_freelist
+{
+  static const size_t capacity = 512;
+
+  struct cell
+  {
+    std::atomic<size_t> seq;
+    void* ptr;
+  };
+
+  std::array<cell,capacity> m_cells;
+  std::atomic<size_t> m_head {0};
+  std::atomic<size_t> m_tail {0};
+
+public:
+  storage_freelist()
+  {
+    for (size_t i=0; i<capacity; ++i)
+      m_cells[i].seq.store(i,std::memory_order_relaxed);
+  }
+
+  /**
+   * @return
+   *   False if freelist is full
+   */
+  bool
+  push(void* ptr)
+  {
+    auto pos = m_head.load(std::memory_order_relaxed);
+    while (1) {
+      auto& c = m_cells[pos % capacity];
+      auto seq = c.seq.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+      if (diff==0) {
+        if (m_head.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed)) {
+          c.ptr = ptr;
+          c.seq.store(pos+1,std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff<0)
+        return false;
+      else
+        pos = m_head.load(std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @return
+   *   Recycled storage or nullptr if freelist is empty
+   */
+  void*
+  pop()
+  {
+    auto pos = m_tail.load(std::memory_order_relaxed);
+    while (1) {
+      auto& c = m_cells[pos % capacity];
+      auto seq = c.seq.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos+1);
+      if (diff==0) {
+        if (m_tail.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed)) {
+          auto ptr = c.ptr;
+          c.seq.store(pos+capacity,std::memory_order_release);
+          return ptr;
+        }
+      }
+      else if (diff<0)
+        return nullptr;
+      else
+        pos = m_tail.load(std::memory_order_relaxed);
+    }
+  }
+};
+
+// Command storage freelists, one per allocation size.  The number
+// of sizes is the number of command types created through
+// make_command, storage of other sizes is not recycled.
+const size_t max_storage_sizes = 8;
+struct storage_class
+{
+  std::atomic<size_t> size {0};
+  storage_freelist freelist;
+};
+static std::array<storage_class,max_storage_sizes> s_storage;
+
+static storage_freelist*
+get_storage_freelist(size_t sz)
+{
+  for (auto& sc : s_storage) {
+    auto size = sc.size.load(std::memory_order_acquire);
+    if (!size && sc.size.compare_exchange_strong(size,sz))
+      return &sc.freelist;
+    if (size==sz)
+      return &sc.freelist;
+  }
+  return nullptr;
+}
+
 // Static destruction logic to prevent double purging.
 
 // Exec buffer objects must be purged before device is closed.  Static
@@ -33,43 +173,93 @@ static std::mutex s_mutex;
 static bool s_purged = false;
 
 struct X {
-  std::map<xrt::device*,std::vector<buffer_type>> freelist;
+  std::map<xrt::device*,std::unique_ptr<device_pool>> pools;
   X() {}
   ~X() { s_purged = true; }
 };
 
 static X sx;
 
-static buffer_type
-get_buffer(xrt::device* device,size_t sz)
+/**
+ * Get the exec buffer pool for a device
+ *
+ * Pools are never deleted, only purged, so the last pool used by
+ * a thread is cached to avoid the global lock and map lookup.
+ */
+static device_pool*
+get_pool(xrt::device* device)
 {
+  static thread_local xrt::device* t_device = nullptr;
+  static thread_local device_pool* t_pool = nullptr;
+  if (t_device == device)
+    return t_pool;
+
   std::lock_guard<std::mutex> lk(s_mutex);
+  auto& pool = sx.pools[device];
+  if (!pool)
+    pool.reset(new device_pool);
+  t_device = device;
+  t_pool = pool.get();
+  return t_pool;
+}
 
-  auto itr = sx.freelist.find(device);
-  if (itr != sx.freelist.end()) {
-    auto& freelist = (*itr).second;
+static exec_buffer
+get_buffer(xrt::device* device,size_t sz)
+{
+  auto pool = get_pool(device);
+  {
+    std::lock_guard<std::mutex> lk(pool->mutex);
+    pool->closed = false;
+    auto& freelist = pool->freelist;
     if (!freelist.empty()) {
-      auto buffer = freelist.back();
+      auto buffer = std::move(freelist.back());
       freelist.pop_back();
       return buffer;
     }
   }
 
-  return device->allocExecBuffer(sz); // not thread safe
+  // A new buffer is cleared in full on first use
+  auto bo = device->allocExecBuffer(sz); // not thread safe
+  auto data = static_cast<value_type*>(device->map(bo));
+  return {std::move(bo),data,sz/sizeof(value_type)};
 }
 
 static void
-free_buffer(xrt::device* device,buffer_type bo)
+free_buffer(xrt::device* device,exec_buffer&& buffer)
 {
-  std::lock_guard<std::mutex> lk(s_mutex);
+  auto pool = get_pool(device);
+  std::lock_guard<std::mutex> lk(pool->mutex);
+  if (pool->closed || pool->freelist.size() >= max_exec_buffers)
+    return; // buffer object is released
   s_purged=false;
-  sx.freelist[device].emplace_back(std::move(bo));
+  pool->freelist.emplace_back(std::move(buffer));
 }
 
 } // namespace
 
 namespace xrt {
 
+namespace detail {
+
+void*
+alloc_command_storage(size_t sz)
+{
+  if (auto freelist = get_storage_freelist(sz))
+    if (auto ptr = freelist->pop())
+      return ptr;
+  return ::operator new(sz);
+}
+
+void
+free_command_storage(void* ptr, size_t sz)
+{
+  auto freelist = get_storage_freelist(sz);
+  if (!freelist || !freelist->push(ptr))
+    ::operator delete(ptr);
+}
+
+} // detail
+
 // Purge exec buffer freelist during static destruction.
 // Not safe to call outside of static descruction, can't lock
 // static mutex since it could have been destructed
@@ -79,23 +269,44 @@ purge_command_freelist()
   if (s_purged)
     return;
 
-  for (auto& elem : sx.freelist)
-    elem.second.clear();
+  for (auto& elem : sx.pools)
+    elem.second->freelist.clear();
+
+  for (auto& sc : s_storage)
+    while (auto ptr = sc.freelist.pop())
+      ::operator delete(ptr);
 
   s_purged = true;
 }
 
+void
+purge_command_freelist(xrt::device* device)
+{
+  std::lock_guard<std::mutex> lk(s_mutex);
+  auto itr = sx.pools.find(device);
+  if (itr==sx.pools.end())
+    return;
+
+  auto& pool = (*itr).second;
+  std::lock_guard<std::mutex> plk(pool->mutex);
+  pool->freelist.clear();
+  pool->closed = true;
+}
+
 command::
 command(xrt::device* device, ert_cmd_opcode opcode)
   : m_device(device)
-  , m_exec_bo(get_buffer(m_device,regmap_size*sizeof(value_type)))
-  , m_packet(m_device->map(m_exec_bo))
+  , m_packet(static_cast<value_type*>(nullptr))
 {
-  static unsigned int uid_count = 0;
+  static std::atomic<unsigned int> uid_count(0);
   m_uid = uid_count++;
 
+  auto buffer = get_buffer(m_device,regmap_size*sizeof(value_type));
+  m_exec_bo = std::move(buffer.bo);
+  m_packet = packet_type(buffer.data);
+
   // Clear in case packet was recycled
-  m_packet.clear();
+  m_packet.clear(buffer.used);
 
   auto epacket = get_ert_cmd<ert_packet*>();
   epacket->state = ERT_CMD_STATE_NEW; // new command
@@ -120,8 +331,12 @@ command::
 {
   if (m_exec_bo) {
     XRT_DEBUG(std::cout,"xrt::command::~command(",m_uid,")\n");
-    m_device->unmap(m_exec_bo);
-    free_buffer(m_device,m_exec_bo);
+
+    // Words used are those accessed through packet or covered by the
+    // payload count, whichever is larger.
+    auto epacket = get_ert_cmd<ert_packet*>();
+    size_t used = std::max(m_packet.size(),static_cast<size_t>(epacket->count)+1);
+    free_buffer(m_device,{std::move(m_exec_bo),m_packet.data(),used});
   }
 }
 
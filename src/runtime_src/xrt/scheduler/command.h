@@ -23,6 +23,7 @@
 
 #include <cstddef>
 #include <array>
+#include <memory>
 
 namespace xrt {
 
@@ -240,7 +241,64 @@ command_cast(const std::shared_ptr<command>& cmd)
   return cmd->get_ert_cmd<ERT_COMMAND_TYPE>();
 }
 
-  /**
+namespace detail {
+
+/**
+ * Storage for command objects, including shared_ptr control block,
+ * is recycled through a bounded lock-free freelist per allocation size
+ */
+void*
+alloc_command_storage(size_t sz);
+
+void
+free_command_storage(void* ptr, size_t sz);
+
+template <typename T>
+struct command_allocator
+{
+  using value_type = T;
+
+  command_allocator() = default;
+
+  template <typename U>
+  command_allocator(const command_allocator<U>&) {}
+
+  T* allocate(std::size_t num)
+  {
+    return static_cast<T*>(alloc_command_storage(num*sizeof(T)));
+  }
+
+  void deallocate(T* p, std::size_t num)
+  {
+    free_command_storage(p,num*sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const command_allocator<U>&) const { return true; }
+
+  template <typename U>
+  bool operator!=(const command_allocator<U>&) const { return false; }
+};
+
+} // detail
+
+/**
+ * Construct a command object with recycled storage
+ *
+ * Use in place of std::make_shared for commands that are created
+ * at high rate.  Command objects and their control blocks are
+ * allocated from a freelist, and the underlying exec buffer objects
+ * are recycled mapped per device.
+ */
+template <typename CommandType, typename ...Args>
+std::shared_ptr<CommandType>
+make_command(Args&&... args)
+{
+  return std::allocate_shared<CommandType>
+    (detail::command_allocator<CommandType>(),std::forward<Args>(args)...);
+}
+
+/**
  * Clear free list of exec buffer objects
  *
  * Command exec buffer objects are recycled, the freelist
@@ -249,6 +307,15 @@ command_cast(const std::shared_ptr<command>& cmd)
 void
 purge_command_freelist();
 
+/**
+ * Clear free list of exec buffer objects for a device
+ *
+ * Called when the device is closed.  Exec buffer objects
+ * released after this are not recycled.
+ */
+void
+purge_command_freelist(xrt::device* device);
+
 } // xrt
 
 #endif
@@ -29,21 +29,61 @@
 #include "xrt/util/debug.h"
 #include "xrt/util/time.h"
 #include "xrt/util/task.h"
+#include "xrt/util/memory.h"
+#include "xrt/util/mpscring.h"
 #include "xrt/device/device.h"
 #include "driver/include/ert.h"
 #include "command.h"
 
 #include <memory>
 #include <cstring>
+#include <limits>
 #include <algorithm>
 #include <thread>
-#include <list>
+#include <atomic>
+#include <array>
+#include <deque>
+#include <vector>
 #include <map>
 
 namespace {
 
 using command_type = std::shared_ptr<xrt::command>;
-using command_queue_type = std::list<command_type>;
+using command_queue_type = std::vector<command_type>;
+
+// Max number of launched commands not yet seen by command monitor
+static const size_t submit_ring_size = 4096;
+
+// CU masks of a start kernel command, all zero for other commands
+using cu_masks_type = std::array<uint32_t,4>;
+
+////////////////////////////////////////////////////////////////
+// Running commands with the same CU masks in submission order.
+// Commands are started in order as CUs in the masks become idle,
+// so at most 'width' (number of CUs in the masks) commands of the
+// queue can be executing, and only those need be checked for
+// completion.  Commands other than start kernel have no CUs and
+// are all checked.
+////////////////////////////////////////////////////////////////
+struct cu_queue
+{
+  std::deque<command_type> cmds;
+  size_t width = 0;
+};
+
+////////////////////////////////////////////////////////////////
+// Per device command queues.  Commands are submitted by host
+// threads through a lock-free ring, and moved by the device
+// monitor thread to the running queue of their CU masks.
+// Completed commands are collected in a batch for notification.
+////////////////////////////////////////////////////////////////
+struct device_queue
+{
+  xrt::mpsc_ring<command_type> submitted {submit_ring_size};
+  std::map<cu_masks_type,cu_queue> running;  // monitor thread only
+  size_t num_running = 0;  // monitor thread only
+  command_queue_type completed;  // monitor thread only
+};
 
 ////////////////////////////////////////////////////////////////
 // Command notification is threaded through task queue
@@ -58,11 +98,10 @@ static bool threaded_notification = true;
 // Main command monitor interfacing to embedded MB scheduler
 ////////////////////////////////////////////////////////////////
 static std::mutex s_mutex;
-static std::condition_variable s_work;
 static bool s_running = false;
-static bool s_stop = false;
+static std::atomic<bool> s_stop {false};
 static std::exception_ptr s_exception;
-static std::map<const xrt::device*, command_queue_type> s_device_cmds;
+static std::map<const xrt::device*, std::unique_ptr<device_queue>> s_device_cmds;
 static std::map<const xrt::device*, std::thread> s_device_monitor_threads;
 
 inline bool
@@ -79,24 +118,93 @@ is_command_done(const command_type& cmd)
   return epacket->state >= ERT_CMD_STATE_COMPLETED;
 }
 
-static bool
-check(const command_type& cmd)
+/**
+ * Notify host of completion of a batch of commands
+ *
+ * The batch is handed to the notifier as one task, the argument
+ * vector is left empty.
+ */
+static void
+notify_host(command_queue_type& batch)
 {
-  if (!is_command_done(cmd))
-    return false;
+  if (batch.empty())
+    return;
 
-  XRT_DEBUG(std::cout,"xrt::kds::command(",cmd->get_uid(),") [running->done]\n");
   if (!threaded_notification) {
-    cmd->notify(ERT_CMD_STATE_COMPLETED);
-    return true;
+    for (auto& cmd : batch)
+      cmd->notify(ERT_CMD_STATE_COMPLETED);
+    batch.clear();
+    return;
   }
 
-  auto notify = [](command_type c) {
-    c->notify(ERT_CMD_STATE_COMPLETED);
+  auto notify = [](const command_queue_type& cmds) {
+    for (auto& c : cmds)
+      c->notify(ERT_CMD_STATE_COMPLETED);
   };
 
-  xrt::task::createF(notify_queue,notify,cmd);
-  return true;
+  xrt::task::createF(notify_queue,notify,std::move(batch));
+  batch.clear();
+}
+
+static cu_masks_type
+get_cu_masks(const command_type& cmd)
+{
+  cu_masks_type masks {{0}};
+  auto skcmd = xrt::command_cast<ert_start_kernel_cmd*>(cmd.get());
+  if (skcmd->opcode != ERT_START_CU)
+    return masks;
+  auto& packet = cmd->get_packet();
+  for (size_t idx=0; idx<=skcmd->extra_cu_masks; ++idx)
+    masks[idx] = packet[1+idx];
+  return masks;
+}
+
+/**
+ * Add a submitted command to the running queue of its CU masks
+ */
+static void
+run(device_queue& dq, const command_type& cmd)
+{
+  auto masks = get_cu_masks(cmd);
+  auto& cq = dq.running[masks];
+  if (!cq.width) {
+    for (auto mask : masks)
+      cq.width += __builtin_popcount(mask);
+    if (!cq.width)
+      cq.width = std::numeric_limits<size_t>::max();
+  }
+  cq.cmds.push_back(cmd);
+  ++dq.num_running;
+}
+
+/**
+ * Retire completed commands
+ *
+ * The state word of a running command is read from its mapped exec
+ * buffer without any locking.  Per CU queue the commands are checked
+ * in order until as many commands as there are CUs are found still
+ * running, later commands cannot have started.  Completed commands
+ * are collected in the completed batch.
+ */
+static void
+check(device_queue& dq)
+{
+  for (auto& entry : dq.running) {
+    auto& cq = entry.second;
+    size_t pending = 0;
+    for (auto itr=cq.cmds.begin(); itr!=cq.cmds.end() && pending<cq.width; ) {
+      if (!is_command_done(*itr)) {
+        ++pending;
+        ++itr;
+        continue;
+      }
+
+      XRT_DEBUG(std::cout,"xrt::kds::command(",(*itr)->get_uid(),") [running->done]\n");
+      dq.completed.push_back(std::move(*itr));
+      itr = cq.cmds.erase(itr);
+      --dq.num_running;
+    }
+  }
 }
 
 static void
@@ -104,18 +212,18 @@ launch(command_type cmd)
 {
   XRT_DEBUG(std::cout,"xrt::kds::command(",cmd->get_uid(),") [new->submitted->running]\n");
 
-  // Submit the command
+  // thread safe access, since guaranteed to be inserted in init
   auto device = cmd->get_device();
-  auto exec_bo = cmd->get_exec_bo();
-  device->exec_buf(exec_bo);
+  auto& dq = *(s_device_cmds.find(device)->second);
 
-  // thread safe access, since guaranteed to be inserted in init
-  auto& submitted_cmds = s_device_cmds[device];
+  // Store command so completion can be tracked.  This is done prior
+  // to submitting the command, so that the monitor will find the
+  // command when it sees the completion interrupt.
+  dq.submitted.push(cmd);
 
-  // Store command so completion can be tracked
-  std::lock_guard<std::mutex> lk(s_mutex);
-  submitted_cmds.push_back(cmd);
-  s_work.notify_all();
+  // Submit the command
+  auto exec_bo = cmd->get_exec_bo();
+  device->exec_buf(exec_bo);
 }
 
 static void
@@ -125,20 +233,16 @@ monitor_loop(const xrt::device* device)
   unsigned long sleeps = 0;          // number of sleeps
 
   // thread safe access, since guaranteed to be inserted in init
-  auto& submitted_cmds = s_device_cmds[device];
+  auto& dq = *(s_device_cmds.find(device)->second);
 
   while (1) {
     ++loops;
 
     {
-      {
-        std::unique_lock<std::mutex> lk(s_mutex);
-
-        // Larger wait
-        while (!s_stop && submitted_cmds.empty()) {
-          ++sleeps;
-          s_work.wait(lk);
-        }
+      // Larger wait
+      while (!s_stop && !dq.num_running && dq.submitted.empty()) {
+        ++sleeps;
+        dq.submitted.wait([]{return s_stop.load();});
       }
 
       if (s_stop)
@@ -147,18 +251,11 @@ monitor_loop(const xrt::device* device)
       // Finer wait
       while (device->exec_wait(1000)==0) ;
 
-      std::lock_guard<std::mutex> lk(s_mutex);
-      auto end = submitted_cmds.end();
-      for (auto itr=submitted_cmds.begin(); itr!=end; ) {
-        auto& cmd = (*itr);
-        if (check(cmd)) {
-          itr = submitted_cmds.erase(itr);
-          end = submitted_cmds.end();
-        }
-        else {
-          ++itr;
-        }
-      }
+      // Pick up commands launched so far
+      dq.submitted.consume([&dq](const command_type& cmd){run(dq,cmd);});
+
+      check(dq);
+      notify_host(dq.completed);
     }
   }
 }
@@ -212,12 +309,9 @@ stop()
   if (!s_running)
     return;
 
-  {
-    std::lock_guard<std::mutex> lk(s_mutex);
-    s_stop = true;
-  }
-
-  s_work.notify_all();
+  s_stop = true;
+  for (auto& e : s_device_cmds)
+    e.second->submitted.wake();
   for (auto& e : s_device_monitor_threads)
     e.second.join();
 
@@ -279,7 +373,7 @@ init(xrt::device* device, size_t regmap_size, bool cu_isr, size_t num_cus, size_
   auto itr = s_device_monitor_threads.find(device);
   if (itr==s_device_monitor_threads.end()) {
     XRT_DEBUG(std::cout,"creating monitor thread and queue for device '",device->getName(),"'\n");
-    s_device_cmds.emplace(device,command_queue_type());
+    s_device_cmds.emplace(device,xrt::make_unique<device_queue>());
     s_device_monitor_threads.emplace(device,xrt::thread(::monitor,device));
   }
 
@@ -25,13 +25,25 @@
 #include "xrt/util/debug.h"
 #include "xrt/util/thread.h"
 #include "xrt/util/task.h"
+#include "xrt/util/time.h"
+#include "xrt/util/message.h"
+#include "xrt/util/memory.h"
+#include "xrt/util/mpscring.h"
 #include "command.h"
 #include <limits>
-#include <bitset>
+#include <array>
+#include <deque>
+#include <iterator>
 #include <vector>
 #include <list>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <sys/prctl.h>
 
 namespace {
 
@@ -47,7 +59,112 @@ using command_type = std::shared_ptr<xrt::command>;
 // Constants
 ////////////////////////////////////////////////////////////////
 const size_type max_cus = 128;
-using bitmask_type = std::bitset<max_cus>;
+
+/**
+ * Fixed size CU bitmask
+ *
+ * Stored in machine words so that intersection of a command's CUs
+ * with idle CUs, and selection of a CU from the result, is a few
+ * word operations rather than a scan over all CU indices.
+ */
+class bitmask_type
+{
+  using word_type = uint64_t;
+  static const size_type word_bits = sizeof(word_type)*8;
+  static const size_type num_words = max_cus/word_bits;
+  std::array<word_type,num_words> m_words;
+
+public:
+  bitmask_type()
+  {
+    m_words.fill(0);
+  }
+
+  void
+  set(size_type bit)
+  {
+    m_words[bit/word_bits] |= (word_type(1) << (bit%word_bits));
+  }
+
+  void
+  reset(size_type bit)
+  {
+    m_words[bit/word_bits] &= ~(word_type(1) << (bit%word_bits));
+  }
+
+  void
+  reset()
+  {
+    m_words.fill(0);
+  }
+
+  bool
+  test(size_type bit) const
+  {
+    return m_words[bit/word_bits] & (word_type(1) << (bit%word_bits));
+  }
+
+  bool
+  any() const
+  {
+    for (auto w : m_words)
+      if (w)
+        return true;
+    return false;
+  }
+
+  /**
+   * @return
+   *   Index of lowest set bit, or max_cus if no bit is set
+   */
+  size_type
+  find_first() const
+  {
+    for (size_type w=0; w<num_words; ++w)
+      if (m_words[w])
+        return w*word_bits + __builtin_ctzll(m_words[w]);
+    return max_cus;
+  }
+
+  /**
+   * Get/set 32 bit word [idx] of mask, as used in command packets
+   */
+  value_type
+  get_word32(size_type idx) const
+  {
+    return (m_words[idx/2] >> (32*(idx%2))) & 0xFFFFFFFF;
+  }
+
+  void
+  set_word32(size_type idx, value_type value)
+  {
+    m_words[idx/2] |= (word_type(value) << (32*(idx%2)));
+  }
+
+  bitmask_type
+  operator & (const bitmask_type& rhs) const
+  {
+    bitmask_type ret;
+    for (size_type w=0; w<num_words; ++w)
+      ret.m_words[w] = m_words[w] & rhs.m_words[w];
+    return ret;
+  }
+
+  bitmask_type
+  operator ~ () const
+  {
+    bitmask_type ret;
+    for (size_type w=0; w<num_words; ++w)
+      ret.m_words[w] = ~m_words[w];
+    return ret;
+  }
+
+  bool
+  operator < (const bitmask_type& rhs) const
+  {
+    return m_words < rhs.m_words;
+  }
+};
 
 // FFA  handling
 const size_type CONTROL_AP_START=1;
@@ -60,24 +177,6 @@ const size_type CONTROL_AP_IDLE=4;
 const value_type CMD_START_KERNEL = 0;
 const value_type CMD_CONFIGURE = 1;
 
-////////////////////////////////////////////////////////////////
-// Configuarable constants
-////////////////////////////////////////////////////////////////
-// Actual number of cus
-static size_type num_cus = 0;
-
-// CU base address
-static addr_type cu_base_address = 0x0;
-
-// CU offset (addone is 32k (1<<15), OCL is 4k (1<<12))
-static size_type cu_offset = 12;
-
-// Enable features via  configure_mb
-static value_type cu_trace_enabled = 0;
-
-// Mapping from cu_idx to its base address
-static std::vector<uint32_t> cu_addr_map;
-
 ////////////////////////////////////////////////////////////////
 // Helper functions for extracting command header information
 ////////////////////////////////////////////////////////////////
@@ -117,21 +216,22 @@ regmap_size(value_type header_value)
   return payload_size(header_value) - cu_masks(header_value);
 }
 
-/**
- * Convert cu idx into cu address
- */
-inline addr_type
-cu_idx_to_addr(size_type cu_idx)
-{
-  return cu_addr_map[cu_idx];
-}
-
 struct slot_info
 {
   command_type cmd;
   xrt::device* device = nullptr;
   bitmask_type cus;
 
+  // CU the command is running on
+  size_type cu_idx = max_cus;
+
+  // Position of slot in command queue, for O(1) retirement
+  std::list<slot_info>::iterator itr;
+
+  // Order of submission, used to start commands of different
+  // CU classes in the order they were submitted
+  uint64_t seq = 0;
+
   // Last command header read from slot in command queue
   // Last 4 bits of header are used for slot status per mb state
   // new     [0x1]: the command is in new state per host
@@ -156,11 +256,12 @@ struct slot_info
     return cmd->get_packet();
   }
 
-  void start(size_type cu)
+  void start(size_type cu, bool cu_trace_enabled)
   {
     // update cus to reflect running cu
     cus.reset();
     cus.set(cu);
+    cu_idx = cu;
 
     // If cu tracing is enabled then update command packet cumask
     // to reflect running cu prior to invoking the command callback
@@ -168,7 +269,7 @@ struct slot_info
       auto& packet = get_packet();
       auto cumasks = cu_masks(header_value);
       for (size_type i=0; i<cumasks; ++i) {
-        packet[1+i] = ((cus>>(sizeof(value_type)*8*i)).to_ulong()) & 0xFFFFFFFF;
+        packet[1+i] = cus.get_word32(i);
       }
     }
 
@@ -179,43 +280,12 @@ struct slot_info
 
 // Command notification is threaded through task queue
 // and notifier.  This allows the scheduler to continue
-// while host callback can be processed in the background
+// while host callback can be processed in the background.
+// The notifier is shared by all device schedulers.
 static xrt::task::queue notify_queue;
 static std::thread notifier;
 static bool threaded_notification = true;
 
-static std::list<slot_info> command_queue;
-
-// Fixed sized map from cu_idx -> slot_info
-static const slot_info* cu_slot_usage[max_cus];
-
-// Bitmask indicating status of CUs. (0) idle, (1) running.
-// Only 'num_cus' lower bits are used
-static bitmask_type cu_status;
-
-// Track runtime of each cu
-static uint64_t cu_total_runtime[max_cus] = {0};
-static uint64_t cu_start_time[max_cus] = {0};
-static uint64_t cu_stop_time[max_cus] = {0};
-
-
-/**
- * MB configuration
- */
-static void
-setup()
-{
-  command_queue.clear();
-
-  // Initialize cu_slot_usage
-  for (size_type i=0; i<num_cus; ++i) {
-    cu_slot_usage[i] = nullptr;
-    cu_total_runtime[i] = 0;
-    cu_start_time[i] = 0;
-    cu_stop_time[i] = 0;
-  }
-}
-
 /**
  * Notify host of command completion
  *
@@ -247,295 +317,635 @@ notify_host(slot_info* slot)
   xrt::task::createF(notify_queue,notify,slot->cmd);
 }
 
+// Timeout when waiting for interrupt
+static const int interrupt_timeout_ms = 1;
+
+// Max number of submitted commands not yet seen by scheduler
+static const size_t submit_ring_size = 4096;
+
 /**
- * Configure a CU at argument address
+ * Software scheduler for one device
  *
- * Write register map to CU control register at address
- *
- * @param cu_addr
- *  Address of CU control register
- * @param regmap_addr
- *  The address of the register map to copy into the CU control
- *  register
- * @param regmap_size
- *  The size of register map in 32 bit words
+ * Each device has its own command queue, CU state, and scheduler
+ * thread, so that multiple devices in one process can be scheduled
+ * independently.
  */
-inline void
-configure_cu(slot_info* slot, size_type cu)
+class device_scheduler
 {
-  auto cu_addr = cu_idx_to_addr(cu);
-  auto size = regmap_size(slot->header_value);
+  xrt::device* m_device = nullptr;
+
+  ////////////////////////////////////////////////////////////////
+  // Configuarable constants
+  ////////////////////////////////////////////////////////////////
+  // Actual number of cus
+  size_type num_cus = 0;
+
+  // CU base address
+  addr_type cu_base_address = 0x0;
+
+  // CU offset (addone is 32k (1<<15), OCL is 4k (1<<12))
+  size_type cu_offset = 12;
+
+  // Enable features via  configure_mb
+  value_type cu_trace_enabled = 0;
+
+  // Mapping from cu_idx to its base address
+  std::vector<uint32_t> cu_addr_map;
+
+  ////////////////////////////////////////////////////////////////
+  // Scheduler state
+  ////////////////////////////////////////////////////////////////
+  // All active commands in order of submission
+  std::list<slot_info> command_queue;
+
+  // Queued kernel commands per CU class.  A CU class is the set of
+  // CUs a command can run on.  Each ready queue is FIFO.
+  std::map<bitmask_type, std::deque<slot_info*>> ready_queues;
+
+  // Submission sequence number of next queued command
+  uint64_t next_seq = 0;
+
+  // Queued non kernel (special) commands
+  std::deque<slot_info*> special_queue;
+
+  // Fixed sized map from cu_idx -> slot_info
+  slot_info* cu_slot_usage[max_cus];
+
+  // Bitmask indicating status of CUs. (0) idle, (1) running.
+  // Only 'num_cus' lower bits are used
+  bitmask_type cu_status;
+
+  // Bitmask with the lower 'num_cus' bits set
+  bitmask_type cu_valid;
+
+  // Track runtime of each cu
+  uint64_t cu_total_runtime[max_cus] = {0};
+  uint64_t cu_start_time[max_cus] = {0};
+  uint64_t cu_stop_time[max_cus] = {0};
+
+  ////////////////////////////////////////////////////////////////
+  // Submission from host through lock-free ring.  The mutex only
+  // protects (re)configuration of the scheduler.
+  ////////////////////////////////////////////////////////////////
+  std::mutex m_mutex;
+  std::atomic<bool> m_stop {false};
+  xrt::mpsc_ring<command_type> m_submitted {submit_ring_size};
+  std::thread m_thread;
+
+  ////////////////////////////////////////////////////////////////
+  // Idle handling.  When a pass over the command queue makes no
+  // progress, the scheduler does not immediately poll the CUs
+  // again.  It either waits for a CU completion interrupt through
+  // exec_wait, or it backs off exponentially before next poll.
+  ////////////////////////////////////////////////////////////////
+  // Wait on interrupt, disabled if device doesn't support exec_wait
+  bool m_interrupt = false;
+
+  // Current and max backoff in microseconds, 0 means busy poll
+  unsigned int m_backoff_us = 0;
+  unsigned int m_max_backoff_us = 0;
+
+  // Statistics
+  unsigned long m_polls = 0;          // passes without progress
+  unsigned long m_poll_ns = 0;        // time spent in such passes
+  unsigned long m_idle_waits = 0;     // number of waits/backoffs
+  unsigned long m_polls_avoided = 0;  // estimated polls not done
+
+  /**
+   * Convert cu idx into cu address
+   */
+  addr_type
+  cu_idx_to_addr(size_type cu_idx) const
+  {
+    return cu_addr_map[cu_idx];
+  }
 
-  // data past header and cu_masks
-  auto regmap = slot->get_packet().data() + 1 + cu_masks(slot->header_value);
+  /**
+   * MB configuration
+   */
+  void
+  setup()
+  {
+    // Initialize cu_slot_usage
+    cu_status.reset();
+    cu_valid.reset();
+    for (size_type i=0; i<num_cus; ++i) {
+      cu_valid.set(i);
+      cu_slot_usage[i] = nullptr;
+      cu_total_runtime[i] = 0;
+      cu_start_time[i] = 0;
+      cu_stop_time[i] = 0;
+    }
+  }
 
-  // write register map, starting at base + 0xC
-  // 0x4, 0x8 used for interrupt, which is initialized in setu
-  slot->device->write_register(cu_addr,regmap,size*4);
+  /**
+   * Configure a CU at argument address
+   *
+   * Write register map to CU control register at address
+   *
+   * @param cu_addr
+   *  Address of CU control register
+   * @param regmap_addr
+   *  The address of the register map to copy into the CU control
+   *  register
+   * @param regmap_size
+   *  The size of register map in 32 bit words
+   */
+  void
+  configure_cu(slot_info* slot, size_type cu)
+  {
+    auto cu_addr = cu_idx_to_addr(cu);
+    auto size = regmap_size(slot->header_value);
 
-  // start cu
-  const_cast<uint32_t*>(regmap)[0] = 1;
-  slot->device->write_register(cu_addr,regmap,size*4);
-}
+    // data past header and cu_masks
+    auto regmap = slot->get_packet().data() + 1 + cu_masks(slot->header_value);
 
-/**
- * Start a cu for command in slot
- *
- * @param slot_idx
- *  Index of command
- * @return
- *  True of a CU was started, false otherwise
- */
-static bool
-start_cu(slot_info* slot)
-{
-  auto cus = slot->cus;
-
-  // Check all CUs against argument cus mask and against cu_status
-  for (size_type cu=0; cu<num_cus; ++cu) {
-    if (cus.test(cu) && !cu_status.test(cu)) {
-      slot->start(cu);           // note that slot is starting on cu
-      configure_cu(slot,cu);
-      cu_status.flip(cu);        // toggle cu status bit, it is now busy
-      cu_slot_usage[cu] = slot;
-      return true;
+    // write register map, starting at base + 0xC
+    // 0x4, 0x8 used for interrupt, which is initialized in setu
+    slot->device->write_register(cu_addr,regmap,size*4);
+
+    // start cu
+    const_cast<uint32_t*>(regmap)[0] = 1;
+    slot->device->write_register(cu_addr,regmap,size*4);
+  }
+
+  /**
+   * Start a cu for command in slot
+   *
+   * @param slot
+   *  Command to start
+   * @param cu
+   *  Idle CU to start command on
+   */
+  void
+  start_cu(slot_info* slot, size_type cu)
+  {
+    slot->start(cu,cu_trace_enabled);  // note that slot is starting on cu
+    configure_cu(slot,cu);
+    cu_status.set(cu);                 // cu is now busy
+    cu_slot_usage[cu] = slot;
+  }
+
+  /**
+   * Start queued commands on idle CUs
+   *
+   * For each CU class the idle CUs are the intersection of the class
+   * mask with the complement of cu_status.  Of the classes with an
+   * idle CU, the command at the front of the class whose front was
+   * submitted first is started on the lowest idle CU.  This repeats
+   * until no class with queued commands has an idle CU, so commands
+   * start in submission order except where their CUs are busy.
+   *
+   * @return
+   *  True if any command was started, false otherwise
+   */
+  bool
+  start_cus()
+  {
+    bool started = false;
+    while (1) {
+      std::deque<slot_info*>* first = nullptr;
+      size_type first_cu = max_cus;
+      for (auto& rq : ready_queues) {
+        auto& queue = rq.second;
+        if (queue.empty() || (first && first->front()->seq < queue.front()->seq))
+          continue;
+        auto cu = (rq.first & ~cu_status).find_first();
+        if (cu == max_cus)
+          continue;
+        first = &queue;
+        first_cu = cu;
+      }
+
+      if (!first)
+        return started;
+
+      auto slot = first->front();
+      first->pop_front();
+      start_cu(slot,first_cu);
+      slot->header_value |= 0x1; // running (0x2->0x3)
+      XRT_DEBUGF("slot(%d) [queued->running]\n",slot->get_uid());
+      started = true;
     }
   }
-  return false;
-}
 
-/**
- * Check CU status
- *
- * CU to check is indicated by bit position in argument cu_mask.
- *
- * If CU is done, then host status register is updated accordingly
- * and internal cu_status register that tracks running CUs is toggled
- * at corresponding position.
- *
- * @param cu_mask
- *   A bitmask with 1 bit set. Position of bit indicates the CU to check
- * @return
- *   True if CU is done, false otherwise
- */
-static bool
-check_cu(slot_info* slot,bool wait=false)
-{
-  auto device = slot->device;
-  auto& cu_mask = slot->cus;
-
-  // find cu idx in mask
-  size_type cu_idx = 0;
-  for (; !cu_mask.test(cu_idx); ++cu_idx);
-  XRT_ASSERT(cu_idx < num_cus,"bad cu idx");
-  XRT_ASSERT(cu_status.test(cu_idx),"cu wasn't started");
-  auto cu_addr = cu_idx_to_addr(cu_idx);
-  value_type ctrlreg = 0;
-
-  do {
-    device->read_register(cu_addr,&ctrlreg,4);
+  /**
+   * Check CU status
+   *
+   * If CU is done, then internal cu_status register that tracks
+   * running CUs is toggled at corresponding position.
+   *
+   * @param cu_idx
+   *   The CU to check
+   * @return
+   *   True if CU is done, false otherwise
+   */
+  bool
+  check_cu(size_type cu_idx)
+  {
+    XRT_ASSERT(cu_idx < num_cus,"bad cu idx");
+    XRT_ASSERT(cu_status.test(cu_idx),"cu wasn't started");
+    auto cu_addr = cu_idx_to_addr(cu_idx);
+    value_type ctrlreg = 0;
+
+    m_device->read_register(cu_addr,&ctrlreg,4);
     if (ctrlreg & (CONTROL_AP_IDLE | CONTROL_AP_DONE)) {
-      cu_status.flip(cu_idx);
-      cu_slot_usage[cu_idx] = nullptr;
+      cu_status.reset(cu_idx);
       return true;
     }
-  } while (wait);
 
-  return false;
-}
+    return false;
+  }
 
-/**
- * Check if queue is idle except for command in argument slot
- */
-static bool
-check_idle_prereq(slot_info* slot)
-{
-  auto end=command_queue.end();
-  for (auto itr=command_queue.begin(); itr!=end; ++itr) {
-    auto s = &(*itr);
-    if (s==slot)
-      continue;
-    if ((s->header_value & 0xF) != 0x4) {
-      XRT_DEBUGF("slot(%d) is busy\n",s->get_uid());
-      return false;
+  /**
+   * Retire commands on completed CUs
+   *
+   * Only running CUs are checked, and the command on a completed CU
+   * is found directly through cu_slot_usage.
+   *
+   * @return
+   *  True if any command completed, false otherwise
+   */
+  bool
+  check_cus()
+  {
+    bool done = false;
+    auto running = cu_status;
+    for (auto cu=running.find_first(); cu<max_cus; cu=running.find_first()) {
+      running.reset(cu);
+      if (!check_cu(cu))
+        continue;
+      auto slot = cu_slot_usage[cu];
+      cu_slot_usage[cu] = nullptr;
+      notify_host(slot);
+      XRT_DEBUGF("slot(%d) [running->free]\n",slot->get_uid());
+      command_queue.erase(slot->itr);
+      done = true;
     }
+    return done;
   }
 
-  return true;
-}
+  /**
+   * Check if queue is idle except for command in argument slot
+   */
+  bool
+  check_idle_prereq(slot_info* slot)
+  {
+    auto end=command_queue.end();
+    for (auto itr=command_queue.begin(); itr!=end; ++itr) {
+      auto s = &(*itr);
+      if (s==slot)
+        continue;
+      if ((s->header_value & 0xF) != 0x4) {
+        XRT_DEBUGF("slot(%d) is busy\n",s->get_uid());
+        return false;
+      }
+    }
 
+    return true;
+  }
 
-/**
- * Configure MB and peripherals
- *
- * Wait for CONFIGURE_MB in specified slot, then configure as
- * requested.
- *
- * This function is used in two different scenarios:
- *  1. MB reset/startup, in which case the CONFIGURE_MB is guaranteed
- *     to be in a slot at default slot offset (4K), most likely slot 0.
- *  2. During regular scheduler loop, in which case the CONFIGURE_MB
- *     packet is at an arbitrary slot location.   In this scenario, the
- *     function may return (false) without processing the command if
- *     other commands are currently executing; this is to avoid hardware
- *     lockup.
- *
- * @param slot_idx
- *   The slot index with the CONFIGURE_MB command
- * @return
- *   True if CONFIGURE_MB packet was processed, false otherwise
- */
-static bool
-configure(slot_info* slot)
-{
-  // Ignore the CONFIGURE packet if any commands are
-  // currently being processed.  The main scheduler loop
-  // will revisit the CONFIGURE packet again in case 2).
-  if (!check_idle_prereq(slot))
+  /**
+   * Configure MB and peripherals
+   *
+   * Wait for CONFIGURE_MB in specified slot, then configure as
+   * requested.
+   *
+   * This function is used in two different scenarios:
+   *  1. MB reset/startup, in which case the CONFIGURE_MB is guaranteed
+   *     to be in a slot at default slot offset (4K), most likely slot 0.
+   *  2. During regular scheduler loop, in which case the CONFIGURE_MB
+   *     packet is at an arbitrary slot location.   In this scenario, the
+   *     function may return (false) without processing the command if
+   *     other commands are currently executing; this is to avoid hardware
+   *     lockup.
+   *
+   * @param slot_idx
+   *   The slot index with the CONFIGURE_MB command
+   * @return
+   *   True if CONFIGURE_MB packet was processed, false otherwise
+   */
+  bool
+  configure(slot_info* slot)
+  {
+    // Ignore the CONFIGURE packet if any commands are
+    // currently being processed.  The main scheduler loop
+    // will revisit the CONFIGURE packet again in case 2).
+    if (!check_idle_prereq(slot))
+      return false;
+
+    XRT_DEBUGF("configure found)\n");
+    XRT_DEBUGF("slot(%d) [new->queued]\n",slot->get_uid());
+    XRT_DEBUGF("slot(%d) [queued->running]\n",slot->get_uid());
+
+    auto& packet = slot->get_packet();
+    num_cus=packet[2];
+    cu_offset=packet[3];
+    cu_base_address=packet[4];
+
+    // Features
+    auto features = packet[5];
+    cu_trace_enabled = features & 0x8;
+
+    // (Re)initilize MB
+    setup();
+
+    // notify host
+    notify_host(slot);
+
+    XRT_DEBUGF("slot(%d) [running->free]\n",slot->get_uid());
+    command_queue.erase(slot->itr);
+
+    return true;
+  }
+
+  /**
+   * Process special command.
+   *
+   * Special commands are not performace critical
+   *
+   * @return true
+   *   If command was processed, false otherwise
+   */
+  bool
+  process_special_command(slot_info* slot, size_type opcode)
+  {
+    if (opcode==CMD_CONFIGURE)
+      return configure(slot);
     return false;
+  }
 
-  XRT_DEBUGF("configure found)\n");
-  XRT_DEBUGF("slot(%d) [new->queued]\n",slot->get_uid());
-  XRT_DEBUGF("slot(%d) [queued->running]\n",slot->get_uid());
+  /**
+   * Wait for CU completion or backoff before next poll
+   *
+   * Returns early if new commands are scheduled or if the
+   * scheduler is stopped.  The interrupt wait cannot be ended by
+   * new commands, so it is used only when all CUs are busy and a
+   * new command could not start anyway.
+   */
+  void
+  idle_wait()
+  {
+    if (!m_interrupt && !m_max_backoff_us)
+      return;
 
-  auto& packet = slot->get_packet();
-  num_cus=packet[2];
-  cu_offset=packet[3];
-  cu_base_address=packet[4];
+    ++m_idle_waits;
+    auto zero = xrt::time_ns();
 
-  // Features
-  auto features = packet[5];
-  cu_trace_enabled = features & 0x8;
+    if (m_interrupt && !(cu_valid & ~cu_status).any()) {
+      int ret = -1;
+      try {
+        ret = m_device->exec_wait(interrupt_timeout_ms);
+      }
+      catch (const std::exception&) {
+      }
+      if (ret < 0) {
+        xrt::message::send(xrt::message::severity_level::WARNING,
+                           "sws: exec_wait not supported by device, falling back to polling");
+        m_interrupt = false;
+      }
+    }
+    else {
+      m_backoff_us = std::min(m_backoff_us ? 2*m_backoff_us : 1, m_max_backoff_us);
+      m_submitted.wait_for(std::chrono::microseconds(m_backoff_us),[this]{return m_stop.load();});
+    }
 
-  // (Re)initilize MB
-  setup();
+    if (m_polls)
+      m_polls_avoided += (xrt::time_ns() - zero) / std::max(m_poll_ns/m_polls,1UL);
+  }
 
-  // notify host
-  notify_host(slot);
+  /**
+   * Add new command to command queue
+   *
+   * Kernel commands transition to queued (0x2) in the ready queue
+   * for their CU class.  Other commands are processed in order of
+   * submission as special commands.
+   */
+  void
+  queue_command(const command_type& cmd)
+  {
+    command_queue.emplace_back(cmd);
+    auto slot = &command_queue.back();
+    slot->itr = std::prev(command_queue.end());
+
+    auto opc = opcode(slot->header_value);
+    if (opc!=CMD_START_KERNEL) { // Non performance critical command
+      special_queue.push_back(slot);
+      return;
+    }
 
-  slot->header_value = (slot->header_value & ~0xF) | 0x4; // free
-  XRT_DEBUGF("slot(%d) [running->free]\n",slot->get_uid());
+    // Extract and cache cumask from cmd
+    size_type cumasks = cu_masks(slot->header_value);
+    auto& payload = slot->get_packet();
+    for (size_type i=0; i<cumasks; ++i)
+      slot->cus.set_word32(i,payload[1+i]);
+    slot->cus = slot->cus & cu_valid;
+
+    slot->header_value = (slot->header_value & ~0xF) | 0x2; // queued
+    slot->seq = next_seq++;
+    ready_queues[slot->cus].push_back(slot);
+    XRT_DEBUGF("slot(%d) [new->queued]\n",slot->get_uid());
+  }
 
-  return true;
-}
+  /**
+   * Main routine executed by embedded scheduler loop
+   *
+   * Each iteration
+   *  1. New commands are moved to the ready queue of their CU class
+   *     Status transitions from new (0x1) to queued (0x2)
+   *  2. Special commands are processed when the scheduler is idle
+   *  3. Queued commands are started on idle CUs of their class
+   *     Status remains queued if no CUs available, or transitions to running (0x3)
+   *  4. Running CUs are checked for completion
+   *     Command is retired and notified if its CU is done
+   */
+  void
+  scheduler_loop()
+  {
+    // Basic setup will be changed by configure_mb, but is necessary
+    // for even configure_mb() to work.
+    setup();
 
-/**
- * Process special command.
- *
- * Special commands are not performace critical
- *
- * @return true
- *   If command was processed, false otherwise
- */
-static bool
-process_special_command(slot_info* slot, size_type opcode)
-{
-  if (opcode==CMD_CONFIGURE)
-    return configure(slot);
-  return false;
-}
+    // Backoff waits are a few microseconds, the default timer slack
+    // of 50us would dominate them
+    prctl(PR_SET_TIMERSLACK,1000UL);
 
-static std::mutex s_mutex;
-static std::condition_variable s_work;
-static bool s_stop=false;
-static std::vector<command_type> s_cmds;
+    // Set when any command changes state during a pass
+    bool progress = true;
 
-/**
- * Main routine executed by embedded scheduler loop
- *
- * For each command slot do
- *  1. If status is free (0x4), then read new command header
- *     Status remains free (0x4), or transitions to new (0x1)
- *  2. If status is new (0x1), then read CUs in command
- *     Status transitions to queued (0x2)
- *  3. If status is queued (0x2), then start command on available CU
- *     Status remains queued if no CUs available, or transitions to running (0x3)
- *  4. If status is running (0x4), then check CU status
- *     Status remains running (0x4) if CU is still running, or
- *     transitions to free if CU is done
- */
-static void
-scheduler_loop()
-{
-  // Basic setup will be changed by configure_mb, but is necessary
-  // for even configure_mb() to work.
-  setup();
+    while (1) {
 
-  while (1) {
+      if (progress)
+        m_backoff_us = 0;
+      else if (!command_queue.empty() && m_submitted.empty() && !m_stop)
+        idle_wait();
 
-    {
-      std::unique_lock<std::mutex> lk(s_mutex);
-      while (!s_stop && command_queue.empty() && s_cmds.empty())
-        s_work.wait(lk);
+      while (!m_stop && command_queue.empty() && m_submitted.empty())
+        m_submitted.wait([this]{return m_stop.load();});
 
-      if (s_stop) {
-        if (!command_queue.empty() || !s_cmds.empty())
+      if (m_stop) {
+        if (!command_queue.empty() || !m_submitted.empty())
           throw std::runtime_error("software scheduler stopping while there are active commands");
         break;
       }
 
-      // copy new commands to pending list
-      std::copy(s_cmds.begin(),s_cmds.end(),std::back_inserter(command_queue));
-      s_cmds.clear();
-    } // lk scope
-
-    // iterate commands
-    auto end = command_queue.end();
-    auto nitr = command_queue.begin();
-    for (auto itr=nitr; itr!=end; itr=nitr) {
-      auto slot = &(*itr);
-
-      if ((slot->header_value & 0xF) == 0x1) { // new
-        auto opc = opcode(slot->header_value);
-        if (opc!=CMD_START_KERNEL) { // Non performance critical command
-          process_special_command(slot,opc);
-          continue;
-        }
-
-        // Extract and cache cumask from cmd
-        size_type cumasks = cu_masks(slot->header_value);
-        for (size_type i=0; i<cumasks; ++i) {
-          auto& payload = slot->get_packet();
-          bitmask_type mask(payload[1+i]);
-          slot->cus |= (mask<<sizeof(value_type)*8*i);
-        }
-
-        slot->header_value = (slot->header_value & ~0xF) | 0x2; // queued
-        XRT_DEBUGF("slot(%d) [new->queued]\n",slot->get_uid());
-      }
+      // move new commands to ready queues
+      progress = m_submitted.consume([this](const command_type& cmd){queue_command(cmd);}) > 0;
 
-      if ((slot->header_value & 0xF) == 0x2) { // queued
-        // queued command, start if any of cus is ready
-        if (start_cu(slot)) { // started
-          slot->header_value |= 0x1; // running (0x2->0x3)
-          XRT_DEBUGF("slot(%d) [queued->running]\n",slot->get_uid());
-        }
-      }
+      auto zero = xrt::time_ns();
 
-      if ((slot->header_value & 0xF) == 0x3) { // running
-        // running command, check its cu status
-        if (check_cu(slot,false)) {
-          notify_host(slot);
-          slot->header_value = (slot->header_value & ~0xF) | 0x4; // free
-          XRT_DEBUGF("slot(%d) [running->free]\n",slot->get_uid());
-        }
+      while (!special_queue.empty()) {
+        auto slot = special_queue.front();
+        if (!process_special_command(slot,opcode(slot->header_value)))
+          break;
+        special_queue.pop_front();
+        progress = true;
       }
 
-      if ((slot->header_value & 0xF) == 0x4) { // free
-        nitr = command_queue.erase(itr);
-        end = command_queue.end();
-        continue;
+      progress = start_cus() || progress;
+      progress = check_cus() || progress;
+
+      if (!progress) {
+        ++m_polls;
+        m_poll_ns += xrt::time_ns() - zero;
       }
+    } // while
+  }
 
-      nitr = ++itr;
+public:
+  explicit
+  device_scheduler(xrt::device* device)
+    : m_device(device)
+  {}
+
+  ~device_scheduler()
+  {
+    stop();
+  }
+
+  /**
+   * (Re)initialize scheduler configuration for this device
+   *
+   * Called when a program is loaded, in which case there
+   * are no commands scheduled on the device.  The scheduler
+   * thread is stopped while the configuration changes and is
+   * started again after, so the thread reads the configuration
+   * without locking.
+   */
+  void
+  init(size_t cus, size_t cuoffset, size_t cubase, const std::vector<uint32_t>& cu_amap)
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    stop();
+    num_cus = cus;
+    cu_base_address = cubase;
+    cu_offset = cuoffset;
+    cu_trace_enabled = xrt::config::get_profile();
+    cu_addr_map = cu_amap;
+    cu_valid.reset();
+    for (size_type i=0; i<num_cus; ++i)
+      cu_valid.set(i);
+    m_interrupt = xrt::config::get_sws_interrupt();
+    m_max_backoff_us = xrt::config::get_sws_max_backoff();
+    start();
+  }
 
+  void
+  schedule(const command_type& cmd)
+  {
+    m_submitted.push(cmd);
+  }
+
+  void
+  start()
+  {
+    m_stop = false;
+    m_thread = xrt::thread(&device_scheduler::scheduler_loop,this);
+  }
+
+  void
+  stop()
+  {
+    if (!m_thread.joinable())
+      return;
+
+    m_stop = true;
+    m_submitted.wake();
+    m_thread.join();
+
+    if (m_idle_waits) {
+      XRT_DEBUG(std::cout,"sws: polls(",m_polls,") idle waits(",m_idle_waits,") polls avoided(",m_polls_avoided,")\n");
+      if (xrt::config::get_xrt_debug())
+        xrt::message::send(xrt::message::severity_level::INFO,
+                           "sws polls avoided on device '" + m_device->getName() + "': "
+                           + std::to_string(m_polls_avoided)
+                           + " (" + std::to_string(m_idle_waits) + " idle waits, "
+                           + std::to_string(m_polls) + " polls)");
     }
-  } // while
-}
+  }
+};
 
+////////////////////////////////////////////////////////////////
+// Device schedulers are created during init and live until
+// the sws scheduler is stopped.
+////////////////////////////////////////////////////////////////
+static std::mutex s_mutex;
 static bool s_running=false;
-static std::thread s_scheduler;
+static std::map<const xrt::device*, std::unique_ptr<device_scheduler>> s_device_schedulers;
 
+// Schedulers published for lock-free lookup on the submit path.  An
+// entry's scheduler is stored before its device, so a reader that
+// finds the device also sees the scheduler.
+const size_type max_devices = 64;
+struct published_scheduler
+{
+  std::atomic<const xrt::device*> device {nullptr};
+  std::atomic<device_scheduler*> scheduler {nullptr};
+};
+static std::array<published_scheduler,max_devices> s_published;
+
+static void
+publish(const xrt::device* device, device_scheduler* ds)
+{
+  for (auto& entry : s_published) {
+    if (entry.device.load(std::memory_order_relaxed))
+      continue;
+    entry.scheduler.store(ds,std::memory_order_relaxed);
+    entry.device.store(device,std::memory_order_release);
+    return;
+  }
+  throw std::runtime_error("sws command scheduler supports at most "
+                           + std::to_string(max_devices) + " devices");
+}
+
+static void
+unpublish_all()
+{
+  for (auto& entry : s_published) {
+    entry.device.store(nullptr,std::memory_order_relaxed);
+    entry.scheduler.store(nullptr,std::memory_order_relaxed);
+  }
+}
+
+/**
+ * Get the scheduler for a device
+ *
+ * The scheduler is guaranteed to have been created in init.  The
+ * lookup takes no lock, schedulers are published when created and
+ * only removed when the sws scheduler is stopped.
+ */
+static device_scheduler*
+get_device_scheduler(const xrt::device* device)
+{
+  for (auto& entry : s_published) {
+    auto d = entry.device.load(std::memory_order_acquire);
+    if (d == device)
+      return entry.scheduler.load(std::memory_order_relaxed);
+    if (!d)
+      break;
+  }
+  throw std::runtime_error("sws command scheduler not initialized for device");
+}
 
 } // namespace
 
@@ -544,9 +954,7 @@ namespace xrt { namespace sws {
 void
 schedule(const command_type& cmd)
 {
-  std::lock_guard<std::mutex> lk(s_mutex);
-  s_cmds.push_back(cmd);
-  s_work.notify_one();
+  get_device_scheduler(cmd->get_device())->schedule(cmd);
 }
 
 void
@@ -556,7 +964,6 @@ start()
     throw std::runtime_error("sws command scheduler is already started");
 
   std::lock_guard<std::mutex> lk(s_mutex);
-  s_scheduler = std::move(xrt::thread(scheduler_loop));
   if (threaded_notification)
     notifier = std::move(xrt::thread(xrt::task::worker,std::ref(notify_queue)));
   s_running = true;
@@ -570,12 +977,12 @@ stop()
 
   {
     std::lock_guard<std::mutex> lk(s_mutex);
-    s_stop=true;
+    unpublish_all();
+    for (auto& e : s_device_schedulers)
+      e.second->stop();
+    s_device_schedulers.clear();
   }
 
-  s_work.notify_one();
-  s_scheduler.join();
-
   if (threaded_notification) {
     // wait for notifier to drain
     while (notify_queue.size()) {
@@ -590,13 +997,21 @@ stop()
 }
 
 void
-init(xrt::device*, size_t, size_t cus, size_t cuoffset, size_t cubase, const std::vector<uint32_t>& cu_amap)
+init(xrt::device* device, size_t, size_t cus, size_t cuoffset, size_t cubase, const std::vector<uint32_t>& cu_amap)
 {
-  num_cus = cus;
-  cu_base_address = cubase;
-  cu_offset = cuoffset;
-  cu_trace_enabled = xrt::config::get_profile();
-  cu_addr_map = cu_amap;
+  // create a scheduler and scheduler thread for this device if necessary
+  std::lock_guard<std::mutex> lk(s_mutex);
+  auto itr = s_device_schedulers.find(device);
+  if (itr==s_device_schedulers.end()) {
+    XRT_DEBUG(std::cout,"creating sws scheduler for device '",device->getName(),"'\n");
+    auto ds = xrt::make_unique<device_scheduler>(device);
+    ds->init(cus,cuoffset,cubase,cu_amap);
+    publish(device,ds.get());
+    s_device_schedulers.emplace(device,std::move(ds));
+    return;
+  }
+
+  (*itr).second->init(cus,cuoffset,cubase,cu_amap);
 }
 
 }} // sws,xrt
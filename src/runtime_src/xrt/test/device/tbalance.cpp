@@ -0,0 +1,116 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "../test_helpers.h"
+
+#include "xrt/device/device.h"
+#include "xocl/core/memidx_usage.h"
+#include "driver/include/xclhal2.h"
+#include <vector>
+
+// Placement of buffers without explicit bank over the banks connected
+// to all CUs, checked against the null driver usage counters
+//
+//  % XCL_NULL_DEVICE=1 xrttest --run_test=test_balance
+
+using namespace xrt::test;
+
+namespace {
+
+using memory_domain = xrt::device::memoryDomain;
+
+static xclDeviceUsage
+usage_info(xrt::device* mydev)
+{
+  xclDeviceUsage info;
+  auto ret = mydev->getUsageInfo(&info);
+  BOOST_CHECK(ret.valid());
+  BOOST_CHECK_EQUAL(ret.get(),0);
+  return info;
+}
+
+// Allocate a buffer in the least used bank as xocl::device does for
+// buffers without explicit bank
+static xrt::device::BufferObjectHandle
+alloc_balanced(xrt::device* mydev, xocl::memidx_usage* usage,
+               const xocl::memidx_usage::memidx_bitmask_type& mask, size_t sz)
+{
+  auto memidx = usage->least_used(mask);
+  BOOST_CHECK(memidx >= 0);
+  auto boh = mydev->alloc(sz,memory_domain::XRT_DEVICE_RAM,memidx,nullptr);
+  return usage->account(std::move(boh),memidx,sz);
+}
+
+static void
+run(xrt::device* mydev)
+{
+  const size_t sz = 0x100000;
+  const size_t banks = 4;
+  xocl::memidx_usage::memidx_bitmask_type mask;
+  for (size_t bank=0; bank<banks; ++bank)
+    mask.set(bank);
+
+  auto usage = std::make_shared<xocl::memidx_usage>();
+  std::vector<xrt::device::BufferObjectHandle> bos;
+  for (size_t i=0; i<2*banks; ++i)
+    bos.emplace_back(alloc_balanced(mydev,usage.get(),mask,sz));
+
+  // two buffers in each bank
+  auto info = usage_info(mydev);
+  for (size_t bank=0; bank<banks; ++bank) {
+    BOOST_CHECK_EQUAL(usage->bytes(bank),2*sz);
+    BOOST_CHECK_EQUAL(info.ddrMemUsed[bank],2*sz);
+    BOOST_CHECK_EQUAL(info.ddrBOAllocated[bank],2);
+  }
+  BOOST_CHECK_EQUAL(info.ddrBOAllocated[banks],0);
+
+  // a bank freed up is used first
+  bos[2] = nullptr;
+  BOOST_CHECK_EQUAL(usage->bytes(2),sz);
+  BOOST_CHECK_EQUAL(usage_info(mydev).ddrBOAllocated[2],1);
+  bos[2] = alloc_balanced(mydev,usage.get(),mask,sz);
+  BOOST_CHECK_EQUAL(usage->bytes(2),2*sz);
+  BOOST_CHECK_EQUAL(usage_info(mydev).ddrBOAllocated[2],2);
+
+  bos.clear();
+  info = usage_info(mydev);
+  for (size_t bank=0; bank<banks; ++bank) {
+    BOOST_CHECK_EQUAL(usage->bytes(bank),0);
+    BOOST_CHECK_EQUAL(info.ddrMemUsed[bank],0);
+    BOOST_CHECK_EQUAL(info.ddrBOAllocated[bank],0);
+  }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_balance )
+
+BOOST_AUTO_TEST_CASE( balance1 )
+{
+  auto pred = [](const xrt::hal::device& hal) {
+    return (hal.getDriverLibraryName().find("xrt_null")!=std::string::npos);
+  };
+  auto devices = xrt::test::loadDevices(std::move(pred));
+
+  for (auto& device : devices) {
+    device.open();
+    run(&device);
+    device.close();
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
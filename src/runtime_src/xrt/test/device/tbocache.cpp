@@ -0,0 +1,182 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "../test_helpers.h"
+
+#include "xrt/device/device.h"
+#include <cstdlib>
+#include <vector>
+
+// Buffer object cache on the null device driver
+//
+//  % XCL_NULL_DEVICE=1 xrttest --run_test=test_bo_cache
+
+using namespace xrt::test;
+
+namespace {
+
+static void
+hits(xrt::device* mydev)
+{
+  mydev->setBOCacheSize(0x100000);
+  auto start = mydev->getBOCacheStats();
+
+  auto bo = mydev->alloc(4096);
+  auto addr = mydev->getDeviceAddr(bo);
+  bo = nullptr;
+  auto stats = mydev->getBOCacheStats();
+  BOOST_CHECK_EQUAL(stats.misses,start.misses+1);
+  BOOST_CHECK_EQUAL(stats.cached_bos,1);
+  BOOST_CHECK_EQUAL(stats.cached_bytes,4096);
+
+  // same size class, the released buffer object is reused
+  bo = mydev->alloc(100);
+  BOOST_CHECK_EQUAL(mydev->getDeviceAddr(bo),addr);
+  stats = mydev->getBOCacheStats();
+  BOOST_CHECK_EQUAL(stats.hits,start.hits+1);
+  BOOST_CHECK_EQUAL(stats.cached_bos,0);
+
+  // next size class is a miss
+  auto bo2 = mydev->alloc(4097);
+  BOOST_CHECK(mydev->getDeviceAddr(bo2)!=addr);
+  stats = mydev->getBOCacheStats();
+  BOOST_CHECK_EQUAL(stats.misses,start.misses+2);
+
+  bo = nullptr;
+  bo2 = nullptr;
+  stats = mydev->getBOCacheStats();
+  BOOST_CHECK_EQUAL(stats.cached_bos,2);
+  BOOST_CHECK_EQUAL(stats.cached_bytes,4096+8192);
+
+  mydev->setBOCacheSize(0);
+  stats = mydev->getBOCacheStats();
+  BOOST_CHECK_EQUAL(stats.cached_bos,0);
+  BOOST_CHECK_EQUAL(stats.cached_bytes,0);
+}
+
+static void
+cap(xrt::device* mydev)
+{
+  const size_t max_bytes = 16*4096;
+  mydev->setBOCacheSize(max_bytes);
+
+  std::vector<xrt::device::BufferObjectHandle> bos;
+  for (int i=0; i<20; ++i)
+    bos.emplace_back(mydev->alloc(4096));
+  bos.clear();
+
+  // buffer objects released beyond the limit are freed
+  auto stats = mydev->getBOCacheStats();
+  BOOST_CHECK_EQUAL(stats.cached_bytes,max_bytes);
+  BOOST_CHECK_EQUAL(stats.cached_bos,16);
+
+  mydev->setBOCacheSize(0);
+}
+
+static void
+freed(xrt::device* mydev)
+{
+  mydev->setBOCacheSize(0x100000);
+
+  // explicitly freed buffer object is not returned to the cache
+  auto bo = mydev->alloc(4096);
+  mydev->free(bo);
+  bo = nullptr;
+  auto stats = mydev->getBOCacheStats();
+  BOOST_CHECK_EQUAL(stats.cached_bos,0);
+  BOOST_CHECK_EQUAL(stats.cached_bytes,0);
+
+  mydev->setBOCacheSize(0);
+}
+
+static void
+closed(xrt::device* mydev)
+{
+  mydev->setBOCacheSize(0x100000);
+
+  // buffer object released after close is not cached
+  auto bo = mydev->alloc(4096);
+  mydev->close();
+  bo = nullptr;
+  auto stats = mydev->getBOCacheStats();
+  BOOST_CHECK_EQUAL(stats.cached_bos,0);
+  BOOST_CHECK_EQUAL(stats.cached_bytes,0);
+
+  mydev->setBOCacheSize(0);
+}
+
+static void
+retry(xrt::device* mydev)
+{
+  // device of 1MB, see XCL_NULL_MEM_MB
+  mydev->setBOCacheSize(0x400000);
+
+  auto bo1 = mydev->alloc(0x80000);
+  auto bo2 = mydev->alloc(0x80000);
+  bo1 = nullptr;
+  bo2 = nullptr;
+  auto stats = mydev->getBOCacheStats();
+  BOOST_CHECK_EQUAL(stats.cached_bytes,0x100000);
+
+  // the cache holds all device memory, it is released for a miss
+  auto bo = mydev->alloc(0xc0000);
+  BOOST_CHECK(bo);
+  stats = mydev->getBOCacheStats();
+  BOOST_CHECK_EQUAL(stats.cached_bos,0);
+  BOOST_CHECK_EQUAL(stats.cached_bytes,0);
+
+  bo = nullptr;
+  mydev->setBOCacheSize(0);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_bo_cache )
+
+BOOST_AUTO_TEST_CASE( bo_cache1 )
+{
+  auto pred = [](const xrt::hal::device& hal) {
+    return (hal.getDriverLibraryName().find("xrt_null")!=std::string::npos);
+  };
+  auto devices = xrt::test::loadDevices(std::move(pred));
+
+  for (auto& device : devices) {
+    device.open();
+    hits(&device);
+    cap(&device);
+    freed(&device);
+    closed(&device);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( bo_cache_retry )
+{
+  auto pred = [](const xrt::hal::device& hal) {
+    return (hal.getDriverLibraryName().find("xrt_null")!=std::string::npos);
+  };
+  auto devices = xrt::test::loadDevices(std::move(pred));
+
+  setenv("XCL_NULL_MEM_MB","1",1);
+  for (auto& device : devices) {
+    device.open();
+    retry(&device);
+    device.close();
+  }
+  unsetenv("XCL_NULL_MEM_MB");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,143 @@
+/**
+ * Copyright (C) 2016-2017 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "../test_helpers.h"
+
+#include "xrt/device/device.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+using namespace xrt::test;
+
+namespace {
+
+using direction = xrt::device::direction;
+
+// Buffer to buffer copy through host, as done by xocl prior to using
+// device side copy: sync src from device, memcpy, sync dst to device
+static void
+host_copy(xrt::device* device, const xrt::device::BufferObjectHandle& dst,
+          const xrt::device::BufferObjectHandle& src, size_t size)
+{
+  device->sync(src,size,0,direction::DEVICE2HOST,false).wait();
+  auto hsrc = device->map(src);
+  auto hdst = device->map(dst);
+  std::memcpy(hdst,hsrc,size);
+  device->unmap(src);
+  device->unmap(dst);
+  device->sync(dst,size,0,direction::HOST2DEVICE,false).wait();
+}
+
+static void
+device_copy(xrt::device* device, const xrt::device::BufferObjectHandle& dst,
+            const xrt::device::BufferObjectHandle& src, size_t size)
+{
+  if (device->copy(dst,src,size,0,0).get<int>())
+    throw std::runtime_error("device copy failed");
+}
+
+static int
+copyVerifyTest(xrt::device* device, size_t size)
+{
+  std::vector<char> wbuf(size), rbuf(size,0);
+  for (size_t i=0; i<size; ++i)
+    wbuf[i] = static_cast<char>(i*7);
+
+  auto src = device->alloc(size);
+  auto dst = device->alloc(size);
+  device->write(src,wbuf.data(),size,0).wait();
+  device->sync(src,size,0,direction::HOST2DEVICE,false).wait();
+
+  device_copy(device,dst,src,size);
+
+  device->sync(dst,size,0,direction::DEVICE2HOST,false).wait();
+  device->read(dst,rbuf.data(),size,0).wait();
+
+  if (!std::equal(wbuf.begin(),wbuf.end(),rbuf.begin())) {
+    std::cout << size << " B copy verification failed\n";
+    return 1;
+  }
+  return 0;
+}
+
+static void
+copyBenchmarkTest(xrt::device* device, size_t size, size_t count)
+{
+  auto src = device->alloc(size);
+  auto dst = device->alloc(size);
+  device->sync(src,size,0,direction::HOST2DEVICE,false).wait();
+
+  Timer myclock;
+  for (size_t i=0; i<count; ++i)
+    host_copy(device,dst,src,size);
+  double host_time = myclock.stop();
+
+  myclock.reset();
+  for (size_t i=0; i<count; ++i)
+    device_copy(device,dst,src,size);
+  double device_time = myclock.stop();
+
+  double mb = static_cast<double>(size)*count/1024000;
+  std::cout << "Size " << size/1024 << " KB"
+            << " host copy = " << mb/host_time << " MB/s"
+            << " device copy = " << mb/device_time << " MB/s\n";
+}
+
+void
+run(xrt::device* device)
+{
+  std::cout << device->getDriverLibraryName() << "\n";
+
+  device->open();
+  device->setup();
+
+  try {
+    for (size_t size=4096; size<=0x4000000; size<<=2)
+      if (copyVerifyTest(device,size) != 0) {
+        std::cout << "FAILED TEST\n";
+        BOOST_CHECK_EQUAL(true,false);
+        return;
+      }
+
+    // 4 KB to 64 MB, roughly 256 MB moved per size
+    for (size_t size=4096; size<=0x4000000; size<<=2)
+      copyBenchmarkTest(device,size,std::max<size_t>(1,0x10000000/size));
+  }
+  catch (const std::exception& ex) {
+    std::cout << ex.what() << std::endl;
+  }
+}
+
+}
+
+// invoke with --run_test=test_copy_bw
+BOOST_AUTO_TEST_SUITE ( test_copy_bw )
+
+BOOST_AUTO_TEST_CASE ( test_copy_bw1 )
+{
+  auto pred = [](const xrt::hal::device& hal) {
+    return hal.hasCopyBO();
+  };
+  auto devices = xrt::test::loadDevices(std::move(pred));
+
+  for (auto& device : devices) {
+    run(&device);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,240 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "../test_helpers.h"
+
+#include "xrt/device/device.h"
+#include "xrt/scheduler/command.h"
+#include "xrt/scheduler/scheduler.h"
+#include "xrt/util/config_reader.h"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Runtime overhead benchmarks on the null device driver
+//
+//  % XCL_NULL_DEVICE=1 XCL_NULL_CU_LATENCY_US=10 xrttest --run_test=test_null_bench
+//
+// Set Runtime.bo_cache_size in sdaccel.ini to measure bo create/release
+// with the buffer object cache, bo alloc/free always compares without
+// and with the cache.
+//
+// The null device keeps buffers in host memory and models CU execution
+// and DMA, so the numbers below are what the host runtime itself costs.
+
+using namespace xrt::test;
+
+namespace {
+
+using direction = xrt::device::direction;
+using clock_type = std::chrono::high_resolution_clock;
+
+const size_t bo_count = 10000;
+const size_t enqueue_count = 10000;
+const size_t launch_count = 1000;
+const uint32_t cu_base_addr = 0x1800000;
+
+static double
+cu_latency_us()
+{
+  auto str = std::getenv("XCL_NULL_CU_LATENCY_US");
+  return str ? std::strtod(str,nullptr) : 0.0;
+}
+
+static double
+to_us(clock_type::duration d)
+{
+  return std::chrono::duration_cast<std::chrono::duration<double,std::micro>>(d).count();
+}
+
+// Start kernel command recording when its completion call back runs
+struct timed_command : xrt::command
+{
+  timed_command(xrt::device* device)
+    : xrt::command(device,ERT_START_CU)
+  {
+    auto& packet = get_packet();
+    packet[1] = 0x1;  // cu mask
+    packet[5] = 0;    // regmap 2..5
+    auto epacket = xrt::command_cast<ert_packet*>(this);
+    epacket->count = packet.size() - 1;
+  }
+
+  virtual void done() const
+  {
+    m_done_time = clock_type::now();
+  }
+
+  mutable clock_type::time_point m_done_time;
+};
+
+static void
+boBenchmark(xrt::device* device, size_t size)
+{
+  std::vector<xrt::device::BufferObjectHandle> bos;
+  bos.reserve(bo_count);
+
+  Timer myclock;
+  for (size_t i=0; i<bo_count; ++i)
+    bos.emplace_back(device->alloc(size));
+  bos.clear();
+  double time = myclock.stop();
+
+  std::cout << "bo create/release " << size/1024 << " KB: "
+            << bo_count/time << " per second\n";
+
+  // Runtime.bo_cache_size enables the buffer object cache
+  auto stats = device->getBOCacheStats();
+  if (stats.hits || stats.misses)
+    std::cout << "bo cache hits " << stats.hits << " misses " << stats.misses
+              << " cached " << stats.cached_bos << " (" << stats.cached_bytes/1024 << " KB)\n";
+}
+
+// Each buffer object is released before the next is allocated, as when
+// a kernel argument is allocated per enqueue, so the cache is hit.
+static void
+boReuseBenchmark(xrt::device* device, size_t size)
+{
+  for (size_t cache_size : {size_t(0), size_t(64) << 20}) {
+    device->setBOCacheSize(cache_size);
+    auto start = device->getBOCacheStats();
+
+    Timer myclock;
+    for (size_t i=0; i<bo_count; ++i)
+      device->alloc(size);
+    double time = myclock.stop();
+
+    auto stats = device->getBOCacheStats();
+    std::cout << "bo alloc/free " << size/1024 << " KB, cache "
+              << (cache_size >> 20) << " MB: " << bo_count/time << " per second";
+    if (cache_size)
+      std::cout << ", hits " << stats.hits - start.hits
+                << " misses " << stats.misses - start.misses;
+    std::cout << "\n";
+  }
+  device->setBOCacheSize(static_cast<size_t>(xrt::config::get_bo_cache_size()) << 20);
+}
+
+static void
+enqueueBenchmark(xrt::device* device)
+{
+  const size_t size = 4096;
+  auto bo = device->alloc(size);
+  std::vector<char> buf(size);
+  std::vector<xrt::event> events;
+  events.reserve(enqueue_count*2);
+
+  Timer myclock;
+  for (size_t i=0; i<enqueue_count; ++i) {
+    events.emplace_back(device->write(bo,buf.data(),size,0,true/*async*/));
+    events.emplace_back(device->sync(bo,size,0,direction::HOST2DEVICE,true/*async*/));
+  }
+  double enqueue_time = myclock.stop();
+  for (auto& event : events)
+    event.wait();
+  double total_time = myclock.stop();
+
+  std::cout << "enqueue: " << events.size()/enqueue_time << " tasks per second"
+            << ", completed " << events.size()/total_time << " tasks per second\n";
+}
+
+// Launch latency is the time from scheduling a command to its completion
+// call back, less the modelled CU execution time.  Callback latency is the
+// time from the completion call back until a thread blocked on the command
+// wakes up.
+static void
+launchBenchmark(xrt::device* device)
+{
+  double cu_us = cu_latency_us();
+  double launch_us = 0, callback_us = 0;
+
+  for (size_t i=0; i<launch_count; ++i) {
+    auto cmd = xrt::make_command<timed_command>(device);
+    auto start = clock_type::now();
+    xrt::scheduler::schedule(cmd);
+    cmd->wait();
+    auto woken = clock_type::now();
+    launch_us += to_us(cmd->m_done_time - start) - cu_us;
+    callback_us += to_us(woken - cmd->m_done_time);
+  }
+
+  std::cout << "kernel launch latency: " << launch_us/launch_count << " us"
+            << " (cu latency " << cu_us << " us excluded)\n"
+            << "event callback latency: " << callback_us/launch_count << " us\n";
+
+  // Throughput with all commands in flight
+  std::vector<xrt::command_type> cmds;
+  cmds.reserve(launch_count);
+  Timer myclock;
+  for (size_t i=0; i<launch_count; ++i) {
+    cmds.emplace_back(xrt::make_command<timed_command>(device));
+    xrt::scheduler::schedule(cmds.back());
+  }
+  for (auto& cmd : cmds)
+    cmd->wait();
+  double time = myclock.stop();
+
+  std::cout << "kernel launch rate: " << launch_count/time << " per second\n";
+}
+
+void
+run(xrt::device* device)
+{
+  std::cout << device->getDriverLibraryName() << "\n";
+
+  device->open();
+  device->setup();
+
+  try {
+    boBenchmark(device,4096);
+    boBenchmark(device,0x100000);
+    boReuseBenchmark(device,4096);
+    boReuseBenchmark(device,0x100000);
+    enqueueBenchmark(device);
+
+    xrt::scheduler::start();
+    xrt::scheduler::init(device,4096,false,1,16,cu_base_addr,{cu_base_addr});
+    launchBenchmark(device);
+    xrt::scheduler::stop();
+  }
+  catch (const std::exception& ex) {
+    std::cout << ex.what() << std::endl;
+    BOOST_CHECK_EQUAL(true,false);
+  }
+
+  device->close();
+}
+
+}
+
+// invoke with --run_test=test_null_bench
+BOOST_AUTO_TEST_SUITE ( test_null_bench )
+
+BOOST_AUTO_TEST_CASE ( test_null_bench1 )
+{
+  auto pred = [](const xrt::hal::device& hal) {
+    return (hal.getDriverLibraryName().find("xrt_null")!=std::string::npos);
+  };
+  auto devices = xrt::test::loadDevices(std::move(pred));
+
+  for (auto& device : devices) {
+    run(&device);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,124 @@
+/**
+ * Copyright (C) 2016-2017 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "../test_helpers.h"
+
+#include "xrt/device/device.h"
+#include <vector>
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+using namespace xrt::test;
+
+namespace {
+
+// 2D region of 'height' rows of 'width' bytes at (x,y) of a frame
+// with 'pitch' bytes per row, transferred from/to a packed host buffer
+static xrt::device::rect_region
+frame_region(size_t x, size_t y, size_t width, size_t height, size_t pitch)
+{
+  xrt::device::rect_region r;
+  r.bo_offset = y*pitch + x;
+  r.bo_row_pitch = pitch;
+  r.bo_slice_pitch = pitch*height;
+  r.host_row_pitch = width;
+  r.host_slice_pitch = width*height;
+  r.width = width;
+  r.height = height;
+  r.depth = 1;
+  return r;
+}
+
+static void
+run(xrt::device* mydev)
+{
+  const size_t pitch = 4096, rows = 256;
+  const size_t size = pitch*rows;
+  auto bo = mydev->alloc(size);
+
+  // Device frame is all 0x11, region is written with 0x22.  The host
+  // side of the buffer is then set to 0x33 without sync, bytes between
+  // rows of the region must not be transferred to the device.
+  std::vector<char> frame(size,0x11);
+  mydev->write(bo,frame.data(),size,0).wait();
+  mydev->sync(bo,size,0,xrt::device::direction::HOST2DEVICE,false).wait();
+  std::fill(frame.begin(),frame.end(),0x33);
+  mydev->write(bo,frame.data(),size,0).wait();
+
+  auto r = frame_region(64,16,1024,128,pitch);
+  BOOST_CHECK_EQUAL(r.bo_contiguous(),false);
+  BOOST_CHECK_EQUAL(r.bo_extent(),127*pitch+1024);
+
+  std::vector<char> roi(r.width*r.height,0x22);
+  mydev->write_rect(bo,roi.data(),r).wait();
+  mydev->sync_rect(bo,r,xrt::device::direction::HOST2DEVICE).wait();
+
+  // Read back entire frame and check region and surrounding bytes
+  std::fill(frame.begin(),frame.end(),0);
+  mydev->sync(bo,size,0,xrt::device::direction::DEVICE2HOST,false).wait();
+  mydev->read(bo,frame.data(),size,0).wait();
+  for (size_t y=0; y<rows; ++y)
+    for (size_t x=0; x<pitch; ++x) {
+      bool inside = (y>=16 && y<16+128 && x>=64 && x<64+1024);
+      if (frame[y*pitch+x] != (inside ? 0x22 : 0x11)) {
+        BOOST_CHECK_MESSAGE(false,"mismatch at row " << y << " column " << x);
+        return;
+      }
+    }
+
+  // Read region back into packed host buffer.  The host side of the
+  // buffer is set to 0x44, bytes outside the region must keep it.
+  std::fill(frame.begin(),frame.end(),0x44);
+  mydev->write(bo,frame.data(),size,0).wait();
+  std::fill(roi.begin(),roi.end(),0);
+  mydev->sync_rect(bo,r,xrt::device::direction::DEVICE2HOST).wait();
+  mydev->read_rect(bo,roi.data(),r).wait();
+  BOOST_CHECK(std::all_of(roi.begin(),roi.end(),[](char c){return c==0x22;}));
+  mydev->read(bo,frame.data(),size,0).wait();
+  for (size_t y=0; y<rows; ++y)
+    for (size_t x=0; x<pitch; ++x) {
+      bool inside = (y>=16 && y<16+128 && x>=64 && x<64+1024);
+      if (frame[y*pitch+x] != (inside ? 0x22 : 0x44)) {
+        BOOST_CHECK_MESSAGE(false,"host mismatch at row " << y << " column " << x);
+        return;
+      }
+    }
+
+  mydev->free(bo);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_rect )
+
+BOOST_AUTO_TEST_CASE( rect1 )
+{
+  auto pred = [](const xrt::hal::device& hal) {
+    return (hal.getDriverLibraryName().find("xcldrv")!=std::string::npos);
+  };
+  auto devices = xrt::test::loadDevices(std::move(pred));
+
+  for (auto& device : devices) {
+    device.open();
+    device.setup(); // this creates the worker threads
+    run(&device);
+    device.close();
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
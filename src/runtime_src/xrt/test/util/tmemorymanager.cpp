@@ -0,0 +1,125 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+////////////////////////////////////////////////////////////////
+// Unit testing of driver/common_em/memorymanager.h
+////////////////////////////////////////////////////////////////
+#include <boost/test/unit_test.hpp>
+
+#include "driver/common_em/memorymanager.h"
+#include "xrt/util/time.h"
+
+#include <vector>
+#include <random>
+#include <iostream>
+
+BOOST_AUTO_TEST_SUITE ( test_memorymanager )
+
+using xclemulation::MemoryManager;
+
+// Copy, since mNull is not defined out of class and cannot bind to
+// the references taken by the test macros
+static const uint64_t null_addr = MemoryManager::mNull;
+
+BOOST_AUTO_TEST_CASE( test_memorymanager1 )
+{
+  const uint64_t page = 4096;
+  MemoryManager mm(16*page, 0, page);
+
+  size_t sz = 1;
+  auto a = mm.alloc(sz);
+  BOOST_CHECK_EQUAL(sz,page);  // rounded to alignment
+  BOOST_CHECK_EQUAL(a,0);
+
+  sz = 2*page;
+  auto b = mm.alloc(sz);
+  BOOST_CHECK_EQUAL(b,page);
+  sz = page;
+  auto c = mm.alloc(sz);
+  BOOST_CHECK_EQUAL(c,3*page);
+  BOOST_CHECK_EQUAL(mm.freeSize(),12*page);
+
+  auto l = mm.lookup(b);
+  BOOST_CHECK_EQUAL(l.first,b);
+  BOOST_CHECK_EQUAL(l.second,2*page);
+  BOOST_CHECK(MemoryManager::isNullAlloc(mm.lookup(b+page)));
+
+  // best fit picks the 2 page hole rather than the tail
+  mm.free(b);
+  sz = 2*page;
+  BOOST_CHECK_EQUAL(mm.alloc(sz),b);
+  mm.free(b);
+
+  // immediate coalescing, hole a+b merges into 3 pages
+  mm.free(a);
+  sz = 3*page;
+  BOOST_CHECK_EQUAL(mm.alloc(sz),0);
+  mm.free(0);
+  mm.free(c);
+  BOOST_CHECK_EQUAL(mm.freeSize(),16*page);
+
+  // everything coalesced into a single block
+  sz = 16*page;
+  BOOST_CHECK_EQUAL(mm.alloc(sz),0);
+  sz = page;
+  BOOST_CHECK_EQUAL(mm.alloc(sz),null_addr);
+
+  mm.reset();
+  BOOST_CHECK_EQUAL(mm.freeSize(),16*page);
+}
+
+// 100k alloc/free cycles with random sizes and a random live set.
+// Time per operation should not grow with the number of live blocks.
+BOOST_AUTO_TEST_CASE( test_memorymanager_bw )
+{
+  const uint64_t page = 4096;
+  const unsigned int cycles = 100000;
+
+  for (unsigned int live=64; live<=16384; live*=4) {
+    MemoryManager mm(16ull<<30, 0, page);
+    std::mt19937 gen(live);
+    std::uniform_int_distribution<size_t> size_dist(1,64*page);
+    std::vector<uint64_t> bufs;
+    bufs.reserve(live);
+
+    auto zero = xrt::time_ns();
+    for (unsigned int i=0; i<cycles; ++i) {
+      if (bufs.size() == live) {
+        auto idx = gen() % bufs.size();
+        mm.free(bufs[idx]);
+        bufs[idx] = bufs.back();
+        bufs.pop_back();
+      }
+      size_t sz = size_dist(gen);
+      auto addr = mm.alloc(sz);
+      BOOST_REQUIRE(addr != null_addr);
+      bufs.push_back(addr);
+    }
+    auto ns = xrt::time_ns() - zero;
+
+    for (auto addr : bufs)
+      mm.free(addr);
+    BOOST_CHECK_EQUAL(mm.freeSize(),mm.size());
+    size_t sz = mm.size();
+    BOOST_CHECK_EQUAL(mm.alloc(sz),0);
+
+    std::cout << "live=" << live
+              << " alloc/free cycles/sec=" << static_cast<unsigned long>(cycles*1e9/ns)
+              << "\n";
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
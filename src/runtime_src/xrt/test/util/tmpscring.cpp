@@ -0,0 +1,186 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+////////////////////////////////////////////////////////////////
+// Unit testing of xrt/util/mpscring.h
+////////////////////////////////////////////////////////////////
+#include <boost/test/unit_test.hpp>
+
+#include "xrt/util/mpscring.h"
+#include "xrt/util/time.h"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <atomic>
+#include <iostream>
+
+BOOST_AUTO_TEST_SUITE ( test_mpscring )
+
+namespace {
+
+// Stand-in for xrt::command, the ring carries shared pointers
+struct command
+{
+  unsigned int producer;
+  unsigned int seq;
+  command(unsigned int p, unsigned int s) : producer(p), seq(s) {}
+};
+
+using command_type = std::shared_ptr<command>;
+
+// Consume 'total' commands from ring, check per producer ordering
+static void
+consumer(xrt::mpsc_ring<command_type>& ring, unsigned int producers, unsigned long total, bool& ok)
+{
+  std::vector<unsigned int> next(producers,0);
+  unsigned long count = 0;
+  ok = true;
+  while (count < total) {
+    ring.wait([]{return false;});
+    count += ring.consume
+      ([&](const command_type& cmd) {
+        if (cmd->seq != next[cmd->producer]++)
+          ok = false;
+      });
+  }
+}
+
+// Baseline, mutex protected list with notify per command as in
+// the schedulers prior to the ring
+struct locked_queue
+{
+  std::mutex mutex;
+  std::condition_variable work;
+  std::list<command_type> cmds;
+};
+
+static void
+locked_consumer(locked_queue& queue, unsigned long total)
+{
+  unsigned long count = 0;
+  while (count < total) {
+    std::unique_lock<std::mutex> lk(queue.mutex);
+    while (queue.cmds.empty())
+      queue.work.wait(lk);
+    count += queue.cmds.size();
+    queue.cmds.clear();
+  }
+}
+
+}
+
+BOOST_AUTO_TEST_CASE( test_mpscring1 )
+{
+  xrt::mpsc_ring<int> ring(4);
+  BOOST_CHECK_EQUAL(ring.capacity(),4);
+  BOOST_CHECK_EQUAL(ring.empty(),true);
+
+  for (int i=0; i<4; ++i)
+    BOOST_CHECK_EQUAL(ring.try_push(i),true);
+  BOOST_CHECK_EQUAL(ring.try_push(4),false); // full
+
+  int value = -1;
+  BOOST_CHECK_EQUAL(ring.try_pop(value),true);
+  BOOST_CHECK_EQUAL(value,0);
+  BOOST_CHECK_EQUAL(ring.try_push(4),true);
+
+  std::vector<int> values;
+  BOOST_CHECK_EQUAL(ring.consume([&](int v){values.push_back(v);}),4);
+  BOOST_CHECK_EQUAL(values.size(),4);
+  for (int i=0; i<4; ++i)
+    BOOST_CHECK_EQUAL(values[i],i+1);
+  BOOST_CHECK_EQUAL(ring.empty(),true);
+
+  bool exception = false;
+  try {
+    xrt::mpsc_ring<int> bad(3);
+  }
+  catch (const std::exception&) {
+    exception = true;
+  }
+  BOOST_CHECK_EQUAL(exception,true);
+}
+
+BOOST_AUTO_TEST_CASE( test_mpscring2 )
+{
+  // wake with predicate does not lose wakeup
+  xrt::mpsc_ring<int> ring(16);
+  std::atomic<bool> stop(false);
+  std::thread t([&]{ while (!stop) ring.wait([&]{return stop.load();}); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  stop = true;
+  ring.wake();
+  t.join();
+  BOOST_CHECK_EQUAL(stop.load(),true);
+}
+
+// Commands/sec through the ring versus mutex protected list for
+// 1 to 32 producer threads
+BOOST_AUTO_TEST_CASE( test_mpscring_bw )
+{
+  const unsigned long cmds_per_producer = 100000;
+
+  for (unsigned int producers=1; producers<=32; producers*=2) {
+    auto total = cmds_per_producer * producers;
+
+    // ring
+    xrt::mpsc_ring<command_type> ring(4096);
+    bool ok = false;
+    auto zero = xrt::time_ns();
+    std::thread c(consumer,std::ref(ring),producers,total,std::ref(ok));
+    std::vector<std::thread> threads;
+    for (unsigned int p=0; p<producers; ++p)
+      threads.emplace_back([&ring,p,cmds_per_producer] {
+          for (unsigned int i=0; i<cmds_per_producer; ++i)
+            ring.push(std::make_shared<command>(p,i));
+        });
+    for (auto& t : threads)
+      t.join();
+    c.join();
+    auto ring_ns = xrt::time_ns() - zero;
+    BOOST_CHECK_EQUAL(ok,true);
+
+    // locked list
+    locked_queue queue;
+    zero = xrt::time_ns();
+    std::thread lc(locked_consumer,std::ref(queue),total);
+    threads.clear();
+    for (unsigned int p=0; p<producers; ++p)
+      threads.emplace_back([&queue,p,cmds_per_producer] {
+          for (unsigned int i=0; i<cmds_per_producer; ++i) {
+            auto cmd = std::make_shared<command>(p,i);
+            std::lock_guard<std::mutex> lk(queue.mutex);
+            queue.cmds.push_back(cmd);
+            queue.work.notify_all();
+          }
+        });
+    for (auto& t : threads)
+      t.join();
+    lc.join();
+    auto locked_ns = xrt::time_ns() - zero;
+
+    std::cout << "producers=" << producers
+              << " ring cmds/sec=" << static_cast<unsigned long>(total*1e9/ring_ns)
+              << " locked cmds/sec=" << static_cast<unsigned long>(total*1e9/locked_ns)
+              << "\n";
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
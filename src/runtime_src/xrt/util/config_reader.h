@@ -137,6 +137,20 @@ get_timeline_trace()
   return value;
 }
 
+inline std::string
+get_timeline_trace_format()
+{
+  static std::string value = (!get_timeline_trace()) ? "csv" : detail::get_string_value("Debug.timeline_trace_format","csv");
+  return value;
+}
+
+inline bool
+get_buffered_host_trace()
+{
+  static bool value = get_profile() && detail::get_bool_value("Debug.buffered_host_trace",false);
+  return value;
+}
+
 inline bool
 get_api_checks()
 {
@@ -165,6 +179,33 @@ get_dma_threads()
   return value;
 }
 
+/**
+ * Megabytes of released device buffer objects that a device keeps
+ * mapped for reuse by later allocations.  A value of 0 disables the
+ * buffer object cache.
+ *
+ * With the cache enabled, buffers are allocated rounded up to a size
+ * class, which can use up to 25% more device memory per buffer.
+ */
+inline unsigned int
+get_bo_cache_size()
+{
+  static unsigned int value = detail::get_uint_value("Runtime.bo_cache_size",0);
+  return value;
+}
+
+/**
+ * Spread buffers that have no explicit memory bank over the banks
+ * connected to all CUs, placing each in the bank with the fewest bytes
+ * allocated.  When false all such buffers go to the first common bank.
+ */
+inline bool
+get_balance_banks()
+{
+  static bool value = detail::get_bool_value("Runtime.balance_banks",true);
+  return value;
+}
+
 inline unsigned int
 get_polling_throttle()
 {
@@ -278,6 +319,31 @@ get_ert_slotsize()
   return value;
 }
 
+/**
+ * Software scheduler waits for CU completion interrupt (exec_wait)
+ * rather than polling CU control registers.  If interrupts are not
+ * supported by the device, the scheduler falls back to polling
+ * with exponential backoff.
+ */
+inline bool
+get_sws_interrupt()
+{
+  static bool value = detail::get_bool_value("Runtime.sws_interrupt",false);
+  return value;
+}
+
+/**
+ * Upper bound in microseconds on the software scheduler backoff
+ * between CU status polls when no command made progress.  A value
+ * of 0 restores busy polling.  New commands end the backoff early.
+ */
+inline unsigned int
+get_sws_max_backoff()
+{
+  static unsigned int value = detail::get_uint_value("Runtime.sws_max_backoff",50);
+  return value;
+}
+
 inline std::string
 get_hw_em_driver()
 {
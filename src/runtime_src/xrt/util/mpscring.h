@@ -0,0 +1,260 @@
+/**
+ * Copyright (C) 2018 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef xrt_util_mpscring_h_
+#define xrt_util_mpscring_h_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <stdexcept>
+#include <cstddef>
+
+namespace xrt {
+
+/**
+ * Bounded lock-free multiple producer / single consumer ring
+ *
+ * Producers claim a cell by incrementing the shared head position,
+ * the single consumer owns the tail position.  Each cell carries a
+ * sequence number that tells whether it is free for the producer
+ * of a given lap, or filled for the consumer.
+ *
+ * The consumer can block in wait() when the ring is empty.  Producers
+ * only take the wakeup lock if the consumer is actually sleeping, so
+ * a busy consumer is not woken once per element.
+ *
+ * Capacity must be a power of 2.
+ */
+template <typename T>
+class mpsc_ring
+{
+  static constexpr std::size_t cacheline = 64;
+
+  struct cell
+  {
+    std::atomic<std::size_t> seq;
+    T value;
+  };
+
+  std::unique_ptr<cell[]> m_cells;
+  const std::size_t m_mask;
+
+  // Producer and consumer positions are padded apart to avoid
+  // false sharing.  Padding rather than alignas, since over-aligned
+  // allocation is not supported by operator new before C++17.
+  char m_pad0[cacheline];
+  std::atomic<std::size_t> m_head;
+  char m_pad1[cacheline];
+  std::size_t m_tail;
+  char m_pad2[cacheline];
+
+  // consumer sleep / wakeup
+  std::atomic<bool> m_sleeping;
+  std::mutex m_mutex;
+  std::condition_variable m_work;
+
+  void
+  notify()
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleeping.load(std::memory_order_relaxed) && m_sleeping.exchange(false)) {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      m_work.notify_one();
+    }
+  }
+
+  template <typename U>
+  bool
+  try_push_impl(U&& value)
+  {
+    auto pos = m_head.load(std::memory_order_relaxed);
+    while (1) {
+      auto& c = m_cells[pos & m_mask];
+      auto seq = c.seq.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+      if (diff==0) {
+        if (m_head.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed)) {
+          c.value = std::forward<U>(value);
+          c.seq.store(pos+1,std::memory_order_release);
+          notify();
+          return true;
+        }
+      }
+      else if (diff<0) {
+        return false; // full
+      }
+      else {
+        pos = m_head.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+public:
+  explicit
+  mpsc_ring(std::size_t capacity)
+    : m_cells(new cell[capacity]), m_mask(capacity-1), m_head(0), m_tail(0), m_sleeping(false)
+  {
+    if (!capacity || (capacity & m_mask))
+      throw std::runtime_error("mpsc_ring capacity must be a power of 2");
+    for (std::size_t i=0; i<capacity; ++i)
+      m_cells[i].seq.store(i,std::memory_order_relaxed);
+  }
+
+  std::size_t
+  capacity() const
+  {
+    return m_mask+1;
+  }
+
+  /**
+   * Add an element to the ring, fails if ring is full
+   *
+   * Thread safe, may be called by any number of producers.
+   */
+  bool
+  try_push(const T& value)
+  {
+    return try_push_impl(value);
+  }
+
+  bool
+  try_push(T&& value)
+  {
+    return try_push_impl(std::move(value));
+  }
+
+  /**
+   * Add an element to the ring, yield while ring is full
+   */
+  void
+  push(T value)
+  {
+    while (!try_push_impl(std::move(value)))
+      std::this_thread::yield();
+  }
+
+  /**
+   * Remove an element from the ring
+   *
+   * Must be called by the consumer only.
+   *
+   * @return
+   *   True if an element was removed, false if ring is empty
+   */
+  bool
+  try_pop(T& value)
+  {
+    auto& c = m_cells[m_tail & m_mask];
+    auto seq = c.seq.load(std::memory_order_acquire);
+    if (seq != m_tail+1)
+      return false;
+    value = std::move(c.value);
+    c.value = T();
+    c.seq.store(m_tail+m_mask+1,std::memory_order_release);
+    ++m_tail;
+    return true;
+  }
+
+  /**
+   * Remove all currently available elements
+   *
+   * Must be called by the consumer only.
+   *
+   * @param fn
+   *   Function called with each removed element in order
+   * @return
+   *   Number of elements removed
+   */
+  template <typename Fn>
+  std::size_t
+  consume(Fn fn)
+  {
+    std::size_t count = 0;
+    T value;
+    while (try_pop(value)) {
+      fn(value);
+      ++count;
+    }
+    return count;
+  }
+
+  /**
+   * @return
+   *   True if the consumer would find no element, only meaningful
+   *   when called by the consumer
+   */
+  bool
+  empty() const
+  {
+    auto& c = m_cells[m_tail & m_mask];
+    return c.seq.load(std::memory_order_acquire) != m_tail+1;
+  }
+
+  /**
+   * Consumer waits for an element, or for predicate to become true,
+   * or for timeout
+   *
+   * The predicate is evaluated with the wakeup lock held, so a
+   * condition set by another thread prior to calling wake() is not
+   * missed.  Spurious returns are possible, the consumer must recheck
+   * its conditions.
+   */
+  template <typename Rep, typename Period, typename Predicate>
+  void
+  wait_for(const std::chrono::duration<Rep,Period>& timeout, Predicate pred)
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    m_sleeping.store(true);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (empty() && !pred())
+      m_work.wait_for(lk,timeout,[this,&pred]{return !m_sleeping.load() || pred();});
+    m_sleeping.store(false);
+  }
+
+  template <typename Predicate>
+  void
+  wait(Predicate pred)
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    m_sleeping.store(true);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (empty() && !pred())
+      m_work.wait(lk,[this,&pred]{return !m_sleeping.load() || pred();});
+    m_sleeping.store(false);
+  }
+
+  /**
+   * Wake the consumer if it is waiting
+   *
+   * Use after changing a condition the consumer checks in the
+   * predicate of wait()
+   */
+  void
+  wake()
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_sleeping.store(false);
+    m_work.notify_one();
+  }
+};
+
+} // xrt
+
+#endif
@@ -212,6 +212,27 @@ public:
     std::memset(m_regmap,0,MaxSize*sizeof(WordType));
   }
 
+  /**
+   * Clear only the first words of the regmap.  Use when the
+   * remaining words are known to be zero.
+   */
+  void
+  clear(size_type words)
+  {
+    m_size = 0;
+    std::memset(m_regmap,0,std::min(words,MaxSize)*sizeof(WordType));
+  }
+
+  /**
+   * Replace the regmap content with argument words
+   */
+  void
+  assign(const WordType* words, size_type size)
+  {
+    resize(size);
+    std::memcpy(m_regmap,words,size*sizeof(WordType));
+  }
+
   std::size_t
   bytes() const
   {
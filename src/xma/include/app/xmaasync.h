@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2018, Xilinx Inc - All rights reserved
+ * Xilinx SDAccel Media Accelerator API
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _XMA_APP_ASYNC_H_
+#define _XMA_APP_ASYNC_H_
+
+#include "app/xmabuffers.h"
+#include "app/xmadecoder.h"
+#include "app/xmaencoder.h"
+#include "app/xmascaler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @ingroup xma_app_intf
+ * @file app/xmaasync.h
+ * XMA asynchronous session interface
+*/
+
+/**
+ * @ingroup xma
+ * @addtogroup xmaasync xmaasync.h
+ * @{
+ * @section xmaasync_intro Asynchronous Session Overview
+ *
+ * By default the send and receive functions of a session call the plugin
+ * and return when the plugin does, so at most one frame is in flight per
+ * session.  Once a session is switched to asynchronous mode with one of
+ * the async_enable functions, the _async variants of send and receive only
+ * queue the request and return a completion token.  Two workers per
+ * session then run the queued sends and the queued receives, each in
+ * submission order.  A send for frame n+1 (DMA in, kernel start) thus
+ * overlaps the receive of frame n (kernel completion, DMA out), and the
+ * application keeps up to depth requests per direction outstanding
+ * without any threading of its own.
+ *
+ * @code
+ * XmaAsyncToken send_tok[DEPTH], recv_tok[DEPTH];
+ *
+ * xma_enc_session_async_enable(enc_session, DEPTH);
+ * for (n = 0; n < num_frames; n++)
+ * {
+ *     int32_t slot = n % DEPTH;
+ *
+ *     if (n >= DEPTH)
+ *     {
+ *         // Reuse the frame and buffer of the request DEPTH frames ago
+ *         xma_async_wait(&send_tok[slot]);
+ *         if (xma_async_wait(&recv_tok[slot]) == XMA_SUCCESS)
+ *             write_output(data[slot], data_size[slot]);
+ *     }
+ *     read_input(frame[slot]);
+ *     xma_enc_session_send_frame_async(enc_session, frame[slot],
+ *                                      &send_tok[slot]);
+ *     xma_enc_session_recv_data_async(enc_session, data[slot],
+ *                                     &data_size[slot], &recv_tok[slot]);
+ * }
+ * @endcode
+ *
+ * Frames, buffers, output arguments and tokens passed to an _async
+ * function must stay valid until the token completes.  The plugin's send
+ * and receive callbacks are called from different threads, but never two
+ * sends or two receives at the same time.  Destroying the session waits
+ * for all queued requests first.
+*/
+
+/**
+ * @struct XmaAsyncToken
+ * Completion token of an asynchronous session request
+*/
+typedef struct XmaAsyncToken
+{
+    void           *queue; /**< private, queue running the request */
+    volatile bool   done; /**< true once the request has completed */
+    int32_t         rc; /**< plugin return code, valid once done */
+} XmaAsyncToken;
+
+/**
+ * Switch an encoder session to asynchronous mode
+ *
+ * @param session  Encoder session
+ * @param depth    Maximum requests queued per direction (1-64)
+ *
+ * @return XMA_SUCCESS on success
+ * @return XMA_ERROR_INVALID if depth is out of range or the session is
+ *  already asynchronous
+ * @return XMA_ERROR on failure
+*/
+int32_t
+xma_enc_session_async_enable(XmaEncoderSession *session, int32_t depth);
+
+/**
+ * Queue xma_enc_session_send_frame()
+ *
+ * Blocks only while depth sends are already queued.
+ *
+ * @param session  Encoder session in asynchronous mode
+ * @param frame    Frame to encode
+ * @param token    Completion token, may be NULL if the result is not needed
+ *
+ * @return XMA_SUCCESS if the request was queued
+ * @return XMA_ERROR if the session is not asynchronous
+*/
+int32_t
+xma_enc_session_send_frame_async(XmaEncoderSession *session,
+                                 XmaFrame          *frame,
+                                 XmaAsyncToken     *token);
+
+/**
+ * Queue xma_enc_session_recv_data()
+ *
+ * @param session    Encoder session in asynchronous mode
+ * @param data       Buffer receiving encoded data
+ * @param data_size  Receives the size of the encoded data
+ * @param token      Completion token
+ *
+ * @return XMA_SUCCESS if the request was queued
+ * @return XMA_ERROR if the session is not asynchronous
+*/
+int32_t
+xma_enc_session_recv_data_async(XmaEncoderSession *session,
+                                XmaDataBuffer     *data,
+                                int32_t           *data_size,
+                                XmaAsyncToken     *token);
+
+/**
+ * Switch a decoder session to asynchronous mode
+ *
+ * @see xma_enc_session_async_enable()
+*/
+int32_t
+xma_dec_session_async_enable(XmaDecoderSession *session, int32_t depth);
+
+/**
+ * Queue xma_dec_session_send_data()
+ *
+ * @see xma_enc_session_send_frame_async()
+*/
+int32_t
+xma_dec_session_send_data_async(XmaDecoderSession *session,
+                                XmaDataBuffer     *data,
+                                int32_t           *data_used,
+                                XmaAsyncToken     *token);
+
+/**
+ * Queue xma_dec_session_recv_frame()
+ *
+ * @see xma_enc_session_recv_data_async()
+*/
+int32_t
+xma_dec_session_recv_frame_async(XmaDecoderSession *session,
+                                 XmaFrame          *frame,
+                                 XmaAsyncToken     *token);
+
+/**
+ * Switch a scaler session to asynchronous mode
+ *
+ * @see xma_enc_session_async_enable()
+*/
+int32_t
+xma_scaler_session_async_enable(XmaScalerSession *session, int32_t depth);
+
+/**
+ * Queue xma_scaler_session_send_frame()
+ *
+ * @see xma_enc_session_send_frame_async()
+*/
+int32_t
+xma_scaler_session_send_frame_async(XmaScalerSession *session,
+                                    XmaFrame         *frame,
+                                    XmaAsyncToken    *token);
+
+/**
+ * Queue xma_scaler_session_recv_frame_list()
+ *
+ * @see xma_enc_session_recv_data_async()
+*/
+int32_t
+xma_scaler_session_recv_frame_list_async(XmaScalerSession *session,
+                                         XmaFrame        **frame_list,
+                                         XmaAsyncToken    *token);
+
+/**
+ * Wait for an asynchronous request to complete
+ *
+ * @param token Token passed to an _async function
+ *
+ * @return Return code of the plugin call
+*/
+int32_t
+xma_async_wait(XmaAsyncToken *token);
+
+/**
+ * @}
+ */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -104,6 +104,10 @@ typedef struct XmaBufferRef
     XmaBufferType   buffer_type; /**< location of buffer */
     void           *buffer; /**< data */
     bool            is_clone; /**< buffer member allocated externally */
+    void           *pool; /**< device buffer pool owning buffer, if any */
+    uint32_t        bo_handle; /**< device buffer of a device buffer type */
+    size_t          bo_offset; /**< offset of data within device buffer */
+    bool            device_resident; /**< device buffer written by a kernel, host copy is stale */
 } XmaBufferRef;
 
 /**
@@ -182,7 +186,7 @@ typedef struct XmaFrameFormatDesc
  *
  * @param [in] frame_props Description of frame buffer to be allocated
  *
- * @returns XmaFrame pointer
+ * @returns XmaFrame pointer or NULL if memory could not be allocated
 */
 XmaFrame*
 xma_frame_alloc(XmaFrameProperties *frame_props);
@@ -210,9 +214,27 @@ XmaFrame*
 xma_frame_from_buffers_clone(XmaFrameProperties *frame_props,
                              XmaFrameData       *frame_data);
 
+/**
+ * Take an additional reference to a frame
+ *
+ * A plugin that keeps a frame after its send function returns, or a
+ * session that hands a device frame to a connected session, takes a
+ * reference so that the frame and its device buffer stay valid until
+ * the matching xma_frame_free().  References may be taken and dropped
+ * from different threads.
+ *
+ * @param frame frame instance to reference
+ *
+ * @returns frame
+*/
+XmaFrame*
+xma_frame_ref(XmaFrame *frame);
+
 /**
  * Free frame data structure
  *
+ * Drops one reference; the frame is released with the last one.
+ *
  * @param frame frame instance to free
  *
  * @note: A buffer with is_clone flag set will not be freed
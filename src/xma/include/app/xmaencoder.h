@@ -381,6 +381,26 @@ int32_t
 xma_enc_session_recv_data(XmaEncoderSession *session,
                           XmaDataBuffer     *data,
                           int32_t           *data_size);
+
+/**
+ *  @brief Allocate a frame in device memory for sending to the encoder
+ *
+ *  The planes of the frame live in one buffer of a pool of mapped device
+ *  buffers owned by the session, so the plugin moves the frame to the
+ *  device with a single sync and without copying it.  Freeing the frame
+ *  with @ref xma_frame_free() returns the buffer to the pool.  If the frame
+ *  cannot be placed in device memory a host frame is returned as with
+ *  @ref xma_frame_alloc().  A frame may outlive the session; its buffer is
+ *  released when the frame is freed.
+ *
+ *  @param session     Pointer to session created by xma_enc_session_create
+ *  @param frame_props Description of frame buffer to be allocated
+ *
+ *  @return        XmaFrame pointer
+*/
+XmaFrame*
+xma_enc_session_frame_alloc(XmaEncoderSession  *session,
+                            XmaFrameProperties *frame_props);
 /**
  * @}
  */
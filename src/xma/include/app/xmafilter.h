@@ -193,6 +193,20 @@ xma_filter_session_send_frame(XmaFilterSession *session,
 int32_t
 xma_filter_session_recv_frame(XmaFilterSession *session,
                               XmaFrame         *frame);
+
+/**
+ *  @brief Allocate a frame in device memory for sending to the filter
+ *
+ *  Same as @ref xma_enc_session_frame_alloc() for a filter session.
+ *
+ *  @param session     Pointer to session created by xma_filter_session_create
+ *  @param frame_props Description of frame buffer to be allocated
+ *
+ *  @return        XmaFrame pointer
+*/
+XmaFrame*
+xma_filter_session_frame_alloc(XmaFilterSession   *session,
+                               XmaFrameProperties *frame_props);
 /**
  * @}
  */
@@ -443,6 +443,20 @@ xma_scaler_session_send_frame(XmaScalerSession *session,
 int32_t
 xma_scaler_session_recv_frame_list(XmaScalerSession *session,
                                   XmaFrame          **frame_list);
+
+/**
+ *  @brief Allocate a frame in device memory for sending to the scaler
+ *
+ *  Same as @ref xma_enc_session_frame_alloc() for a scaler session.
+ *
+ *  @param session     Pointer to session created by xma_scaler_session_create
+ *  @param frame_props Description of frame buffer to be allocated
+ *
+ *  @return        XmaFrame pointer
+*/
+XmaFrame*
+xma_scaler_session_frame_alloc(XmaScalerSession   *session,
+                               XmaFrameProperties *frame_props);
 /**
  * @}
  */
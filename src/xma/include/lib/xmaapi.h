@@ -17,6 +17,7 @@
 #ifndef _XMA_API_
 #define _XMA_API_
 
+#include <pthread.h>
 #include "xmaplugin.h"
 #include "lib/xmacfg.h"
 #include "lib/xmaconnect.h"
@@ -29,6 +30,8 @@ typedef struct XmaSingleton
     XmaSystemCfg      systemcfg;
     XmaHwCfg          hwcfg;
     XmaConnect        connections[MAX_CONNECTION_ENTRIES];
+    pthread_mutex_t   connections_lock;
+    pthread_cond_t    connections_cond;
     XmaLogger         logger;
     XmaDecoderPlugin  decodercfg[MAX_PLUGINS];
     XmaEncoderPlugin  encodercfg[MAX_PLUGINS];
@@ -63,4 +66,17 @@ int32_t xma_filter_plugins_load(XmaSystemCfg      *systemcfg,
  */
 int32_t xma_kernel_plugins_load(XmaSystemCfg      *systemcfg,
                                 XmaKernelPlugin   *kernels);
+
+/**
+ * Wait for the queued requests of an asynchronous session and stop its
+ * workers
+ */
+void xma_async_destroy(XmaAsync *async);
+
+/**
+ * Allocate a frame in the mapped device buffer pool of a session, falling
+ * back to xma_frame_alloc() when the frame cannot be placed there
+ */
+XmaFrame* xma_frame_session_alloc(XmaSession         *session,
+                                  XmaFrameProperties *frame_props);
 #endif
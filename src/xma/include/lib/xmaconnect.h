@@ -81,6 +81,17 @@ extern "C" {
  *
  *  @li @ref xma_connect_alloc()
  *  @li @ref xma_connect_free()
+ *  @li @ref xma_connect_receiver_get()
+ *
+ *  Frames themselves can also stay on the device between connected
+ *  sessions.  A frame allocated with the frame_alloc function of the
+ *  downstream session lives in a mapped device buffer on that session's
+ *  device.  An upstream plugin on the same device writes it in place
+ *  (see xma_plg_frame_get_paddr()) and marks it device resident, and the
+ *  downstream plugin consumes it without a transfer.  Only when the
+ *  two plugins are on different devices is the frame brought back through
+ *  host memory.  Frame ownership is reference counted with
+ *  xma_frame_ref() and xma_frame_free().
  *
  */
 
@@ -130,6 +141,7 @@ typedef struct XmaConnect
     XmaConnectState     state;
     XmaEndpoint        *sender;
     XmaEndpoint        *receiver;
+    int32_t             receiver_refs; /**< senders using receiver session */
 } XmaConnect;
 
 /**
@@ -162,7 +174,9 @@ xma_connect_alloc(XmaEndpoint *endpt, XmaConnectType type);
  *  @brief Free an XMA connection
  *
  *  This function frees an existing connection entry and reclaims it for
- *  another connection.
+ *  another connection.  Freeing the receiver waits until no sender holds
+ *  it from xma_connect_receiver_get(), so a receiving session must free
+ *  its connection before it is torn down.
  *
  *  @param c_handle Connection handle created with
  *                  xma_connect_alloc function
@@ -175,6 +189,31 @@ xma_connect_alloc(XmaEndpoint *endpt, XmaConnectType type);
 int32_t
 xma_connect_free(int32_t c_handle, XmaConnectType type);
 
+/**
+ *  @brief Look up and hold the receiving session of a connection
+ *
+ *  The receiving session is not destroyed while it is held.  A session
+ *  returned by this function must be released with
+ *  xma_connect_receiver_put() once the sender is done with it.
+ *
+ *  @param c_handle Sender connection handle created with
+ *                  xma_connect_alloc function
+ *
+ *  @return         Receiving session of an active connection
+ *                  NULL if the connection is not active
+*/
+XmaSession*
+xma_connect_receiver_get(int32_t c_handle);
+
+/**
+ *  @brief Release a receiving session held by xma_connect_receiver_get()
+ *
+ *  @param c_handle Sender connection handle passed to
+ *                  xma_connect_receiver_get function
+*/
+void
+xma_connect_receiver_put(int32_t c_handle);
+
 /**
  * @}
  */
@@ -35,6 +35,12 @@
 */
 
 /**
+ * @typedef XmaBufferPool
+ * Pool of mapped device buffers, see xma_plg_buffer_pool_create()
+ *
+ * @typedef XmaAsync
+ * Request queues of a session in asynchronous mode, see xmaasync.h
+ *
  * @typedef XmaSessionType
  * Indicates what class of plugin this session represents
  *
@@ -42,6 +48,9 @@
  * Base class for all other session types
 */
 
+typedef struct XmaBufferPool XmaBufferPool;
+typedef struct XmaAsync XmaAsync;
+
 /**
  * @enum XmaSessionType
  * Indicates what class of plugin this session represents
@@ -78,6 +87,13 @@ typedef struct XmaSession {
     by XMA prior to calling plugin init() and freed automatically as part of
     close. */
     void          *plugin_data;
+    /** Device buffers backing frames allocated for this session by the
+    application. Created on first use, under a lock as allocations may
+    come from several threads, and destroyed with the session. */
+    XmaBufferPool *frame_pool;
+    /** Send and receive queues once the application switched the session
+    to asynchronous mode, NULL otherwise. */
+    XmaAsync      *async;
 } XmaSession;
 
 /**
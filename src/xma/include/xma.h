@@ -25,6 +25,7 @@
 #include "app/xmascaler.h"
 #include "app/xmafilter.h"
 #include "app/xmakernel.h"
+#include "app/xmaasync.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -156,6 +156,187 @@ int32_t xma_plg_buffer_read(XmaHwSession     s_handle,
                             size_t           size,
                             size_t           offset);
 
+/**
+ *  @brief Flush a mapped device buffer to the device
+ *
+ *  Use with buffers obtained from @ref xma_plg_buffer_pool_alloc() or
+ *  frames allocated in device memory. The host side of the buffer is
+ *  already the mapped device buffer, so no copy is made.
+ *
+ *  @param s_handle  The session handle associated with this plugin instance
+ *  @param b_handle  Buffer handle of a mapped device buffer
+ *  @param size      Size of data to flush
+ *  @param offset    Offset from the beginning of the device buffer
+ *
+ *  @return         XMA_SUCCESS on success
+ *  @return         XMA_ERROR on failure
+ *
+ */
+int32_t xma_plg_buffer_sync_to_device(XmaHwSession     s_handle,
+                                      XmaBufferHandle  b_handle,
+                                      size_t           size,
+                                      size_t           offset);
+
+/**
+ *  @brief Update a mapped device buffer from the device
+ *
+ *  Counterpart of @ref xma_plg_buffer_sync_to_device(). After the call the
+ *  mapped host pointer holds the device data.
+ *
+ *  @param s_handle  The session handle associated with this plugin instance
+ *  @param b_handle  Buffer handle of a mapped device buffer
+ *  @param size      Size of data to update
+ *  @param offset    Offset from the beginning of the device buffer
+ *
+ *  @return         XMA_SUCCESS on success
+ *  @return         XMA_ERROR on failure
+ *
+ */
+int32_t xma_plg_buffer_sync_from_device(XmaHwSession     s_handle,
+                                        XmaBufferHandle  b_handle,
+                                        size_t           size,
+                                        size_t           offset);
+
+/**
+ *  @brief Create a pool of mapped device buffers
+ *
+ *  Buffers of a pool are allocated on the DDR bank of the session and
+ *  mapped into the host address space once. Freed buffers are kept by the
+ *  pool and handed out again, so steady state frame I/O performs no
+ *  allocation, mapping or copy; only @ref xma_plg_buffer_sync_to_device()
+ *  or @ref xma_plg_buffer_sync_from_device() is needed.
+ *
+ *  @param s_handle  The session handle associated with this plugin instance
+ *  @param size      Size in bytes of every buffer in the pool
+ *
+ *  @return          Pool or NULL on failure
+ *
+ */
+XmaBufferPool *xma_plg_buffer_pool_create(XmaHwSession s_handle, size_t size);
+
+/**
+ *  @brief Get a buffer from a pool
+ *
+ *  @param pool      Pool returned by @ref xma_plg_buffer_pool_create()
+ *  @param b_handle  Returns the buffer handle
+ *  @param vaddr     Returns the host address the buffer is mapped at
+ *
+ *  @return         XMA_SUCCESS on success
+ *  @return         XMA_ERROR on failure
+ *
+ */
+int32_t xma_plg_buffer_pool_alloc(XmaBufferPool   *pool,
+                                  XmaBufferHandle *b_handle,
+                                  void           **vaddr);
+
+/**
+ *  @brief Return a buffer to its pool
+ *
+ *  @param pool      Pool the buffer was obtained from
+ *  @param b_handle  Buffer handle returned by @ref xma_plg_buffer_pool_alloc()
+ *
+ */
+void xma_plg_buffer_pool_free(XmaBufferPool *pool, XmaBufferHandle b_handle);
+
+/**
+ *  @brief Size of the buffers of a pool
+ *
+ *  @param pool      Pool returned by @ref xma_plg_buffer_pool_create()
+ *
+ *  @return          Size in bytes of every buffer in the pool
+ *
+ */
+size_t xma_plg_buffer_pool_size(XmaBufferPool *pool);
+
+/**
+ *  @brief Destroy a pool
+ *
+ *  Buffers held by the pool are released immediately. Buffers still in use
+ *  are released when they are returned with @ref xma_plg_buffer_pool_free(),
+ *  after which the pool itself is freed.
+ *
+ *  @param pool      Pool returned by @ref xma_plg_buffer_pool_create()
+ *
+ */
+void xma_plg_buffer_pool_destroy(XmaBufferPool *pool);
+
+/**
+ *  @brief Flush a frame allocated in device memory
+ *
+ *  Frames allocated with xma_enc_session_frame_alloc(),
+ *  xma_scaler_session_frame_alloc() or xma_filter_session_frame_alloc()
+ *  live in one mapped device buffer with the planes at
+ *  XmaBufferRef::bo_offset. When such a frame is on the device of this
+ *  session a single sync makes it visible to the kernel and the
+ *  physical address of plane i is
+ *  xma_plg_get_paddr(s_handle, frame->data[0].bo_handle) +
+ *  frame->data[i].bo_offset.
+ *
+ *  @param s_handle  The session handle associated with this plugin instance
+ *  @param frame     Frame to flush
+ *
+ *  A frame already written on this device by an upstream kernel (see
+ *  @ref xma_plg_frame_device_written()) is not flushed at all.  A frame
+ *  written on another device is first brought back to its host planes.
+ *
+ *  @return         XMA_SUCCESS if the frame is on the device
+ *  @return         XMA_ERROR_INVALID if the frame is not a device frame of
+ *                  this device; the plugin must copy it with
+ *                  @ref xma_plg_buffer_write() instead
+ *  @return         XMA_ERROR on failure
+ *
+ */
+int32_t xma_plg_frame_sync_to_device(XmaHwSession s_handle, XmaFrame *frame);
+
+/**
+ *  @brief Get the device address of a frame for a kernel to write
+ *
+ *  Lets an upstream plugin write its output straight into a frame that
+ *  the application allocated from a downstream session on the same device,
+ *  e.g. with xma_enc_session_frame_alloc().  Plane i is at
+ *  *paddr + frame->data[i].bo_offset.  Once the kernel has completed call
+ *  @ref xma_plg_frame_device_written().
+ *
+ *  @param s_handle  The session handle associated with this plugin instance
+ *  @param frame     Frame to be written
+ *  @param paddr     Returns the physical address of the frame buffer
+ *
+ *  @return         XMA_SUCCESS on success
+ *  @return         XMA_ERROR_INVALID if the frame is not a device frame of
+ *                  this device; the plugin must write the host planes
+ *
+ */
+int32_t xma_plg_frame_get_paddr(XmaHwSession  s_handle,
+                                XmaFrame     *frame,
+                                uint64_t     *paddr);
+
+/**
+ *  @brief Mark a device frame as written by a kernel
+ *
+ *  The device buffer of the frame is now current and its host planes are
+ *  stale.  A downstream plugin on the same device consumes the frame
+ *  without any transfer; on another device it is read back first.
+ *
+ *  @param frame     Frame written at the address from
+ *                   @ref xma_plg_frame_get_paddr()
+ *
+ */
+void xma_plg_frame_device_written(XmaFrame *frame);
+
+/**
+ *  @brief Bring a device frame written by a kernel back to its host planes
+ *
+ *  Does nothing for host frames and for device frames whose host planes
+ *  are current.
+ *
+ *  @param frame     Frame to update
+ *
+ *  @return         XMA_SUCCESS on success
+ *  @return         XMA_ERROR on failure
+ *
+ */
+int32_t xma_plg_frame_sync_to_host(XmaFrame *frame);
+
 /**
  *  @brief Write kernel register(s)
  *
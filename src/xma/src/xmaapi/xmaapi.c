@@ -40,6 +40,8 @@ int32_t xma_initialize(char *cfgfile)
 
     g_xma_singleton = malloc(sizeof(*g_xma_singleton));
     memset(g_xma_singleton, 0, sizeof(*g_xma_singleton));
+    pthread_mutex_init(&g_xma_singleton->connections_lock, NULL);
+    pthread_cond_init(&g_xma_singleton->connections_cond, NULL);
 
     ret = xma_cfg_parse(cfgfile, &g_xma_singleton->systemcfg);
     if (ret != XMA_SUCCESS)
@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2018, Xilinx Inc - All rights reserved
+ * Xilinx SDAccel Media Accelerator API
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "app/xmaasync.h"
+#include "lib/xmaapi.h"
+
+#define XMA_ASYNC_MOD "xmaasync"
+#define XMA_ASYNC_MAX_DEPTH 64
+
+typedef int32_t (*XmaAsyncFunc)(XmaSession *session, void *arg0, void *arg1);
+
+/* Request queued to a worker actor; a NULL func stops the worker */
+typedef struct XmaAsyncReq
+{
+    XmaAsync       *async;
+    XmaAsyncFunc    func;
+    void           *arg0;
+    void           *arg1;
+    XmaAsyncToken  *token;
+} XmaAsyncReq;
+
+/*
+ * Sends and receives run on their own actor so that the send of one frame
+ * overlaps the receive of the previous one; each actor keeps the order
+ * its requests were queued in.
+ */
+struct XmaAsync
+{
+    XmaSession     *session;
+    XmaActor       *send_actor;
+    XmaActor       *recv_actor;
+    pthread_mutex_t lock;
+    pthread_cond_t  done_cond;
+};
+
+static void*
+xma_async_worker(void *data)
+{
+    XmaActor *actor = (XmaActor*)data;
+    XmaAsyncReq req;
+    int32_t rc;
+
+    while (1)
+    {
+        if (xma_actor_recvmsg(actor, &req, sizeof(req)) != 0)
+            continue;
+        if (!req.func)
+            break;
+
+        rc = req.func(req.async->session, req.arg0, req.arg1);
+        if (!req.token)
+        {
+            if (rc < 0)
+                xma_logmsg(XMA_ERROR_LOG, XMA_ASYNC_MOD,
+                           "Asynchronous request failed. Return code %d\n",
+                           rc);
+            continue;
+        }
+
+        pthread_mutex_lock(&req.async->lock);
+        req.token->rc = rc;
+        req.token->done = true;
+        pthread_cond_broadcast(&req.async->done_cond);
+        pthread_mutex_unlock(&req.async->lock);
+    }
+
+    return NULL;
+}
+
+static XmaActor*
+xma_async_actor_start(int32_t depth)
+{
+    XmaActor *actor = xma_actor_create(xma_async_worker,
+                                       sizeof(XmaAsyncReq), depth);
+
+    xma_actor_start(actor);
+    return actor;
+}
+
+static void
+xma_async_actor_stop(XmaAsync *async, XmaActor *actor)
+{
+    XmaAsyncReq stop = { async, NULL, NULL, NULL, NULL };
+
+    // Queued requests run first; the actor's own shutdown message then
+    // finds the worker gone and only joins it
+    xma_actor_sendmsg(actor, &stop, sizeof(stop));
+    xma_actor_destroy(actor);
+}
+
+static int32_t
+xma_async_enable(XmaSession *session, int32_t depth)
+{
+    XmaAsync *async;
+
+    xma_logmsg(XMA_DEBUG_LOG, XMA_ASYNC_MOD, "%s() depth %d\n",
+               __func__, depth);
+    if (depth < 1 || depth > XMA_ASYNC_MAX_DEPTH || session->async)
+        return XMA_ERROR_INVALID;
+
+    async = malloc(sizeof(XmaAsync));
+    if (!async)
+        return XMA_ERROR;
+
+    async->session = session;
+    pthread_mutex_init(&async->lock, NULL);
+    pthread_cond_init(&async->done_cond, NULL);
+    async->send_actor = xma_async_actor_start(depth);
+    async->recv_actor = xma_async_actor_start(depth);
+    session->async = async;
+
+    return XMA_SUCCESS;
+}
+
+static int32_t
+xma_async_queue(XmaSession    *session,
+                bool           is_send,
+                XmaAsyncFunc   func,
+                void          *arg0,
+                void          *arg1,
+                XmaAsyncToken *token)
+{
+    XmaAsync *async = session->async;
+    XmaAsyncReq req = { async, func, arg0, arg1, token };
+
+    if (!async)
+    {
+        xma_logmsg(XMA_ERROR_LOG, XMA_ASYNC_MOD,
+                   "Session is not in asynchronous mode\n");
+        return XMA_ERROR;
+    }
+
+    if (token)
+    {
+        token->queue = async;
+        token->done = false;
+        token->rc = XMA_SUCCESS;
+    }
+
+    if (xma_actor_sendmsg(is_send ? async->send_actor : async->recv_actor,
+                          &req, sizeof(req)) != 0)
+        return XMA_ERROR;
+
+    return XMA_SUCCESS;
+}
+
+void
+xma_async_destroy(XmaAsync *async)
+{
+    if (!async)
+        return;
+
+    xma_async_actor_stop(async, async->send_actor);
+    xma_async_actor_stop(async, async->recv_actor);
+    pthread_cond_destroy(&async->done_cond);
+    pthread_mutex_destroy(&async->lock);
+    async->session->async = NULL;
+    free(async);
+}
+
+int32_t
+xma_async_wait(XmaAsyncToken *token)
+{
+    XmaAsync *async = (XmaAsync*)token->queue;
+
+    pthread_mutex_lock(&async->lock);
+    while (!token->done)
+        pthread_cond_wait(&async->done_cond, &async->lock);
+    pthread_mutex_unlock(&async->lock);
+
+    return token->rc;
+}
+
+static int32_t
+xma_async_enc_send(XmaSession *session, void *frame, void *unused)
+{
+    return xma_enc_session_send_frame(to_xma_encoder(session),
+                                      (XmaFrame*)frame);
+}
+
+static int32_t
+xma_async_enc_recv(XmaSession *session, void *data, void *data_size)
+{
+    return xma_enc_session_recv_data(to_xma_encoder(session),
+                                     (XmaDataBuffer*)data,
+                                     (int32_t*)data_size);
+}
+
+static int32_t
+xma_async_dec_send(XmaSession *session, void *data, void *data_used)
+{
+    return xma_dec_session_send_data(to_xma_decoder(session),
+                                     (XmaDataBuffer*)data,
+                                     (int32_t*)data_used);
+}
+
+static int32_t
+xma_async_dec_recv(XmaSession *session, void *frame, void *unused)
+{
+    return xma_dec_session_recv_frame(to_xma_decoder(session),
+                                      (XmaFrame*)frame);
+}
+
+static int32_t
+xma_async_scaler_send(XmaSession *session, void *frame, void *unused)
+{
+    return xma_scaler_session_send_frame(to_xma_scaler(session),
+                                         (XmaFrame*)frame);
+}
+
+static int32_t
+xma_async_scaler_recv(XmaSession *session, void *frame_list, void *unused)
+{
+    return xma_scaler_session_recv_frame_list(to_xma_scaler(session),
+                                              (XmaFrame**)frame_list);
+}
+
+int32_t
+xma_enc_session_async_enable(XmaEncoderSession *session, int32_t depth)
+{
+    return xma_async_enable(&session->base, depth);
+}
+
+int32_t
+xma_enc_session_send_frame_async(XmaEncoderSession *session,
+                                 XmaFrame          *frame,
+                                 XmaAsyncToken     *token)
+{
+    return xma_async_queue(&session->base, true, xma_async_enc_send,
+                           frame, NULL, token);
+}
+
+int32_t
+xma_enc_session_recv_data_async(XmaEncoderSession *session,
+                                XmaDataBuffer     *data,
+                                int32_t           *data_size,
+                                XmaAsyncToken     *token)
+{
+    return xma_async_queue(&session->base, false, xma_async_enc_recv,
+                           data, data_size, token);
+}
+
+int32_t
+xma_dec_session_async_enable(XmaDecoderSession *session, int32_t depth)
+{
+    return xma_async_enable(&session->base, depth);
+}
+
+int32_t
+xma_dec_session_send_data_async(XmaDecoderSession *session,
+                                XmaDataBuffer     *data,
+                                int32_t           *data_used,
+                                XmaAsyncToken     *token)
+{
+    return xma_async_queue(&session->base, true, xma_async_dec_send,
+                           data, data_used, token);
+}
+
+int32_t
+xma_dec_session_recv_frame_async(XmaDecoderSession *session,
+                                 XmaFrame          *frame,
+                                 XmaAsyncToken     *token)
+{
+    return xma_async_queue(&session->base, false, xma_async_dec_recv,
+                           frame, NULL, token);
+}
+
+int32_t
+xma_scaler_session_async_enable(XmaScalerSession *session, int32_t depth)
+{
+    return xma_async_enable(&session->base, depth);
+}
+
+int32_t
+xma_scaler_session_send_frame_async(XmaScalerSession *session,
+                                    XmaFrame         *frame,
+                                    XmaAsyncToken    *token)
+{
+    return xma_async_queue(&session->base, true, xma_async_scaler_send,
+                           frame, NULL, token);
+}
+
+int32_t
+xma_scaler_session_recv_frame_list_async(XmaScalerSession *session,
+                                         XmaFrame        **frame_list,
+                                         XmaAsyncToken    *token)
+{
+    return xma_async_queue(&session->base, false, xma_async_scaler_recv,
+                           frame_list, NULL, token);
+}
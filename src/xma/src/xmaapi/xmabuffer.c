@@ -14,14 +14,19 @@
  * License for the specific language governing permissions and limitations
  * under the License.
  */
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "app/xmabuffers.h"
 #include "app/xmalogger.h"
+#include "lib/xmaapi.h"
 
 #define XMA_BUFFER_MOD "xmabuffer"
 
+/* Serializes creation of session frame pools by concurrent allocations */
+static pthread_mutex_t frame_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
 int32_t
 xma_frame_planes_get(XmaFrameProperties *frame_props)
 {
@@ -38,6 +43,42 @@ xma_frame_planes_get(XmaFrameProperties *frame_props)
     return frame_format_desc[frame_props->format].num_planes;
 }
 
+/* Size in bytes of a plane.  Planar formats give the bits of one sample
+ * in bits_per_pixel, samples wider than 8 bits are stored in 16 bits.
+ * Packed RGB888 gives the bits of one pixel, or of one component when
+ * bits_per_pixel is below 24.  Chroma planes of 4:2:0 and 4:2:2 are
+ * subsampled, rounding odd dimensions up.
+ */
+static size_t
+xma_frame_plane_size(XmaFrameProperties *frame_props, int32_t plane)
+{
+    size_t width = frame_props->width;
+    size_t height = frame_props->height;
+    size_t bytes = frame_props->bits_per_pixel > 8 ? 2 : 1;
+
+    switch (frame_props->format)
+    {
+    case XMA_YUV420_FMT_TYPE:
+        if (plane > 0)
+            return ((width + 1) / 2) * ((height + 1) / 2) * bytes;
+        break;
+    case XMA_YUV422_FMT_TYPE:
+        if (plane > 0)
+            return ((width + 1) / 2) * height * bytes;
+        break;
+    case XMA_RGB888_FMT_TYPE:
+        if (frame_props->bits_per_pixel >= 24)
+            bytes = (frame_props->bits_per_pixel + 7) / 8;
+        else
+            bytes *= 3;
+        break;
+    default:
+        break;
+    }
+
+    return width * height * bytes;
+}
+
 XmaFrame*
 xma_frame_alloc(XmaFrameProperties *frame_props)
 {
@@ -45,6 +86,8 @@ xma_frame_alloc(XmaFrameProperties *frame_props)
 
     xma_logmsg(XMA_DEBUG_LOG, XMA_BUFFER_MOD, "%s()\n", __func__);
     XmaFrame *frame = malloc(sizeof(XmaFrame));
+    if (!frame)
+        return NULL;
     memset(frame, 0, sizeof(XmaFrame));
     frame->frame_props = *frame_props;
     num_planes = xma_frame_planes_get(frame_props);
@@ -54,9 +97,68 @@ xma_frame_alloc(XmaFrameProperties *frame_props)
         frame->data[i].refcount++;
         frame->data[i].buffer_type = XMA_HOST_BUFFER_TYPE;
         frame->data[i].is_clone = false;
-        // TODO: Get plane size for each plane
-        frame->data[i].buffer = malloc(frame_props->width *
-                                       frame_props->height);
+        frame->data[i].buffer = malloc(xma_frame_plane_size(frame_props, i));
+        if (!frame->data[i].buffer)
+        {
+            xma_logmsg(XMA_ERROR_LOG, XMA_BUFFER_MOD,
+                       "%s() Failed to allocate plane %d\n", __func__, i);
+            while (i--)
+                free(frame->data[i].buffer);
+            free(frame);
+            return NULL;
+        }
+    }
+
+    return frame;
+}
+
+XmaFrame*
+xma_frame_session_alloc(XmaSession *session, XmaFrameProperties *frame_props)
+{
+    XmaBufferPool *pool;
+    XmaBufferHandle b_handle;
+    int32_t num_planes;
+    size_t frame_size = 0;
+    size_t plane_offset = 0;
+    void *vaddr;
+
+    xma_logmsg(XMA_DEBUG_LOG, XMA_BUFFER_MOD, "%s()\n", __func__);
+    num_planes = xma_frame_planes_get(frame_props);
+    for (int32_t i = 0; i < num_planes; i++)
+        frame_size += xma_frame_plane_size(frame_props, i);
+
+    pthread_mutex_lock(&frame_pool_lock);
+    if (!session->frame_pool && frame_size)
+        session->frame_pool =
+            xma_plg_buffer_pool_create(session->hw_session, frame_size);
+    pool = session->frame_pool;
+    pthread_mutex_unlock(&frame_pool_lock);
+
+    // Frames that do not fit the pool of the session stay in host memory
+    if (!pool ||
+        frame_size > xma_plg_buffer_pool_size(pool) ||
+        xma_plg_buffer_pool_alloc(pool, &b_handle, &vaddr))
+        return xma_frame_alloc(frame_props);
+
+    XmaFrame *frame = malloc(sizeof(XmaFrame));
+    if (!frame)
+    {
+        xma_plg_buffer_pool_free(pool, b_handle);
+        return NULL;
+    }
+    memset(frame, 0, sizeof(XmaFrame));
+    frame->frame_props = *frame_props;
+
+    for (int32_t i = 0; i < num_planes; i++)
+    {
+        frame->data[i].refcount++;
+        frame->data[i].buffer_type = XMA_DEVICE_BUFFER_TYPE;
+        frame->data[i].is_clone = false;
+        frame->data[i].pool = pool;
+        frame->data[i].bo_handle = b_handle;
+        frame->data[i].bo_offset = plane_offset;
+        frame->data[i].buffer = (uint8_t*)vaddr + plane_offset;
+        plane_offset += xma_frame_plane_size(frame_props, i);
     }
 
     return frame;
@@ -72,6 +174,8 @@ xma_frame_from_buffers_clone(XmaFrameProperties *frame_props,
                "%s() frame_props %p and frame_data %p\n",
                __func__, frame_props, frame_data);
     XmaFrame *frame = malloc(sizeof(XmaFrame));
+    if (!frame)
+        return NULL;
     memset(frame, 0, sizeof(XmaFrame));
     frame->frame_props = *frame_props;
     num_planes = xma_frame_planes_get(frame_props);
@@ -87,6 +191,22 @@ xma_frame_from_buffers_clone(XmaFrameProperties *frame_props,
     return frame;
 }
 
+XmaFrame*
+xma_frame_ref(XmaFrame *frame)
+{
+    int32_t num_planes;
+
+    xma_logmsg(XMA_DEBUG_LOG, XMA_BUFFER_MOD,
+               "%s() Reference frame %p\n", __func__, frame);
+    num_planes = xma_frame_planes_get(&frame->frame_props);
+
+    // data[0] carries the reference count of the frame
+    for (int32_t i = 0; i < num_planes; i++)
+        __atomic_add_fetch(&frame->data[i].refcount, 1, __ATOMIC_RELAXED);
+
+    return frame;
+}
+
 void
 xma_frame_free(XmaFrame *frame)
 {
@@ -96,12 +216,20 @@ xma_frame_free(XmaFrame *frame)
                "%s() Free frame %p\n", __func__, frame);
     num_planes = xma_frame_planes_get(&frame->frame_props);
 
-    for (int32_t i = 0; i < num_planes; i++)
-        frame->data[i].refcount--;
+    for (int32_t i = 1; i < num_planes; i++)
+        __atomic_sub_fetch(&frame->data[i].refcount, 1, __ATOMIC_RELAXED);
 
-    if (frame->data[0].refcount > 0)
+    if (__atomic_sub_fetch(&frame->data[0].refcount, 1, __ATOMIC_ACQ_REL) > 0)
         return;
 
+    // Planes of a device frame share one pooled buffer
+    if (frame->data[0].pool)
+    {
+        xma_plg_buffer_pool_free(frame->data[0].pool, frame->data[0].bo_handle);
+        free(frame);
+        return;
+    }
+
     for (int32_t i = 0; i < num_planes && !frame->data[i].is_clone; i++)
         free(frame->data[i].buffer);
 
@@ -115,6 +243,8 @@ xma_data_from_buffer_clone(uint8_t *data, size_t size)
                "%s() Cloning buffer from %p of size %lu\n",
                __func__, data, size);
     XmaDataBuffer *buffer = malloc(sizeof(XmaDataBuffer));
+    if (!buffer)
+        return NULL;
     memset(buffer, 0, sizeof(XmaDataBuffer));
     buffer->data.refcount++;
     buffer->data.buffer_type = XMA_HOST_BUFFER_TYPE;
@@ -131,11 +261,18 @@ xma_data_buffer_alloc(size_t size)
     xma_logmsg(XMA_DEBUG_LOG, XMA_BUFFER_MOD,
                "%s() Allocate buffer from of size %lu\n", __func__, size);
     XmaDataBuffer *buffer = malloc(sizeof(XmaDataBuffer));
+    if (!buffer)
+        return NULL;
     memset(buffer, 0, sizeof(XmaDataBuffer));
     buffer->data.refcount++;
     buffer->data.buffer_type = XMA_HOST_BUFFER_TYPE;
     buffer->data.is_clone = false;
     buffer->data.buffer = malloc(size);
+    if (!buffer->data.buffer && size)
+    {
+        free(buffer);
+        return NULL;
+    }
     buffer->alloc_size = size;
 
     return buffer;
@@ -49,12 +49,11 @@ xma_connect_alloc(XmaEndpoint *endpt, XmaConnectType type)
     // If this is a sender, find the first unused connection
     // entry and set the state to pending.
     // NOTE: The connection table is only local to a process
-    //       and not kept in shared system memory
-    // TODO: It may be necessary to obtain a lock on the connection
-    //       table; however, assume for now that connections are
-    //       established during initialization and initialization
-    //       is all performed from a single thread.  This assumption
-    //       may not be true and could create a problem.
+    //       and not kept in shared system memory.  Sessions of one
+    //       process may be created and destroyed from any thread, so
+    //       the table is only accessed with connections_lock held.
+
+    pthread_mutex_lock(&g_xma_singleton->connections_lock);
 
     // Find an unused entry for a sender
     if (type == XMA_CONNECT_SENDER)
@@ -89,6 +88,8 @@ xma_connect_alloc(XmaEndpoint *endpt, XmaConnectType type)
             }
         }
     }
+
+    pthread_mutex_unlock(&g_xma_singleton->connections_lock);
     return c_handle;
 }
 
@@ -100,13 +101,14 @@ xma_connect_free(int32_t c_handle, XmaConnectType type)
     if (c_handle == -1)
         return XMA_SUCCESS;
 
+    pthread_mutex_lock(&g_xma_singleton->connections_lock);
+
     if (type == XMA_CONNECT_SENDER &&
         conntbl[c_handle].sender != NULL)
     {
         free(conntbl[c_handle].sender);
         conntbl[c_handle].sender = NULL;
-        if (conntbl[c_handle].state == XMA_CONNECT_ACTIVE &&
-            conntbl[c_handle].receiver == NULL)
+        if (conntbl[c_handle].receiver == NULL)
             conntbl[c_handle].state = XMA_CONNECT_UNUSED;
         else
             conntbl[c_handle].state = XMA_CONNECT_PENDING_DELETE;
@@ -115,16 +117,56 @@ xma_connect_free(int32_t c_handle, XmaConnectType type)
     if (type == XMA_CONNECT_RECEIVER &&
         conntbl[c_handle].receiver != NULL)
     {
+        // Hide the receiver from new lookups, then wait for the
+        // senders still using it
+        conntbl[c_handle].state = XMA_CONNECT_PENDING_DELETE;
+        while (conntbl[c_handle].receiver_refs > 0)
+            pthread_cond_wait(&g_xma_singleton->connections_cond,
+                              &g_xma_singleton->connections_lock);
+
         free(conntbl[c_handle].receiver);
         conntbl[c_handle].receiver = NULL;
-        if (conntbl[c_handle].state == XMA_CONNECT_PENDING_DELETE &&
-            conntbl[c_handle].sender == NULL)
+        if (conntbl[c_handle].sender == NULL)
             conntbl[c_handle].state = XMA_CONNECT_UNUSED;
-        else
-            conntbl[c_handle].state = XMA_CONNECT_PENDING_DELETE;
     }
 
-   return XMA_SUCCESS;
+    pthread_mutex_unlock(&g_xma_singleton->connections_lock);
+    return XMA_SUCCESS;
+}
+
+XmaSession*
+xma_connect_receiver_get(int32_t c_handle)
+{
+    XmaConnect *conntbl = g_xma_singleton->connections;
+    XmaSession *session = NULL;
+
+    if (c_handle == -1)
+        return NULL;
+
+    pthread_mutex_lock(&g_xma_singleton->connections_lock);
+    if (conntbl[c_handle].state == XMA_CONNECT_ACTIVE &&
+        conntbl[c_handle].receiver != NULL)
+    {
+        session = conntbl[c_handle].receiver->session;
+        conntbl[c_handle].receiver_refs++;
+    }
+    pthread_mutex_unlock(&g_xma_singleton->connections_lock);
+
+    return session;
+}
+
+void
+xma_connect_receiver_put(int32_t c_handle)
+{
+    XmaConnect *conntbl = g_xma_singleton->connections;
+
+    if (c_handle == -1)
+        return;
+
+    pthread_mutex_lock(&g_xma_singleton->connections_lock);
+    if (--conntbl[c_handle].receiver_refs == 0)
+        pthread_cond_broadcast(&g_xma_singleton->connections_cond);
+    pthread_mutex_unlock(&g_xma_singleton->connections_lock);
 }
 
 bool
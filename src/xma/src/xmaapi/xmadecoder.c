@@ -108,6 +108,8 @@ xma_dec_session_create(XmaDecoderProperties *dec_props)
     dec_session->decoder_props = *dec_props;
     dec_session->base.chan_id = -1;
     dec_session->base.session_type = XMA_DECODER;
+    // Decoder output is not connected, see xmaconnect.h
+    dec_session->conn_recv_handle = -1;
 
     // Just assume this is a H.264 decoder for now and that the FPGA
     // has been downloaded.  This is accomplished by getting the
@@ -174,6 +176,9 @@ xma_dec_session_destroy(XmaDecoderSession *session)
     int32_t rc;
 
     xma_logmsg(XMA_DEBUG_LOG, XMA_DECODER_MOD, "%s()\n", __func__);
+    // Let queued asynchronous requests finish before closing the plugin
+    xma_async_destroy(session->base.async);
+
     rc  = session->decoder_plugin->close(session);
     if (rc != 0)
         xma_logmsg(XMA_ERROR_LOG, XMA_DECODER_MOD,
@@ -185,6 +185,14 @@ xma_enc_session_destroy(XmaEncoderSession *session)
     int32_t rc;
 
     xma_logmsg(XMA_DEBUG_LOG, XMA_ENCODER_MOD, "%s()\n", __func__);
+    // Free the receiver connection first, this waits for connected
+    // senders still writing to this session
+    xma_connect_free(session->conn_recv_handle,
+                        XMA_CONNECT_RECEIVER);
+
+    // Let queued asynchronous requests finish before closing the plugin
+    xma_async_destroy(session->base.async);
+
     rc  = session->encoder_plugin->close(session);
     if (rc != 0)
         xma_logmsg(XMA_ERROR_LOG, XMA_ENCODER_MOD,
@@ -193,9 +201,8 @@ xma_enc_session_destroy(XmaEncoderSession *session)
     // Clean up the private data
     free(session->base.plugin_data);
 
-    // Free the receiver connection
-    xma_connect_free(session->conn_recv_handle,
-                        XMA_CONNECT_RECEIVER);
+    // Release the device buffers behind frames of this session
+    xma_plg_buffer_pool_destroy(session->base.frame_pool);
 
     /* free kernel/kernel-session */
     rc = xma_res_free_kernel(g_xma_singleton->shm_res_cfg,
@@ -227,3 +234,11 @@ xma_enc_session_recv_data(XmaEncoderSession *session,
     xma_logmsg(XMA_DEBUG_LOG, XMA_ENCODER_MOD, "%s()\n", __func__);
     return session->encoder_plugin->recv_data(session, data, data_size);
 }
+
+XmaFrame*
+xma_enc_session_frame_alloc(XmaEncoderSession  *session,
+                            XmaFrameProperties *frame_props)
+{
+    xma_logmsg(XMA_DEBUG_LOG, XMA_ENCODER_MOD, "%s()\n", __func__);
+    return xma_frame_session_alloc(&session->base, frame_props);
+}
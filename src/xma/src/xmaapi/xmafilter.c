@@ -204,6 +204,9 @@ xma_filter_session_destroy(XmaFilterSession *session)
     // Clean up the private data
     free(session->base.plugin_data);
 
+    // Release the device buffers behind frames of this session
+    xma_plg_buffer_pool_destroy(session->base.frame_pool);
+
     // Free each sender connection
     xma_connect_free(session->conn_send_handle, XMA_CONNECT_SENDER);
 
@@ -228,18 +231,20 @@ int32_t
 xma_filter_session_send_frame(XmaFilterSession  *session,
                               XmaFrame          *frame)
 {
+    XmaSession *recv = NULL;
+    int32_t rc;
+
     xma_logmsg(XMA_DEBUG_LOG, XMA_FILTER_MOD, "%s()\n", __func__);
     if (session->conn_send_handle != -1)
     {
-        // Get the connection entry to find the receiver
-        int32_t c_handle = session->conn_send_handle;
-        XmaConnect *conn = &g_xma_singleton->connections[c_handle];
-        XmaEndpoint *recv = conn->receiver;
+        // Get the connection entry to find the receiver, which is held
+        // until the frame has been sent
+        recv = xma_connect_receiver_get(session->conn_send_handle);
         if (recv)
         {
-            if (is_xma_encoder(recv->session))
+            if (is_xma_encoder(recv))
             {
-                XmaEncoderSession *e_ses = to_xma_encoder(recv->session);
+                XmaEncoderSession *e_ses = to_xma_encoder(recv);
                 if (!e_ses->encoder_plugin->get_dev_input_paddr) {
                     xma_logmsg(XMA_DEBUG_LOG, XMA_FILTER_MOD,
                         "encoder plugin does not support zero copy\n");
@@ -251,7 +256,12 @@ xma_filter_session_send_frame(XmaFilterSession  *session,
         }
     }
 send:
-    return session->filter_plugin->send_frame(session, frame);
+    rc = session->filter_plugin->send_frame(session, frame);
+
+    if (recv)
+        xma_connect_receiver_put(session->conn_send_handle);
+
+    return rc;
 }
 
 int32_t
@@ -261,3 +271,11 @@ xma_filter_session_recv_frame(XmaFilterSession  *session,
     xma_logmsg(XMA_DEBUG_LOG, XMA_FILTER_MOD, "%s()\n", __func__);
     return session->filter_plugin->recv_frame(session, frame);
 }
+
+XmaFrame*
+xma_filter_session_frame_alloc(XmaFilterSession   *session,
+                               XmaFrameProperties *frame_props)
+{
+    xma_logmsg(XMA_DEBUG_LOG, XMA_FILTER_MOD, "%s()\n", __func__);
+    return xma_frame_session_alloc(&session->base, frame_props);
+}
@@ -376,7 +376,7 @@ int32_t xma_actor_sendmsg(XmaActor *actor, void *msg, size_t msg_size)
             actor->msg_q->num_entries,
             actor->msg_q->front,
             actor->msg_q->back);
-    if (xma_msgq_isfull(actor->msg_q))
+    while (xma_msgq_isfull(actor->msg_q))
     {
         XMA_DBG_PRINTF("Waiting: msgq_isfull\n");
         pthread_cond_wait(&actor->dequeued_cond, &actor->lock);
@@ -414,7 +414,7 @@ int32_t xma_actor_recvmsg(XmaActor *actor, void *msg, size_t msg_size)
             actor->msg_q->back);
 
 
-    if (xma_msgq_isempty(actor->msg_q))
+    while (xma_msgq_isempty(actor->msg_q))
         pthread_cond_wait(&actor->queued_cond, &actor->lock);
 
     was_full = xma_msgq_isfull(actor->msg_q);
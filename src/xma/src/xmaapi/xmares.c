@@ -30,6 +30,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <pthread.h>
 #include <sched.h>
 #include <signal.h>
@@ -37,6 +38,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "lib/xmaapi.h"
@@ -46,6 +48,12 @@
 
 #define XMA_RES_MOD "xmares"
 
+/* Layout version of the shared memory database, bump on any change to
+ * XmaResConfig or the structures it contains */
+#define XMA_SHM_DB_VERSION 2
+/* Yields to wait for a concurrent creator to size and publish the db */
+#define XMA_SHM_ATTACH_TRIES 100000
+
 enum XmaKernType {
     xma_res_encoder = 1,
     xma_res_scaler,
@@ -93,12 +101,24 @@ typedef struct XmaImage {
 typedef struct XmaKernelChan {
     pthread_t thread_id;
     XmaSession *session;
+    uint64_t load; /**< declared load of session on this channel */
 } XmaKernelChan;
 
+/**
+ * Load of a kernel instance used to place new sessions
+*/
+typedef struct XmaKernelLoad {
+    uint32_t chan_cnt; /**< channels in use */
+    uint64_t session_load; /**< sum of declared loads (pixels/sec) */
+    uint32_t recent_allocs; /**< allocations, halved every second */
+    int64_t last_decay; /**< CLOCK_MONOTONIC second of last decay */
+} XmaKernelLoad;
+
 typedef struct XmaKernelInstance {
     uint32_t kernel_id;
     pid_t client_id;
     XmaKernelChan channels[MAX_KERNEL_CHANS];
+    XmaKernelLoad load;
 } XmaKernelInstance;
 
 typedef struct XmaDevice {
@@ -117,12 +137,27 @@ typedef struct XmaShmRes {
 } XmaShmRes;
 
 typedef struct XmaResConfig {
+    uint32_t version; /**< XMA_SHM_DB_VERSION, set once initialized */
     XmaShmRes sys_res;
     pthread_mutex_t lock;
     pid_t clients[MAX_XILINX_DEVICES * MAX_KERNEL_CONFIGS];
     uint32_t ref_cnt;
 } XmaResConfig;
 
+/**
+ * Compatible kernel instance found while placing a session
+*/
+typedef struct XmaKernCandidate {
+    int32_t dev_id;
+    int32_t kern_idx;
+    uint64_t session_load;
+    uint32_t chan_cnt;
+    uint32_t recent_allocs;
+    size_t kernel_data_size;
+    int32_t (*alloc_chan)(XmaSession *pending, XmaSession **current,
+                          uint32_t sess_cnt);
+} XmaKernCandidate;
+
 /**********************************GLOBALS*************************************/
 #ifdef XMA_RES_TEST
 char *XMA_SHM_FILE = "/tmp/xma_shm_db";
@@ -140,6 +175,10 @@ static void xma_shm_close(XmaResConfig *xma_shm, bool rm_shm);
 static int xma_init_shm(XmaResConfig *xma_shm, XmaSystemCfg *config,
                         bool shm_locked);
 
+static bool xma_shm_size_ok(int fd);
+
+static bool xma_shm_version_ok(XmaResConfig *xma_shm);
+
 static int xma_shm_lock(XmaResConfig *xma_shm);
 
 static int xma_shm_unlock(XmaResConfig *xma_shm);
@@ -160,10 +199,31 @@ static int32_t xma_res_alloc_kernel(XmaResources shm_cfg,
                                     XmaKernReq *kern_props,
                                     enum XmaKernType type);
 
-static int xma_client_thread_kernel_alloc(XmaResources shm_cfg,
-                                          XmaDevice *dev,
+static bool xma_res_kern_match(XmaKernel *kernel,
+                               XmaKernReq *kern_props,
+                               enum XmaKernType type,
+                               size_t *kernel_data_size,
+                               int32_t (**alloc_chan)(XmaSession *p,
+                                                      XmaSession **s,
+                                                      uint32_t cnt));
+
+static int xma_res_find_kernels(XmaResConfig *xma_shm,
+                                XmaKernReq *kern_props,
+                                enum XmaKernType type,
+                                XmaKernCandidate *cands);
+
+static int xma_res_cmp_kern_load(const void *a, const void *b);
+
+static uint64_t xma_res_session_load(XmaSession *session);
+
+static void xma_res_kern_load_decay(XmaKernelLoad *load);
+
+static bool xma_dev_has_client(XmaDevice *dev, pid_t proc_id);
+
+static int xma_client_thread_kernel_alloc(XmaDevice *dev,
                                           int dev_kern_idx,
                                           XmaSession *session,
+                                          uint64_t session_load,
                                           size_t kernel_data_size,
                                           int32_t (*alloc_chan)(XmaSession *p,
                                                                 XmaSession **s,
@@ -513,6 +573,7 @@ static XmaResConfig *xma_shm_open(char *shm_filename, XmaSystemCfg *config)
     ret = xma_init_shm(shm_map, config, false);
     if (ret)
         return NULL;
+    __atomic_store_n(&shm_map->version, XMA_SHM_DB_VERSION, __ATOMIC_RELEASE);
 
     return shm_map;
 
@@ -532,10 +593,22 @@ eexist:
         return NULL;
     }
 
+    if (!xma_shm_size_ok(fd)) {
+        close(fd);
+        goto mismatch;
+    }
+
     shm_map = (XmaResConfig *)mmap(NULL, sizeof(XmaResConfig),
                PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
 
     close(fd);
+    if (shm_map == MAP_FAILED)
+        return NULL;
+
+    if (!xma_shm_version_ok(shm_map)) {
+        munmap((void*)shm_map, sizeof(XmaResConfig));
+        goto mismatch;
+    }
 
     /* verify processes and update ref cnt */
     ret = xma_verify_shm_client_procs(shm_map, config);
@@ -554,6 +627,45 @@ eexist:
     }
 
     return shm_map;
+
+mismatch:
+    xma_logmsg(XMA_ERROR_LOG, XMA_RES_MOD,
+               "Resource database %s was created with a different layout, "
+               "remove it once no XMA process is running\n", shm_filename);
+    return NULL;
+}
+
+/* Creator sizes the file right after creating it */
+static bool xma_shm_size_ok(int fd)
+{
+    struct stat stat_buf;
+    int i;
+
+    for (i = 0; i < XMA_SHM_ATTACH_TRIES; i++) {
+        if (fstat(fd, &stat_buf))
+            return false;
+        if (stat_buf.st_size)
+            break;
+        sched_yield();
+    }
+
+    return stat_buf.st_size == sizeof(XmaResConfig);
+}
+
+/* Creator publishes the version once the database is initialized */
+static bool xma_shm_version_ok(XmaResConfig *xma_shm)
+{
+    uint32_t version = 0;
+    int i;
+
+    for (i = 0; i < XMA_SHM_ATTACH_TRIES; i++) {
+        version = __atomic_load_n(&xma_shm->version, __ATOMIC_ACQUIRE);
+        if (version)
+            break;
+        sched_yield();
+    }
+
+    return version == XMA_SHM_DB_VERSION;
 }
 
 void xma_res_mark_xma_ready(XmaResources shm_cfg)
@@ -832,128 +944,73 @@ static int xma_free_dev(XmaResConfig *xma_shm, int32_t dev_handle,
     return XMA_ERROR_INVALID;
 }
 
+/*
+ * Sessions are placed on the least loaded compatible kernel instance of all
+ * devices. Instances are ranked by declared session load, then channels in
+ * use, then recent allocations so that a burst of sessions without declared
+ * load still spreads out. The whole search and allocation is done under the
+ * shm lock so concurrent processes see each other's placements.
+*/
 static int32_t xma_res_alloc_kernel(XmaResources shm_cfg,
                                          XmaSession *session,
                                          XmaKernReq *kern_props,
                                          enum XmaKernType type)
 {
-    int32_t (*plugin_alloc_chan)(XmaSession *pending,
-                                 XmaSession **current,
-                                 uint32_t sess_cnt);
+    XmaKernCandidate cands[MAX_XILINX_DEVICES * MAX_KERNEL_CONFIGS];
     XmaResConfig *xma_shm = (XmaResConfig *)shm_cfg;
     pid_t proc_id = getpid();
-    extern XmaSingleton *g_xma_singleton;
-    int kern_idx, dev_id;
+    int cand_cnt, i;
     bool kern_aquired = false;
-    size_t kernel_data_size;
+    uint64_t session_load;
 
     xma_logmsg(XMA_DEBUG_LOG, XMA_RES_MOD, "%s()\n", __func__);
     if (!session)
         return XMA_ERROR_INVALID;
 
-    for (dev_id = -1; !kern_aquired && (dev_id < MAX_XILINX_DEVICES);)
-    {
-        XmaDevice *dev;
-        int ret = 0;
-        bool dev_exclusive = kern_props->dev_excl;
+    session_load = xma_res_session_load(session);
 
-        dev_id = xma_res_alloc_next_dev(shm_cfg, dev_id, dev_exclusive);
-        if (dev_id < 0)
-            break;
+    if (xma_shm_lock(xma_shm))
+        return XMA_ERROR;
 
-        dev = &xma_shm->sys_res.devices[dev_id];
-        /* JPM check to see if matching kernel is on allocated device */
-        /* if not, free device, increment dev count, re-loop */
-        for (kern_idx = 0;
-             kern_idx < MAX_KERNEL_CONFIGS &&
-             kern_idx < dev->kernel_cnt && !kern_aquired;
-             kern_idx++)
-        {
-            int str_cmp1 = -1, str_cmp2 = -1, type_cmp = false;
-            int kern_id = dev->kernels[kern_idx].kernel_id;
-            XmaKernel *kernel =
-                &xma_shm->sys_res.images[dev->image_id].kernels[kern_id];
-            XmaScalerPlugin *scaler;
-            XmaDecoderPlugin *decoder;
-            XmaEncoderPlugin *encoder;
-            XmaFilterPlugin *filter;
-            XmaKernelPlugin *kernplg;
-            plugin_alloc_chan = NULL;
-
-            str_cmp1 = strcmp(kernel->vendor, kern_props->vendor);
-            if (type == xma_res_scaler) {
-                scaler = &g_xma_singleton->scalercfg[kernel->plugin_handle];
-                str_cmp2 = strcmp(kernel->function, XMA_CFG_FUNC_NM_SCALE);
-                type_cmp = scaler->hwscaler_type ==
-                           kern_props->kernel_spec.scal_type ? true : false;
-                plugin_alloc_chan = scaler->alloc_chan;
-                kernel_data_size = 0;
-            } else if (type == xma_res_encoder) {
-                encoder = &g_xma_singleton->encodercfg[kernel->plugin_handle];
-                str_cmp2 = strcmp(kernel->function, XMA_CFG_FUNC_NM_ENC);
-                type_cmp = encoder->hwencoder_type ==
-                           kern_props->kernel_spec.enc_type ? true : false;
-                plugin_alloc_chan = encoder->alloc_chan;
-                kernel_data_size = encoder->kernel_data_size;
-            } else if (type == xma_res_decoder) {
-                decoder = &g_xma_singleton->decodercfg[kernel->plugin_handle];
-                str_cmp2 = strcmp(kernel->function, XMA_CFG_FUNC_NM_DEC);
-                type_cmp = decoder->hwdecoder_type ==
-                           kern_props->kernel_spec.dec_type ? true : false;
-                plugin_alloc_chan = NULL;
-                kernel_data_size = 0;
-            } else if (type == xma_res_filter) {
-                filter = &g_xma_singleton->filtercfg[kernel->plugin_handle];
-                str_cmp2 = strcmp(kernel->function, XMA_CFG_FUNC_NM_FILTER);
-                type_cmp = filter->hwfilter_type ==
-                           kern_props->kernel_spec.filter_type ? true : false;
-                plugin_alloc_chan = filter->alloc_chan;
-                kernel_data_size = 0;
-            } else if (type == xma_res_kernel) {
-                kernplg = &g_xma_singleton->kernelcfg[kernel->plugin_handle];
-                str_cmp2 = strcmp(kernel->function, XMA_CFG_FUNC_NM_KERNEL);
-                type_cmp = kernplg->hwkernel_type ==
-                           kern_props->kernel_spec.kernel_type ? true : false;
-                kernel_data_size = 0;
-            }
+    cand_cnt = xma_res_find_kernels(xma_shm, kern_props, type, cands);
+    qsort(cands, cand_cnt, sizeof(XmaKernCandidate), xma_res_cmp_kern_load);
 
-            if (str_cmp1 == 0 && str_cmp2 == 0 && type_cmp) {
-                /* register client thread id with kernel */
-                    ret = xma_client_thread_kernel_alloc(shm_cfg, dev, kern_idx,
-                                                         session,
-                                                         kernel_data_size,
-                                                         plugin_alloc_chan);
-                    if (ret)
-                        continue;
-
-                    kern_props->dev_handle = dev_id;
-                    kern_props->kern_handle = kern_idx;
-                    kern_props->plugin_handle = kernel->plugin_handle;
-                    kern_props->session = session;
-                    kern_aquired = true;
-            }
-        }
+    for (i = 0; i < cand_cnt && !kern_aquired; i++)
+    {
+        XmaDevice *dev = &xma_shm->sys_res.devices[cands[i].dev_id];
+        int32_t dev_id = cands[i].dev_id;
+        int32_t kern_idx = cands[i].kern_idx;
+        int kern_id = dev->kernels[kern_idx].kernel_id;
+        bool dev_registered = xma_dev_has_client(dev, proc_id);
+        int ret;
 
-        if (!kern_aquired) {
-            xma_logmsg(XMA_DEBUG_LOG, XMA_RES_MOD,
-                       "%s() Unable to locate requested %s kernel type\n",
-                        __func__,
-                        kern_props->kernel_spec.scal_type ? "scaler" :
-                        kern_props->kernel_spec.enc_type ? "encoder" :
-                        kern_props->kernel_spec.dec_type ? "decoder" :
-                        kern_props->kernel_spec.filter_type ? "filter" :
-                        "kernel"
-                        );
-            xma_logmsg(XMA_DEBUG_LOG, XMA_RES_MOD,
-                       "%s() from vendor %s on device %d\n",
-                        __func__, kern_props->vendor, dev_id);
-            ret = xma_free_dev(xma_shm, dev_id, proc_id);
-        }
+        ret = xma_alloc_dev(xma_shm, dev_id, kern_props->dev_excl);
+        if (ret)
+            continue;
 
-        if (ret < 0) {
-            return XMA_ERROR;
+        /* register client thread id with kernel */
+        ret = xma_client_thread_kernel_alloc(dev, kern_idx, session,
+                                             session_load,
+                                             cands[i].kernel_data_size,
+                                             cands[i].alloc_chan);
+        if (ret) {
+            if (!dev_registered)
+                xma_free_dev(xma_shm, dev_id, proc_id);
+            continue;
         }
+
+        xma_logmsg(XMA_DEBUG_LOG, XMA_RES_MOD,
+                   "%s() Placed session on device %d kernel %d (load %" PRIu64 ")\n",
+                   __func__, dev_id, kern_idx, cands[i].session_load);
+        kern_props->dev_handle = dev_id;
+        kern_props->kern_handle = kern_idx;
+        kern_props->plugin_handle = xma_shm->sys_res.images[dev->image_id]
+                                        .kernels[kern_id].plugin_handle;
+        kern_props->session = session;
+        kern_aquired = true;
     }
+    xma_shm_unlock(xma_shm);
+
     if (kern_aquired) {
         session->kern_res = (XmaKernelRes)kern_props;
         return XMA_SUCCESS;
@@ -969,10 +1026,207 @@ static int32_t xma_res_alloc_kernel(XmaResources shm_cfg,
 
 }
 
-static int32_t xma_client_thread_kernel_alloc(XmaResources shm_cfg,
-                                              XmaDevice *dev,
+static bool xma_res_kern_match(XmaKernel *kernel,
+                               XmaKernReq *kern_props,
+                               enum XmaKernType type,
+                               size_t *kernel_data_size,
+                               int32_t (**alloc_chan)(XmaSession *p,
+                                                      XmaSession **s,
+                                                      uint32_t cnt))
+{
+    extern XmaSingleton *g_xma_singleton;
+    int str_cmp1 = -1, str_cmp2 = -1, type_cmp = false;
+    XmaScalerPlugin *scaler;
+    XmaDecoderPlugin *decoder;
+    XmaEncoderPlugin *encoder;
+    XmaFilterPlugin *filter;
+    XmaKernelPlugin *kernplg;
+
+    *alloc_chan = NULL;
+    *kernel_data_size = 0;
+
+    str_cmp1 = strcmp(kernel->vendor, kern_props->vendor);
+    if (type == xma_res_scaler) {
+        scaler = &g_xma_singleton->scalercfg[kernel->plugin_handle];
+        str_cmp2 = strcmp(kernel->function, XMA_CFG_FUNC_NM_SCALE);
+        type_cmp = scaler->hwscaler_type ==
+                   kern_props->kernel_spec.scal_type ? true : false;
+        *alloc_chan = scaler->alloc_chan;
+    } else if (type == xma_res_encoder) {
+        encoder = &g_xma_singleton->encodercfg[kernel->plugin_handle];
+        str_cmp2 = strcmp(kernel->function, XMA_CFG_FUNC_NM_ENC);
+        type_cmp = encoder->hwencoder_type ==
+                   kern_props->kernel_spec.enc_type ? true : false;
+        *alloc_chan = encoder->alloc_chan;
+        *kernel_data_size = encoder->kernel_data_size;
+    } else if (type == xma_res_decoder) {
+        decoder = &g_xma_singleton->decodercfg[kernel->plugin_handle];
+        str_cmp2 = strcmp(kernel->function, XMA_CFG_FUNC_NM_DEC);
+        type_cmp = decoder->hwdecoder_type ==
+                   kern_props->kernel_spec.dec_type ? true : false;
+    } else if (type == xma_res_filter) {
+        filter = &g_xma_singleton->filtercfg[kernel->plugin_handle];
+        str_cmp2 = strcmp(kernel->function, XMA_CFG_FUNC_NM_FILTER);
+        type_cmp = filter->hwfilter_type ==
+                   kern_props->kernel_spec.filter_type ? true : false;
+        *alloc_chan = filter->alloc_chan;
+    } else if (type == xma_res_kernel) {
+        kernplg = &g_xma_singleton->kernelcfg[kernel->plugin_handle];
+        str_cmp2 = strcmp(kernel->function, XMA_CFG_FUNC_NM_KERNEL);
+        type_cmp = kernplg->hwkernel_type ==
+                   kern_props->kernel_spec.kernel_type ? true : false;
+    }
+
+    return str_cmp1 == 0 && str_cmp2 == 0 && type_cmp;
+}
+
+/* Collect every instance of the requested kernel that could take another
+ * session from this process. Must be called with the shm lock held.
+*/
+static int xma_res_find_kernels(XmaResConfig *xma_shm,
+                                XmaKernReq *kern_props,
+                                enum XmaKernType type,
+                                XmaKernCandidate *cands)
+{
+    pid_t proc_id = getpid();
+    int dev_id, kern_idx, cand_cnt = 0;
+
+    for (dev_id = -1; xma_get_next_free_dev(xma_shm, &dev_id) == XMA_SUCCESS;)
+    {
+        XmaDevice *dev = &xma_shm->sys_res.devices[dev_id];
+
+        for (kern_idx = 0;
+             kern_idx < MAX_KERNEL_CONFIGS && kern_idx < dev->kernel_cnt;
+             kern_idx++)
+        {
+            XmaKernelInstance *kernel_inst = &dev->kernels[kern_idx];
+            XmaKernel *kernel = &xma_shm->sys_res.images[dev->image_id]
+                                    .kernels[kernel_inst->kernel_id];
+            XmaKernCandidate *cand = &cands[cand_cnt];
+
+            if (!xma_res_kern_match(kernel, kern_props, type,
+                                    &cand->kernel_data_size,
+                                    &cand->alloc_chan))
+                continue;
+
+            /* some other process has this kernel */
+            if (kernel_inst->client_id && kernel_inst->client_id != proc_id)
+                continue;
+
+            /* in-use and either no channels or all channels taken */
+            if (kernel_inst->load.chan_cnt &&
+                (!cand->alloc_chan ||
+                 kernel_inst->load.chan_cnt >= MAX_KERNEL_CHANS))
+                continue;
+
+            xma_res_kern_load_decay(&kernel_inst->load);
+            cand->dev_id = dev_id;
+            cand->kern_idx = kern_idx;
+            cand->session_load = kernel_inst->load.session_load;
+            cand->chan_cnt = kernel_inst->load.chan_cnt;
+            cand->recent_allocs = kernel_inst->load.recent_allocs;
+            cand_cnt++;
+        }
+    }
+
+    if (!cand_cnt) {
+        xma_logmsg(XMA_DEBUG_LOG, XMA_RES_MOD,
+                   "%s() Unable to locate requested %s kernel type\n",
+                    __func__,
+                    kern_props->kernel_spec.scal_type ? "scaler" :
+                    kern_props->kernel_spec.enc_type ? "encoder" :
+                    kern_props->kernel_spec.dec_type ? "decoder" :
+                    kern_props->kernel_spec.filter_type ? "filter" :
+                    "kernel"
+                    );
+        xma_logmsg(XMA_DEBUG_LOG, XMA_RES_MOD,
+                   "%s() from vendor %s\n", __func__, kern_props->vendor);
+    }
+    return cand_cnt;
+}
+
+/* Least loaded first; device and kernel index keep the order stable */
+static int xma_res_cmp_kern_load(const void *a, const void *b)
+{
+    const XmaKernCandidate *ca = (const XmaKernCandidate *)a;
+    const XmaKernCandidate *cb = (const XmaKernCandidate *)b;
+
+    if (ca->session_load != cb->session_load)
+        return ca->session_load < cb->session_load ? -1 : 1;
+    if (ca->chan_cnt != cb->chan_cnt)
+        return ca->chan_cnt < cb->chan_cnt ? -1 : 1;
+    if (ca->recent_allocs != cb->recent_allocs)
+        return ca->recent_allocs < cb->recent_allocs ? -1 : 1;
+    if (ca->dev_id != cb->dev_id)
+        return ca->dev_id < cb->dev_id ? -1 : 1;
+    return ca->kern_idx - cb->kern_idx;
+}
+
+/* Declared load of a session in pixels per second, 0 if unknown */
+static uint64_t xma_res_session_load(XmaSession *session)
+{
+    uint64_t pixels = 0;
+    int i;
+
+    if (is_xma_encoder(session)) {
+        XmaEncoderProperties *props = &to_xma_encoder(session)->encoder_props;
+        XmaFraction *fps = &props->framerate;
+
+        if (props->width <= 0 || props->height <= 0)
+            return 0;
+        pixels = (uint64_t)props->width * props->height;
+        if (fps->numerator > 0 && fps->denominator > 0)
+            return pixels * fps->numerator / fps->denominator;
+        return pixels;
+    } else if (is_xma_scaler(session)) {
+        XmaScalerProperties *props = &to_xma_scaler(session)->props;
+
+        if (props->input.width > 0 && props->input.height > 0)
+            pixels = (uint64_t)props->input.width * props->input.height;
+        for (i = 0; i < props->num_outputs && i < MAX_SCALER_OUTPUTS; i++)
+            if (props->output[i].width > 0 && props->output[i].height > 0)
+                pixels += (uint64_t)props->output[i].width *
+                          props->output[i].height;
+        return pixels;
+    } else if (is_xma_filter(session)) {
+        XmaFilterProperties *props = &to_xma_filter(session)->props;
+
+        if (props->input.width > 0 && props->input.height > 0)
+            pixels = (uint64_t)props->input.width * props->input.height;
+        return pixels;
+    }
+    return 0;
+}
+
+static void xma_res_kern_load_decay(XmaKernelLoad *load)
+{
+    struct timespec now;
+    int64_t elapsed;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed = now.tv_sec - load->last_decay;
+    if (elapsed <= 0)
+        return;
+
+    load->recent_allocs = elapsed < 32 ? load->recent_allocs >> elapsed : 0;
+    load->last_decay = now.tv_sec;
+}
+
+static bool xma_dev_has_client(XmaDevice *dev, pid_t proc_id)
+{
+    int pid_idx;
+
+    for (pid_idx = 0; pid_idx < MAX_KERNEL_CONFIGS; pid_idx++)
+        if (dev->client_procs[pid_idx] == proc_id)
+            return true;
+    return false;
+}
+
+/* Must be called with the shm lock held */
+static int32_t xma_client_thread_kernel_alloc(XmaDevice *dev,
                                               int dev_kern_idx,
                                               XmaSession *session,
+                                              uint64_t session_load,
                                               size_t kernel_data_size,
                                               int32_t (*alloc_chan)
                                                             (XmaSession *p,
@@ -980,24 +1234,16 @@ static int32_t xma_client_thread_kernel_alloc(XmaResources shm_cfg,
                                                              uint32_t sess_cnt))
 {
     XmaKernelInstance *kernel_inst = &dev->kernels[dev_kern_idx];
-    XmaResConfig *xma_shm = (XmaResConfig *)shm_cfg;
     XmaSession *sessions[MAX_KERNEL_CHANS];
     pthread_t thread_id = pthread_self();
     pid_t proc_id = getpid();
     int j, ret;
 
     xma_logmsg(XMA_DEBUG_LOG, XMA_RES_MOD, "%s()\n", __func__);
-    if (xma_shm_lock(xma_shm))
-        return XMA_ERROR;
-
-    if (kernel_inst->client_id && kernel_inst->client_id != proc_id) {
-        xma_shm_unlock(xma_shm);
+    if (kernel_inst->client_id && kernel_inst->client_id != proc_id)
         return XMA_ERROR_NO_KERNEL; /* some other process has this kernel */
-    }
-
-    kernel_inst->client_id = proc_id;
 
-    for (j = 0; kernel_inst->channels[j].thread_id && j < MAX_KERNEL_CHANS; j++)
+    for (j = 0; j < MAX_KERNEL_CHANS && kernel_inst->channels[j].thread_id; j++)
         sessions[j] = kernel_inst->channels[j].session;
 
     if (!j) { /* unused kernel */
@@ -1011,18 +1257,17 @@ static int32_t xma_client_thread_kernel_alloc(XmaResources shm_cfg,
             if (ret) {
                 xma_logmsg(XMA_DEBUG_LOG, XMA_RES_MOD,
                            "%s() Channel request rejected\n", __func__);
-                xma_shm_unlock(xma_shm);
+                if (kernel_data_size > 0) {
+                    free(session->kernel_data);
+                    session->kernel_data = NULL;
+                }
                 return ret;
             }
         }
-        kernel_inst->channels[j].session = session;
-        kernel_inst->channels[j].thread_id = thread_id;
         session->chan_id = session->chan_id >= 0 ? session->chan_id : 0;
         xma_logmsg(XMA_DEBUG_LOG, XMA_RES_MOD,
                    "%s() Kernel aquired. Channel id %d\n",
                    __func__, session->chan_id);
-        xma_shm_unlock(xma_shm);
-        return XMA_SUCCESS;
     } else if (j && j < MAX_KERNEL_CHANS && alloc_chan) {
         /* verify it can support another request */
         xma_logmsg(XMA_DEBUG_LOG, XMA_RES_MOD,
@@ -1031,23 +1276,25 @@ static int32_t xma_client_thread_kernel_alloc(XmaResources shm_cfg,
         if (kernel_data_size > 0)
             session->kernel_data = sessions[0]->kernel_data;
         ret = alloc_chan(session, sessions, j);
-        if (ret) {
-            xma_shm_unlock(xma_shm);
+        if (ret)
             return ret;
-        }
-        kernel_inst->channels[j].session = session;
-        kernel_inst->channels[j].thread_id = thread_id;
-        xma_shm_unlock(xma_shm);
-        return XMA_SUCCESS;
     } else if (j && !alloc_chan) {
         /* kernel is in-use and doesn't support channels */
         xma_logmsg(XMA_DEBUG_LOG, XMA_RES_MOD,
                    "%s() All kernel channels in-use \n", __func__);
-        xma_shm_unlock(xma_shm);
         return XMA_ERROR_NO_KERNEL;
+    } else {
+        return XMA_ERROR;
     }
-    xma_shm_unlock(xma_shm);
-    return XMA_ERROR;
+
+    kernel_inst->client_id = proc_id;
+    kernel_inst->channels[j].session = session;
+    kernel_inst->channels[j].thread_id = thread_id;
+    kernel_inst->channels[j].load = session_load;
+    kernel_inst->load.chan_cnt++;
+    kernel_inst->load.session_load += session_load;
+    kernel_inst->load.recent_allocs++;
+    return XMA_SUCCESS;
 }
 
 static int xma_client_thread_kernel_free(XmaDevice *dev,
@@ -1070,8 +1317,12 @@ static int xma_client_thread_kernel_free(XmaDevice *dev,
             continue;
         if (kernel_inst->channels[i].session != session)
             continue;
+        if (kernel_inst->load.chan_cnt)
+            kernel_inst->load.chan_cnt--;
+        kernel_inst->load.session_load -= kernel_inst->channels[i].load;
         kernel_inst->channels[i].thread_id = 0;
         kernel_inst->channels[i].session = NULL;
+        kernel_inst->channels[i].load = 0;
         /* eliminate fragmentation in list of used channels after free */
         for (; i < MAX_KERNEL_CHANS-1 &&
                kernel_inst->channels[i+1].thread_id &&
@@ -1080,12 +1331,14 @@ static int xma_client_thread_kernel_free(XmaDevice *dev,
                                      kernel_inst->channels[i+1].thread_id;
             kernel_inst->channels[i].session =
                                      kernel_inst->channels[i+1].session;
+            kernel_inst->channels[i].load = kernel_inst->channels[i+1].load;
         }
         last_used_chan = !i ? true : false;
         /* ensure last entry is cleared if not otherwise */
         if (!last_used_chan) {
             kernel_inst->channels[i].thread_id = 0;
             kernel_inst->channels[i].session = NULL;
+            kernel_inst->channels[i].load = 0;
             return XMA_SUCCESS;
         } else {
             kernel_inst->client_id = 0;
@@ -1162,7 +1415,10 @@ static void xma_free_all_kernel_chan_res(XmaDevice *dev, pid_t proc_id)
         {
             kernel->channels[j].thread_id = 0;
             kernel->channels[j].session = NULL;
+            kernel->channels[j].load = 0;
         }
+        kernel->load.chan_cnt = 0;
+        kernel->load.session_load = 0;
     }
 }
 
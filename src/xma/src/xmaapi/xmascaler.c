@@ -297,6 +297,9 @@ xma_scaler_session_destroy(XmaScalerSession *session)
     int32_t rc, i;
 
     xma_logmsg(XMA_DEBUG_LOG, XMA_SCALER_MOD, "%s()\n", __func__);
+    // Let queued asynchronous requests finish before closing the plugin
+    xma_async_destroy(session->base.async);
+
     rc  = session->scaler_plugin->close(session);
     if (rc != 0)
         xma_logmsg(XMA_ERROR_LOG, XMA_SCALER_MOD,
@@ -305,6 +308,9 @@ xma_scaler_session_destroy(XmaScalerSession *session)
     // Clean up the private data
     free(session->base.plugin_data);
 
+    // Release the device buffers behind frames of this session
+    xma_plg_buffer_pool_destroy(session->base.frame_pool);
+
     // Free each sender connection
     for (i = 0; i < session->props.num_outputs; i++)
         xma_connect_free(session->conn_send_handles[i], XMA_CONNECT_SENDER);
@@ -332,23 +338,24 @@ int32_t
 xma_scaler_session_send_frame(XmaScalerSession  *session,
                               XmaFrame          *frame)
 {
-    int32_t i;
+    XmaSession *recvs[MAX_SCALER_OUTPUTS] = {NULL};
+    int32_t i, rc;
 
     xma_logmsg(XMA_DEBUG_LOG, XMA_SCALER_MOD, "%s()\n", __func__);
     for (i = 0; i < session->props.num_outputs; i++)
     {
         if (session->conn_send_handles[i] != -1)
         {
-            // Get the connection entry to find the receiver
-            int32_t c_handle = session->conn_send_handles[i];
-            XmaConnect *conn = &g_xma_singleton->connections[c_handle];
-            XmaEndpoint *recv = conn->receiver;
+            // Get the connection entry to find the receiver, which is
+            // held until the frame has been sent
+            XmaSession *recv =
+                xma_connect_receiver_get(session->conn_send_handles[i]);
+            recvs[i] = recv;
             if (recv)
             {
-                if (is_xma_encoder(recv->session))
+                if (is_xma_encoder(recv))
                 {
-                    XmaEncoderSession *e_ses =
-                        to_xma_encoder(recv->session);
+                    XmaEncoderSession *e_ses = to_xma_encoder(recv);
                     if (!e_ses->encoder_plugin->get_dev_input_paddr) {
                         xma_logmsg(XMA_DEBUG_LOG, XMA_SCALER_MOD,
                             "encoder plugin does not support zero copy\n");
@@ -362,7 +369,13 @@ xma_scaler_session_send_frame(XmaScalerSession  *session,
         }
     }
 
-    return session->scaler_plugin->send_frame(session, frame);
+    rc = session->scaler_plugin->send_frame(session, frame);
+
+    for (i = 0; i < session->props.num_outputs; i++)
+        if (recvs[i])
+            xma_connect_receiver_put(session->conn_send_handles[i]);
+
+    return rc;
 }
 
 int32_t
@@ -373,3 +386,11 @@ xma_scaler_session_recv_frame_list(XmaScalerSession  *session,
     return session->scaler_plugin->recv_frame_list(session,
                                                    frame_list);
 }
+
+XmaFrame*
+xma_scaler_session_frame_alloc(XmaScalerSession   *session,
+                               XmaFrameProperties *frame_props)
+{
+    xma_logmsg(XMA_DEBUG_LOG, XMA_SCALER_MOD, "%s()\n", __func__);
+    return xma_frame_session_alloc(&session->base, frame_props);
+}
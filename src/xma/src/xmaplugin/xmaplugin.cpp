@@ -15,9 +15,30 @@
  * under the License.
  */
 #include <stdio.h>
+#include <sys/mman.h>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include "xclhal2.h"
 #include "xmaplugin.h"
 
+static const XmaBufferHandle xma_plg_null_bo = 0xffffffff;
+
+/*
+ * Mapped device buffers of one size on one DDR bank. Free buffers stay
+ * mapped so that reuse costs a vector pop; the pool is freed by whichever
+ * of destroy or the last outstanding free comes last.
+ */
+struct XmaBufferPool
+{
+    XmaHwSession s_handle;
+    size_t size;
+    std::mutex lock;
+    std::vector<std::pair<XmaBufferHandle, void*>> free_bufs;
+    std::unordered_map<XmaBufferHandle, void*> used_bufs;
+    bool closing;
+};
+
 XmaBufferHandle
 xma_plg_buffer_alloc(XmaHwSession s_handle, size_t size)
 {
@@ -117,6 +138,212 @@ xma_plg_buffer_read(XmaHwSession s_handle,
     return rc;
 }
 
+int32_t
+xma_plg_buffer_sync_to_device(XmaHwSession     s_handle,
+                              XmaBufferHandle  b_handle,
+                              size_t           size,
+                              size_t           offset)
+{
+    int32_t rc;
+    xclDeviceHandle dev_handle = s_handle.dev_handle;
+
+    rc = xclSyncBO(dev_handle, b_handle, XCL_BO_SYNC_BO_TO_DEVICE, size, offset);
+    if (rc != 0)
+        printf("xclSyncBO failed %d\n", rc);
+
+    return rc;
+}
+
+int32_t
+xma_plg_buffer_sync_from_device(XmaHwSession     s_handle,
+                                XmaBufferHandle  b_handle,
+                                size_t           size,
+                                size_t           offset)
+{
+    int32_t rc;
+    xclDeviceHandle dev_handle = s_handle.dev_handle;
+
+    rc = xclSyncBO(dev_handle, b_handle, XCL_BO_SYNC_BO_FROM_DEVICE, size, offset);
+    if (rc != 0)
+        printf("xclSyncBO failed %d\n", rc);
+
+    return rc;
+}
+
+static void
+xma_plg_buffer_pool_release(XmaBufferPool *pool, XmaBufferHandle b_handle,
+                            void *vaddr)
+{
+    munmap(vaddr, pool->size);
+    xclFreeBO(pool->s_handle.dev_handle, b_handle);
+}
+
+XmaBufferPool*
+xma_plg_buffer_pool_create(XmaHwSession s_handle, size_t size)
+{
+    if (!size)
+        return NULL;
+
+    XmaBufferPool *pool = new XmaBufferPool;
+    pool->s_handle = s_handle;
+    pool->size = size;
+    pool->closing = false;
+    return pool;
+}
+
+int32_t
+xma_plg_buffer_pool_alloc(XmaBufferPool   *pool,
+                          XmaBufferHandle *b_handle,
+                          void           **vaddr)
+{
+    {
+        std::lock_guard<std::mutex> lk(pool->lock);
+        if (!pool->free_bufs.empty()) {
+            *b_handle = pool->free_bufs.back().first;
+            *vaddr = pool->free_bufs.back().second;
+            pool->free_bufs.pop_back();
+            pool->used_bufs[*b_handle] = *vaddr;
+            return XMA_SUCCESS;
+        }
+    }
+
+    XmaBufferHandle handle = xma_plg_buffer_alloc(pool->s_handle, pool->size);
+    if (handle == xma_plg_null_bo)
+        return XMA_ERROR;
+
+    void *ptr = xclMapBO(pool->s_handle.dev_handle, handle, true);
+    if (!ptr || ptr == MAP_FAILED) {
+        printf("xclMapBO failed\n");
+        xma_plg_buffer_free(pool->s_handle, handle);
+        return XMA_ERROR;
+    }
+
+    std::lock_guard<std::mutex> lk(pool->lock);
+    pool->used_bufs[handle] = ptr;
+    *b_handle = handle;
+    *vaddr = ptr;
+    return XMA_SUCCESS;
+}
+
+void
+xma_plg_buffer_pool_free(XmaBufferPool *pool, XmaBufferHandle b_handle)
+{
+    bool last;
+
+    {
+        std::lock_guard<std::mutex> lk(pool->lock);
+        auto itr = pool->used_bufs.find(b_handle);
+        if (itr == pool->used_bufs.end())
+            return;
+        if (!pool->closing) {
+            pool->free_bufs.emplace_back(b_handle, itr->second);
+            pool->used_bufs.erase(itr);
+            return;
+        }
+        xma_plg_buffer_pool_release(pool, b_handle, itr->second);
+        pool->used_bufs.erase(itr);
+        last = pool->used_bufs.empty();
+    }
+
+    if (last)
+        delete pool;
+}
+
+size_t
+xma_plg_buffer_pool_size(XmaBufferPool *pool)
+{
+    return pool->size;
+}
+
+void
+xma_plg_buffer_pool_destroy(XmaBufferPool *pool)
+{
+    bool last;
+
+    if (!pool)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lk(pool->lock);
+        pool->closing = true;
+        for (auto& buf : pool->free_bufs)
+            xma_plg_buffer_pool_release(pool, buf.first, buf.second);
+        pool->free_bufs.clear();
+        last = pool->used_bufs.empty();
+    }
+
+    if (last)
+        delete pool;
+}
+
+static bool
+xma_plg_frame_is_local(XmaHwSession s_handle, XmaFrame *frame)
+{
+    XmaBufferPool *pool = (XmaBufferPool*)frame->data[0].pool;
+
+    return frame->data[0].buffer_type == XMA_DEVICE_BUFFER_TYPE && pool &&
+           pool->s_handle.dev_handle == s_handle.dev_handle;
+}
+
+int32_t
+xma_plg_frame_sync_to_device(XmaHwSession s_handle, XmaFrame *frame)
+{
+    XmaBufferPool *pool = (XmaBufferPool*)frame->data[0].pool;
+
+    if (!xma_plg_frame_is_local(s_handle, frame)) {
+        // Crossing devices goes through the host planes
+        if (xma_plg_frame_sync_to_host(frame))
+            return XMA_ERROR;
+        return XMA_ERROR_INVALID;
+    }
+
+    if (frame->data[0].device_resident)
+        return XMA_SUCCESS;
+
+    return xma_plg_buffer_sync_to_device(s_handle, frame->data[0].bo_handle,
+                                         pool->size, 0);
+}
+
+int32_t
+xma_plg_frame_get_paddr(XmaHwSession  s_handle,
+                        XmaFrame     *frame,
+                        uint64_t     *paddr)
+{
+    if (!xma_plg_frame_is_local(s_handle, frame))
+        return XMA_ERROR_INVALID;
+
+    *paddr = xma_plg_get_paddr(s_handle, frame->data[0].bo_handle);
+    return XMA_SUCCESS;
+}
+
+void
+xma_plg_frame_device_written(XmaFrame *frame)
+{
+    for (int32_t i = 0; i < XMA_MAX_PLANES; i++)
+        frame->data[i].device_resident = (frame->data[i].pool != NULL);
+}
+
+int32_t
+xma_plg_frame_sync_to_host(XmaFrame *frame)
+{
+    XmaBufferPool *pool = (XmaBufferPool*)frame->data[0].pool;
+    int32_t rc;
+
+    if (!pool || !frame->data[0].device_resident)
+        return XMA_SUCCESS;
+
+    rc = xma_plg_buffer_sync_from_device(pool->s_handle,
+                                         frame->data[0].bo_handle,
+                                         pool->size, 0);
+    if (rc != 0)
+        return XMA_ERROR;
+
+    for (int32_t i = 0; i < XMA_MAX_PLANES; i++)
+        frame->data[i].device_resident = false;
+
+    return XMA_SUCCESS;
+}
+
 int32_t
 xma_plg_register_write(XmaHwSession  s_handle,
                        void         *src,
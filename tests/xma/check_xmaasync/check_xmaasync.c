@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2018, Xilinx Inc - All rights reserved
+ * Xilinx SDAccel Media Accelerator API
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Synchronous versus asynchronous encoder session throughput.
+ *
+ * A dummy encoder plugin models one kernel: send_frame() spends
+ * BENCH_DMA_US on DMA in and starts the kernel, which runs BENCH_KERNEL_US
+ * per frame, one frame at a time; recv_data() waits for the kernel and
+ * spends BENCH_DMA_US on DMA out.  BENCH_FRAMES frames are encoded with
+ * plain send/recv calls and then through the asynchronous interface for
+ * each depth in bench_depths.  The session is built directly around the
+ * plugin, so no device, xclbin or configuration file is needed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "xma.h"
+#include "xmaplugin.h"
+#include "lib/xmaapi.h"
+
+#define BENCH_FRAMES     200
+#define BENCH_DMA_US     500
+#define BENCH_KERNEL_US 1000
+#define BENCH_MAX_DEPTH    8
+/* fail unless depth 2 or more beats synchronous calls by this factor */
+#define BENCH_MIN_SPEEDUP 1.3
+
+extern XmaSingleton *g_xma_singleton;
+
+static const int32_t bench_depths[] = { 1, 2, 4, BENCH_MAX_DEPTH };
+
+typedef struct BenchKernel
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  queued;
+    double          busy_until;
+    double          done_at[BENCH_FRAMES];
+    int32_t         sent;
+    int32_t         received;
+} BenchKernel;
+
+static double bench_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1.0e6 + ts.tv_nsec / 1.0e3;
+}
+
+static void bench_sleep_until(double t_us)
+{
+    double now = bench_now_us();
+    struct timespec ts;
+
+    if (t_us <= now)
+        return;
+    ts.tv_sec = (time_t)((t_us - now) / 1.0e6);
+    ts.tv_nsec = (long)((t_us - now) * 1.0e3) % 1000000000L;
+    nanosleep(&ts, NULL);
+}
+
+static int32_t bench_init(XmaEncoderSession *sess)
+{
+    BenchKernel *kern = sess->base.plugin_data;
+
+    memset(kern, 0, sizeof(*kern));
+    pthread_mutex_init(&kern->lock, NULL);
+    pthread_cond_init(&kern->queued, NULL);
+    return 0;
+}
+
+static int32_t bench_send(XmaEncoderSession *sess, XmaFrame *frame)
+{
+    BenchKernel *kern = sess->base.plugin_data;
+    double start;
+
+    bench_sleep_until(bench_now_us() + BENCH_DMA_US);
+
+    pthread_mutex_lock(&kern->lock);
+    start = bench_now_us();
+    if (kern->busy_until > start)
+        start = kern->busy_until;
+    kern->busy_until = start + BENCH_KERNEL_US;
+    kern->done_at[kern->sent++] = kern->busy_until;
+    pthread_cond_broadcast(&kern->queued);
+    pthread_mutex_unlock(&kern->lock);
+
+    return XMA_SUCCESS;
+}
+
+static int32_t bench_recv(XmaEncoderSession *sess, XmaDataBuffer *data,
+                          int32_t *data_size)
+{
+    BenchKernel *kern = sess->base.plugin_data;
+    double done;
+
+    pthread_mutex_lock(&kern->lock);
+    while (kern->received == kern->sent)
+        pthread_cond_wait(&kern->queued, &kern->lock);
+    done = kern->done_at[kern->received++];
+    pthread_mutex_unlock(&kern->lock);
+
+    bench_sleep_until(done);
+    bench_sleep_until(bench_now_us() + BENCH_DMA_US);
+    *data_size = data->alloc_size;
+
+    return XMA_SUCCESS;
+}
+
+static int32_t bench_close(XmaEncoderSession *sess)
+{
+    return 0;
+}
+
+static XmaEncoderPlugin bench_plugin = {
+    .hwencoder_type = XMA_COPY_ENCODER_TYPE,
+    .hwvendor_string = "Xilinx",
+    .plugin_data_size = sizeof(BenchKernel),
+    .init = bench_init,
+    .send_frame = bench_send,
+    .recv_data = bench_recv,
+    .close = bench_close,
+};
+
+static void bench_open(XmaEncoderSession *sess)
+{
+    memset(sess, 0, sizeof(*sess));
+    sess->base.session_type = XMA_ENCODER;
+    sess->base.chan_id = -1;
+    sess->conn_recv_handle = -1;
+    sess->encoder_plugin = &bench_plugin;
+    sess->base.plugin_data = malloc(bench_plugin.plugin_data_size);
+    bench_plugin.init(sess);
+}
+
+static void bench_close_session(XmaEncoderSession *sess)
+{
+    xma_async_destroy(sess->base.async);
+    free(sess->base.plugin_data);
+}
+
+static double bench_sync(XmaFrame *frame, XmaDataBuffer *data)
+{
+    XmaEncoderSession sess;
+    int32_t size;
+    double start;
+    int i;
+
+    bench_open(&sess);
+    start = bench_now_us();
+    for (i = 0; i < BENCH_FRAMES; i++) {
+        xma_enc_session_send_frame(&sess, frame);
+        xma_enc_session_recv_data(&sess, data, &size);
+    }
+    start = bench_now_us() - start;
+    bench_close_session(&sess);
+
+    return start / BENCH_FRAMES;
+}
+
+static double bench_async(int32_t depth, XmaFrame *frame,
+                          XmaDataBuffer *data, int *errors)
+{
+    XmaAsyncToken send_tok[BENCH_MAX_DEPTH], recv_tok[BENCH_MAX_DEPTH];
+    int32_t size[BENCH_MAX_DEPTH];
+    XmaEncoderSession sess;
+    double start;
+    int i;
+
+    bench_open(&sess);
+    if (xma_enc_session_async_enable(&sess, depth) != XMA_SUCCESS) {
+        printf("ERROR: async enable failed for depth %d\n", depth);
+        (*errors)++;
+        bench_close_session(&sess);
+        return 0.0;
+    }
+
+    start = bench_now_us();
+    for (i = 0; i < BENCH_FRAMES + depth; i++) {
+        int slot = i % depth;
+
+        if (i >= depth) {
+            if (xma_async_wait(&send_tok[slot]) != XMA_SUCCESS ||
+                xma_async_wait(&recv_tok[slot]) != XMA_SUCCESS ||
+                size[slot] != data->alloc_size)
+                (*errors)++;
+        }
+        if (i >= BENCH_FRAMES)
+            continue;
+        xma_enc_session_send_frame_async(&sess, frame, &send_tok[slot]);
+        xma_enc_session_recv_data_async(&sess, data, &size[slot],
+                                        &recv_tok[slot]);
+    }
+    start = bench_now_us() - start;
+    bench_close_session(&sess);
+
+    return start / BENCH_FRAMES;
+}
+
+int main()
+{
+    XmaFrameProperties fprops = { XMA_YUV420_FMT_TYPE, 64, 64, 8 };
+    XmaFrame *frame;
+    XmaDataBuffer *data;
+    double sync_us, async_us;
+    int number_failed = 0;
+    size_t i;
+
+    g_xma_singleton = calloc(1, sizeof(*g_xma_singleton));
+    frame = xma_frame_alloc(&fprops);
+    data = xma_data_buffer_alloc(4096);
+
+    sync_us = bench_sync(frame, data);
+    printf("sync:          %7.1f us per frame\n", sync_us);
+
+    for (i = 0; i < sizeof(bench_depths) / sizeof(bench_depths[0]); i++) {
+        async_us = bench_async(bench_depths[i], frame, data, &number_failed);
+        printf("async depth %d: %7.1f us per frame, %.2fx\n",
+               bench_depths[i], async_us, sync_us / async_us);
+        if (bench_depths[i] >= 2 && sync_us / async_us < BENCH_MIN_SPEEDUP) {
+            printf("ERROR: depth %d does not overlap transfers and kernel\n",
+                   bench_depths[i]);
+            number_failed++;
+        }
+    }
+
+    xma_frame_free(frame);
+    xma_data_buffer_free(data);
+
+    if (number_failed == 0) {
+     printf("XMA check_xmaasync test completed successfully\n");
+     return EXIT_SUCCESS;
+    } else {
+     printf("ERROR: XMA check_xmaasync test failed, %d errors\n",
+            number_failed);
+     return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2018, Xilinx Inc - All rights reserved
+ * Xilinx SDAccel Media Accelerator API
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Kernel placement simulation for the XMA resource manager.
+ *
+ * A fake device table (SIM_DEVICES cards, each with SIM_INSTANCES encoder
+ * instances accepting up to SIM_CHANNELS channels) is loaded straight into
+ * the shared memory database, without an xclbin or a plugin library.
+ * Encoder sessions of mixed resolutions are opened until the table is
+ * SIM_FILL percent full, then SIM_CHURN random close/open cycles are run.
+ * The declared load (pixels per second) carried by every card is reported
+ * together with the average placement time.
+ *
+ * Runs against a private database file, so it neither disturbs nor is
+ * disturbed by XMA applications.  Needs an XMA_RES_TEST build of xmaapi,
+ * where the database file names are variables.
+ */
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "xma.h"
+#include "xmaplugin.h"
+#include "lib/xmaapi.h"
+#include "lib/xmares.h"
+
+#define SIM_DEVICES    4
+#define SIM_INSTANCES  2
+#define SIM_CHANNELS   8
+#define SIM_FILL      50
+#define SIM_CHURN  20000
+/* fail if the busiest card carries more than this times the idlest one */
+#define SIM_MAX_IMBALANCE 2.0
+#define SIM_SESSIONS  (SIM_DEVICES * SIM_INSTANCES * SIM_CHANNELS)
+
+extern XmaSingleton *g_xma_singleton;
+
+static const struct {
+    int32_t width;
+    int32_t height;
+    int32_t fps;
+} sim_formats[] = {
+    { 1280,  720, 30 },
+    { 1920, 1080, 30 },
+    { 1920, 1080, 60 },
+    { 3840, 2160, 30 },
+};
+
+static int32_t sim_alloc_chan(XmaSession *pending, XmaSession **curr_sess,
+                              uint32_t sess_cnt)
+{
+    if (sess_cnt >= SIM_CHANNELS)
+        return XMA_ERROR_NO_KERNEL;
+    pending->chan_id = sess_cnt;
+    return XMA_SUCCESS;
+}
+
+static void sim_cfg_init(XmaSystemCfg *cfg)
+{
+    XmaImageCfg *image = &cfg->imagecfg[0];
+    XmaKernelCfg *kernel = &image->kernelcfg[0];
+    int i;
+
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->num_images = 1;
+    strcpy(image->xclbin, "sim.xclbin");
+    image->num_devices = SIM_DEVICES;
+    for (i = 0; i < SIM_DEVICES; i++)
+        image->device_id_map[i] = i;
+    image->num_kernelcfg_entries = 1;
+    kernel->instances = SIM_INSTANCES;
+    strcpy(kernel->function, XMA_CFG_FUNC_NM_ENC);
+    strcpy(kernel->vendor, "Xilinx");
+    strcpy(kernel->name, "sim_encoder");
+}
+
+static uint64_t sim_load(XmaEncoderSession *sess)
+{
+    XmaEncoderProperties *props = &sess->encoder_props;
+
+    return (uint64_t)props->width * props->height *
+           props->framerate.numerator;
+}
+
+static int sim_open(XmaResources shm, XmaEncoderSession *sess)
+{
+    int fmt = rand() % (sizeof(sim_formats) / sizeof(sim_formats[0]));
+
+    memset(sess, 0, sizeof(*sess));
+    sess->base.session_type = XMA_ENCODER;
+    sess->base.chan_id = -1;
+    sess->encoder_props.hwencoder_type = XMA_COPY_ENCODER_TYPE;
+    strcpy(sess->encoder_props.hwvendor_string, "Xilinx");
+    sess->encoder_props.width = sim_formats[fmt].width;
+    sess->encoder_props.height = sim_formats[fmt].height;
+    sess->encoder_props.framerate.numerator = sim_formats[fmt].fps;
+    sess->encoder_props.framerate.denominator = 1;
+
+    return xma_res_alloc_enc_kernel(shm, XMA_COPY_ENCODER_TYPE, "Xilinx",
+                                    &sess->base, false);
+}
+
+static double sim_report(const char *phase, XmaEncoderSession *sessions,
+                       bool *open)
+{
+    uint64_t dev_load[SIM_DEVICES] = { 0 };
+    uint32_t dev_sess[SIM_DEVICES] = { 0 };
+    uint64_t min_load = UINT64_MAX, max_load = 0;
+    int i;
+
+    for (i = 0; i < SIM_SESSIONS; i++) {
+        int32_t dev;
+
+        if (!open[i])
+            continue;
+        dev = xma_res_dev_handle_get(sessions[i].base.kern_res);
+        dev_load[dev] += sim_load(&sessions[i]);
+        dev_sess[dev]++;
+    }
+
+    printf("%s:\n", phase);
+    for (i = 0; i < SIM_DEVICES; i++) {
+        printf("  device %d: %2u sessions, %6.1f Mpixel/s\n",
+               i, dev_sess[i], dev_load[i] / 1.0e6);
+        if (dev_load[i] < min_load)
+            min_load = dev_load[i];
+        if (dev_load[i] > max_load)
+            max_load = dev_load[i];
+    }
+    if (!min_load) {
+        printf("  max/min device load: idle device\n");
+        return -1.0;
+    }
+    printf("  max/min device load: %.2f\n", (double)max_load / min_load);
+    return (double)max_load / min_load;
+}
+
+static bool sim_balanced(double imbalance)
+{
+    return imbalance >= 0.0 && imbalance <= SIM_MAX_IMBALANCE;
+}
+
+static double sim_elapsed_ns(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1.0e9 +
+           (end->tv_nsec - start->tv_nsec);
+}
+
+int main()
+{
+    static XmaEncoderSession sessions[SIM_SESSIONS];
+    static bool open[SIM_SESSIONS];
+    struct timespec start, end;
+    XmaResources shm;
+    int number_failed = 0;
+    char shm_file[64], shm_file_sig[64];
+    int allocs = 0;
+    int i;
+
+    snprintf(shm_file, sizeof(shm_file), "/tmp/xma_shm_db_load_%d", getpid());
+    snprintf(shm_file_sig, sizeof(shm_file_sig), "/tmp/xma_shm_db_ready_load_%d",
+             getpid());
+    XMA_SHM_FILE = shm_file;
+    XMA_SHM_FILE_SIG = shm_file_sig;
+
+    g_xma_singleton = calloc(1, sizeof(*g_xma_singleton));
+    sim_cfg_init(&g_xma_singleton->systemcfg);
+    g_xma_singleton->encodercfg[0].hwencoder_type = XMA_COPY_ENCODER_TYPE;
+    g_xma_singleton->encodercfg[0].hwvendor_string = "Xilinx";
+    g_xma_singleton->encodercfg[0].alloc_chan = sim_alloc_chan;
+
+    shm = xma_res_shm_map(&g_xma_singleton->systemcfg);
+    if (!shm) {
+        printf("ERROR: unable to map XMA resource database\n");
+        unlink(XMA_SHM_FILE);
+        return EXIT_FAILURE;
+    }
+    g_xma_singleton->shm_res_cfg = shm;
+
+    srand(1);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < SIM_SESSIONS * SIM_FILL / 100; i++) {
+        if (sim_open(shm, &sessions[i]))
+            number_failed++;
+        else
+            open[i] = true;
+        allocs++;
+    }
+    if (!sim_balanced(sim_report("fill", sessions, open)))
+        number_failed++;
+
+    for (i = 0; i < SIM_CHURN; i++) {
+        int victim = rand() % SIM_SESSIONS;
+        int slot;
+
+        /* close a random open session and open one in a free slot */
+        while (!open[victim])
+            victim = (victim + 1) % SIM_SESSIONS;
+        xma_res_free_kernel(shm, sessions[victim].base.kern_res);
+        open[victim] = false;
+
+        slot = rand() % SIM_SESSIONS;
+        while (open[slot])
+            slot = (slot + 1) % SIM_SESSIONS;
+        if (sim_open(shm, &sessions[slot]))
+            number_failed++;
+        else
+            open[slot] = true;
+        allocs++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (!sim_balanced(sim_report("churn", sessions, open)))
+        number_failed++;
+    printf("%d placements, %.0f ns per open/close\n", allocs,
+           sim_elapsed_ns(&start, &end) / allocs);
+
+    for (i = 0; i < SIM_SESSIONS; i++)
+        if (open[i])
+            xma_res_free_kernel(shm, sessions[i].base.kern_res);
+    xma_res_shm_unmap(shm);
+
+    if (number_failed == 0) {
+     printf("XMA check_xmares_load test completed successfully\n");
+     return EXIT_SUCCESS;
+    } else {
+     printf("ERROR: XMA check_xmares_load test failed, %d errors\n",
+            number_failed);
+     return EXIT_FAILURE;
+    }
+}